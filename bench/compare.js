@@ -0,0 +1,47 @@
+#!/usr/bin/env node
+
+'use strict';
+
+// Compares two result files written by bench/index.js.
+//
+// Usage: node bench/compare <baseline.json> <current.json>
+
+const fs = require('fs');
+
+const [baselineFile, currentFile] = process.argv.slice(2);
+if (!baselineFile || !currentFile) {
+  console.error('Usage: node bench/compare <baseline.json> <current.json>');
+  process.exit(1);
+}
+
+const load = file => JSON.parse(fs.readFileSync(file, 'utf8')).results;
+
+const key = result =>
+  `${result.benchmark}/${result.corpus}/${result.implementation}`;
+
+const baseline = new Map();
+for (const result of load(baselineFile)) {
+  baseline.set(key(result), result);
+}
+
+for (const result of load(currentFile)) {
+  const name = key(result);
+  const previous = baseline.get(name);
+  if (!previous) {
+    console.log(`${name}: ${result.opsPerSec} ops/s (new)`);
+    continue;
+  }
+  const change = (result.opsPerSec / previous.opsPerSec - 1) * 100;
+  const sign = change >= 0 ? '+' : '';
+  // The loopback benchmark reports the event loop delay instead of the
+  // latency of an operation.
+  const p99 =
+    result.p99Us === undefined
+      ? `event loop delay p99 ${previous.eventLoopDelayP99Ms} -> ` +
+        `${result.eventLoopDelayP99Ms} ms`
+      : `p99 ${previous.p99Us} -> ${result.p99Us} us`;
+  console.log(
+    `${name}: ${previous.opsPerSec} -> ${result.opsPerSec} ops/s ` +
+      `(${sign}${change.toFixed(1)}%), ${p99}`
+  );
+}
@@ -0,0 +1,134 @@
+'use strict';
+
+const stringify = require('../lib/stringify');
+
+// Deterministic pseudo-random numbers, so that every run measures the same
+// data.
+const createRandom = seed => () => {
+  seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+  return seed / 0x80000000;
+};
+
+const WORDS = [
+  'metarhia',
+  'serialization',
+  "it's",
+  'quoted "text"',
+  'tab\tseparated',
+  'line\nbreak',
+  'кирилиця',
+  'emoji 🚀',
+  'back\\slash',
+  'plain',
+];
+
+const createRpcPackets = random => {
+  const packets = [];
+  for (let i = 0; i < 100; i++) {
+    const id = Math.floor(random() * 1e6);
+    switch (i % 4) {
+      case 0:
+        packets.push({ call: [id, 'auth'], newSession: ['user', 'password'] });
+        break;
+      case 1:
+        packets.push({ callback: [id], ok: [Math.floor(random() * 1e9)] });
+        break;
+      case 2:
+        packets.push({ event: [-id, 'chat'], message: ['hello', id] });
+        break;
+      default:
+        packets.push({ ping: [id] });
+    }
+  }
+  return packets;
+};
+
+const createNumbers = random => {
+  const numbers = [];
+  for (let i = 0; i < 10000; i++) {
+    numbers.push(
+      i % 2 ? Math.floor(random() * 1e6) - 5e5 : (random() - 0.5) * 1e4
+    );
+  }
+  return numbers;
+};
+
+const createStringRecords = random => {
+  const pick = () => WORDS[Math.floor(random() * WORDS.length)];
+  const records = [];
+  for (let i = 0; i < 1000; i++) {
+    records.push({
+      name: `${pick()} ${pick()}`,
+      description: [pick(), pick(), pick(), pick()].join(' '),
+      tags: [pick(), pick()],
+    });
+  }
+  return records;
+};
+
+const createDeepValue = depth => {
+  let value = { leaf: true };
+  for (let i = 0; i < depth; i++) {
+    value = i % 2 ? [i, value] : { level: i, next: value };
+  }
+  return value;
+};
+
+// Configuration file with comments, MDSF only.
+const createConfig = random => {
+  const lines = ['// Generated server configuration', '{'];
+  for (let i = 0; i < 200; i++) {
+    lines.push(
+      `  /* Section ${i}: settings of the service number ${i},`,
+      '     which are documented here at length. */',
+      `  service${i}: {`,
+      `    // Port the service listens on`,
+      `    port: ${8000 + i},`,
+      `    host: 'host${i}.example.com', // Primary host`,
+      `    timeout: ${Math.floor(random() * 1e4)},`,
+      `    enabled: ${i % 3 !== 0},`,
+      '  },'
+    );
+  }
+  lines.push('}');
+  return lines.join('\n');
+};
+
+// Returns the list of benchmark corpora. Every corpus has
+//   name - name used in the results
+//   value - the data
+//   mdsf - its MDSF representation
+//   json - its JSON representation
+//   messages - optional array of objects to be parsed as JSTP messages
+//
+const createCorpora = () => {
+  const random = createRandom(42);
+  const corpora = [];
+  const add = (name, value, mdsf, messages) => {
+    corpora.push({
+      name,
+      value,
+      mdsf: mdsf || stringify(value),
+      json: JSON.stringify(value),
+      messages,
+    });
+  };
+
+  const packets = createRpcPackets(random);
+  add('small-rpc', packets[0], null, packets);
+  add('number-array', createNumbers(random));
+  const records = createStringRecords(random);
+  add('string-heavy', records, null, records);
+  add('deep-nesting', createDeepValue(500));
+
+  const config = createConfig(random);
+  const fallback = require('../lib/serde-fallback');
+  add('comment-heavy', fallback.parse(config), config);
+
+  return corpora;
+};
+
+module.exports = {
+  createCorpora,
+  createRandom,
+};
@@ -0,0 +1,201 @@
+#!/usr/bin/env node
+
+'use strict';
+
+// Measures parse(), parseJSTPMessages() and stringify() of the native addon,
+// the JavaScript fallback and JSON over the corpora from corpora.js.
+//
+// Usage: node bench [--time=ms] [--filter=regexp] [--output=file]
+//   --time - time spent measuring every case, 1000 ms by default
+//   --filter - only run the cases whose `benchmark/corpus/implementation`
+//       name matches the regular expression
+//   --output - write the results to the file instead of stdout
+//
+// The results are written as JSON, a human readable summary goes to stderr.
+
+const fs = require('fs');
+const os = require('os');
+
+const common = require('../lib/common');
+const createCorpora = require('./corpora').createCorpora;
+
+const SAMPLE_TIME_MS = 5;
+const WARMUP_TIME_MS = 100;
+
+const parseArgs = argv => {
+  const args = { time: 1000, filter: null, output: null };
+  for (const arg of argv) {
+    const match = /^--(\w+)=(.*)$/.exec(arg);
+    if (!match || !(match[1] in args)) {
+      throw new Error(`Unknown argument: ${arg}`);
+    }
+    args[match[1]] = match[1] === 'time' ? Number(match[2]) : match[2];
+  }
+  if (args.filter !== null) args.filter = new RegExp(args.filter);
+  return args;
+};
+
+const now = () => {
+  const time = process.hrtime();
+  return time[0] * 1e3 + time[1] / 1e6;
+};
+
+const parseJSTPMessagesJSON = (data, messages) => {
+  const chunks = data.split('\0');
+  const readyMessagesCount = chunks.length - 1;
+  for (let i = 0; i < readyMessagesCount; i++) {
+    messages.push(JSON.parse(chunks[i]));
+  }
+  return chunks[readyMessagesCount];
+};
+
+const getImplementations = () => {
+  const implementations = [];
+  const [error] = common.safeRequire('../build/Release/mdsf');
+  if (error) {
+    console.warn(`Skipping the native addon: ${error.message}`);
+  } else {
+    const mdsf = require('..');
+    implementations.push({ name: 'native', format: 'mdsf', impl: mdsf });
+  }
+  const fallback = require('../lib/serde-fallback');
+  implementations.push({ name: 'fallback', format: 'mdsf', impl: fallback });
+  implementations.push({
+    name: 'json',
+    format: 'json',
+    impl: {
+      parse: JSON.parse,
+      parseJSTPMessages: parseJSTPMessagesJSON,
+      stringify: JSON.stringify,
+    },
+  });
+  return implementations;
+};
+
+// Every benchmark returns the function to be measured and the number of
+// bytes it processes, or null if the corpus doesn't apply.
+const BENCHMARKS = {
+  parse: (implementation, corpus) => {
+    const parse = implementation.impl.parse;
+    const data = corpus[implementation.format];
+    return { bytes: Buffer.byteLength(data), run: () => parse(data) };
+  },
+
+  parseJSTPMessages: (implementation, corpus) => {
+    if (!corpus.messages) return null;
+    const parseJSTPMessages = implementation.impl.parseJSTPMessages;
+    const stringify = implementation.impl.stringify;
+    const batch = corpus.messages
+      .map(message => stringify(message) + '\0')
+      .join('');
+    return {
+      bytes: Buffer.byteLength(batch),
+      run: () => parseJSTPMessages(batch, []),
+    };
+  },
+
+  stringify: (implementation, corpus) => {
+    const stringify = implementation.impl.stringify;
+    const value = corpus.value;
+    return {
+      bytes: Buffer.byteLength(stringify(value)),
+      run: () => stringify(value),
+    };
+  },
+};
+
+const percentile = (sorted, p) =>
+  sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+
+// Runs `run` repeatedly for `time` ms. Operations are grouped into samples
+// taking about SAMPLE_TIME_MS each, the latency of a sample is its duration
+// divided by the number of operations in it.
+const measure = (run, time) => {
+  let iterations = 1;
+  const warmupEnd = now() + WARMUP_TIME_MS;
+  while (now() < warmupEnd) {
+    const start = now();
+    for (let i = 0; i < iterations; i++) run();
+    if (now() - start < SAMPLE_TIME_MS) iterations *= 2;
+  }
+
+  const latencies = [];
+  let operations = 0;
+  let elapsed = 0;
+  while (elapsed < time) {
+    const start = now();
+    for (let i = 0; i < iterations; i++) run();
+    const duration = now() - start;
+    latencies.push(duration / iterations);
+    operations += iterations;
+    elapsed += duration;
+  }
+
+  latencies.sort((a, b) => a - b);
+  return {
+    operations,
+    elapsed,
+    p50: percentile(latencies, 0.5),
+    p99: percentile(latencies, 0.99),
+  };
+};
+
+const round = (number, digits) => {
+  const factor = Math.pow(10, digits);
+  return Math.round(number * factor) / factor;
+};
+
+const main = () => {
+  const args = parseArgs(process.argv.slice(2));
+  const implementations = getImplementations();
+  const corpora = createCorpora();
+  const results = [];
+
+  for (const benchmark of Object.keys(BENCHMARKS)) {
+    for (const corpus of corpora) {
+      for (const implementation of implementations) {
+        const name = `${benchmark}/${corpus.name}/${implementation.name}`;
+        if (args.filter && !args.filter.test(name)) continue;
+        const bench = BENCHMARKS[benchmark](implementation, corpus);
+        if (!bench) continue;
+
+        const result = measure(bench.run, args.time);
+        const opsPerSec = (result.operations * 1000) / result.elapsed;
+        results.push({
+          benchmark,
+          corpus: corpus.name,
+          implementation: implementation.name,
+          bytes: bench.bytes,
+          opsPerSec: round(opsPerSec, 2),
+          mbPerSec: round((opsPerSec * bench.bytes) / (1024 * 1024), 2),
+          p50Us: round(result.p50 * 1000, 3),
+          p99Us: round(result.p99 * 1000, 3),
+        });
+        console.warn(
+          `${name}: ${round(opsPerSec, 2)} ops/s, ` +
+            `${results[results.length - 1].mbPerSec} MB/s`
+        );
+      }
+    }
+  }
+
+  const report = JSON.stringify(
+    {
+      node: process.version,
+      platform: process.platform,
+      arch: process.arch,
+      cpu: os.cpus()[0].model,
+      date: new Date().toISOString(),
+      results,
+    },
+    null,
+    2
+  );
+  if (args.output) {
+    fs.writeFileSync(args.output, report + '\n');
+  } else {
+    console.log(report);
+  }
+};
+
+main();
@@ -0,0 +1,376 @@
+#!/usr/bin/env node
+
+'use strict';
+
+// Sends JSTP messages over a local socket and measures the throughput of the
+// whole path: stringifyJSTPMessages() on the client, the socket splitting
+// the data into chunks and parsing of the chunks with their remainders on
+// the server. The client and the server run in the same process, so the
+// event loop delay and heap growth include both of them.
+//
+// Usage: node bench/loopback [--time=ms] [--filter=regexp] [--output=file]
+//                            [--transport=tcp|unix] [--parser=messages|stream]
+//                            [--size=bytes] [--fragment=bytes] [--batch=count]
+//   --time - time spent sending the messages of every case, 2000 ms by
+//       default
+//   --filter - only run the cases whose `scenario/implementation` name
+//       matches the regular expression
+//   --output - write the results to the file instead of stdout
+//   --transport - TCP on the loopback interface (default) or a Unix socket
+//       (a named pipe on Windows)
+//   --parser - parse the received data with parseJSTPMessages() and
+//       carry the remainder over to the next chunk (default), or with a
+//       MessageStream
+//   --size, --fragment, --batch - run a single `custom` scenario instead of
+//       the predefined ones, with messages of about `size` bytes written in
+//       batches of `batch` messages split into writes of at most `fragment`
+//       bytes (0 to write a batch at once)
+//
+// Run with --expose-gc so that the heap growth is measured after garbage
+// collection. The results are written as JSON, a human readable summary
+// goes to stderr.
+
+const fs = require('fs');
+const net = require('net');
+const os = require('os');
+const path = require('path');
+
+const common = require('../lib/common');
+const createRandom = require('./corpora').createRandom;
+
+const DELAY_SAMPLE_INTERVAL_MS = 10;
+
+const SCENARIOS = [
+  { name: 'small-whole', size: 128, fragment: 0, batch: 16 },
+  { name: 'small-fragmented', size: 128, fragment: 16, batch: 16 },
+  { name: 'medium-mtu', size: 4096, fragment: 1460, batch: 4 },
+  { name: 'large-fragmented', size: 256 * 1024, fragment: 16384, batch: 1 },
+];
+
+const parseArgs = argv => {
+  const args = {
+    time: 2000,
+    filter: null,
+    output: null,
+    transport: 'tcp',
+    parser: 'messages',
+    size: null,
+    fragment: null,
+    batch: null,
+  };
+  const numbers = ['time', 'size', 'fragment', 'batch'];
+  for (const arg of argv) {
+    const match = /^--(\w+)=(.*)$/.exec(arg);
+    if (!match || !(match[1] in args)) {
+      throw new Error(`Unknown argument: ${arg}`);
+    }
+    const value = match[2];
+    args[match[1]] = numbers.includes(match[1]) ? Number(value) : value;
+  }
+  if (args.filter !== null) args.filter = new RegExp(args.filter);
+  if (!['tcp', 'unix'].includes(args.transport)) {
+    throw new Error(`Unknown transport: ${args.transport}`);
+  }
+  if (!['messages', 'stream'].includes(args.parser)) {
+    throw new Error(`Unknown parser: ${args.parser}`);
+  }
+  return args;
+};
+
+const getScenarios = args => {
+  if (args.size === null && args.fragment === null && args.batch === null) {
+    return SCENARIOS;
+  }
+  return [
+    {
+      name: 'custom',
+      size: args.size === null ? 128 : args.size,
+      fragment: args.fragment === null ? 0 : args.fragment,
+      batch: args.batch === null ? 1 : args.batch,
+    },
+  ];
+};
+
+const getImplementations = () => {
+  const implementations = [];
+  const [error] = common.safeRequire('../build/Release/mdsf');
+  if (error) {
+    console.warn(`Skipping the native addon: ${error.message}`);
+  } else {
+    implementations.push({ name: 'native', impl: require('..') });
+  }
+  const fallback = require('../lib/serde-fallback');
+  implementations.push({ name: 'fallback', impl: fallback });
+  return implementations;
+};
+
+const now = () => {
+  const time = process.hrtime();
+  return time[0] * 1e3 + time[1] / 1e6;
+};
+
+const round = (number, digits) => {
+  const factor = Math.pow(10, digits);
+  return Math.round(number * factor) / factor;
+};
+
+const percentile = (sorted, p) =>
+  sorted.length === 0
+    ? 0
+    : sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+
+const collectGarbage = () => {
+  if (global.gc) global.gc();
+};
+
+// Creates a call message with random records as arguments, about `size`
+// bytes long once serialized.
+const createMessage = (size, stringify) => {
+  const random = createRandom(size);
+  const records = [];
+  const message = { call: [1, 'bench', 'push'], push: [records] };
+  while (stringify(message).length < size) {
+    const id = Math.floor(random() * 1e6);
+    records.push({
+      id,
+      name: `user ${id}`,
+      text: 'line\n"quoted" ' + 'x'.repeat(Math.floor(random() * 32)),
+      score: round(random() * 100, 3),
+      active: random() < 0.5,
+    });
+  }
+  return message;
+};
+
+// Samples the delay of a timer to estimate how long the event loop is
+// blocked, and the size of the heap.
+const startMonitor = () => {
+  const delays = [];
+  let peakHeap = process.memoryUsage().heapUsed;
+  let expected = now() + DELAY_SAMPLE_INTERVAL_MS;
+  const timer = setInterval(() => {
+    const time = now();
+    delays.push(Math.max(0, time - expected));
+    expected = time + DELAY_SAMPLE_INTERVAL_MS;
+    peakHeap = Math.max(peakHeap, process.memoryUsage().heapUsed);
+  }, DELAY_SAMPLE_INTERVAL_MS);
+  return () => {
+    clearInterval(timer);
+    delays.sort((a, b) => a - b);
+    return {
+      delayP50: percentile(delays, 0.5),
+      delayP99: percentile(delays, 0.99),
+      delayMax: delays.length === 0 ? 0 : delays[delays.length - 1],
+      peakHeap,
+    };
+  };
+};
+
+const createReceiver = (impl, parser) => {
+  const messages = [];
+  if (parser === 'stream') {
+    const stream = new impl.MessageStream();
+    return {
+      encoding: null,
+      receive: chunk => {
+        messages.length = 0;
+        stream.parse(chunk, messages);
+        return messages;
+      },
+    };
+  }
+  let remainder = '';
+  return {
+    encoding: 'utf8',
+    receive: chunk => {
+      messages.length = 0;
+      remainder = impl.parseJSTPMessages(remainder + chunk, messages);
+      return messages;
+    },
+  };
+};
+
+const getAddress = (transport, callback) => {
+  if (transport === 'tcp') {
+    callback({ port: 0, host: '127.0.0.1' });
+    return;
+  }
+  const name = `mdsf-bench-${process.pid}.sock`;
+  if (process.platform === 'win32') {
+    callback({ path: path.join('\\\\?\\pipe', name) });
+    return;
+  }
+  const socketPath = path.join(os.tmpdir(), name);
+  fs.unlink(socketPath, () => callback({ path: socketPath }));
+};
+
+// Sends the messages for `time` ms and calls `callback` with the results
+// once the server has parsed all of them.
+const runCase = (implementation, scenario, args, callback) => {
+  const impl = implementation.impl;
+  const message = createMessage(scenario.size, impl.stringify);
+  const batch = [];
+  for (let i = 0; i < scenario.batch; i++) batch.push(message);
+  const messageBytes = impl.stringifyJSTPMessages([message]).length;
+  const expected = impl.stringify(message);
+
+  const receiver = createReceiver(impl, args.parser);
+  let received = 0;
+  let receivedBytes = 0;
+  let chunks = 0;
+  let lastMessage = null;
+  let sent = 0;
+  let start = 0;
+  let stopMonitor = null;
+  let heapBefore = 0;
+
+  const server = net.createServer(socket => {
+    if (receiver.encoding) socket.setEncoding(receiver.encoding);
+    socket.on('data', chunk => {
+      chunks++;
+      receivedBytes += Buffer.byteLength(chunk);
+      const messages = receiver.receive(chunk);
+      received += messages.length;
+      if (messages.length > 0) lastMessage = messages[messages.length - 1];
+    });
+    socket.on('end', () => {
+      const elapsed = now() - start;
+      const monitor = stopMonitor();
+      collectGarbage();
+      const heapGrowth = process.memoryUsage().heapUsed - heapBefore;
+      server.close();
+      if (received !== sent || impl.stringify(lastMessage) !== expected) {
+        callback(new Error(`Received ${received} of ${sent} messages`));
+        return;
+      }
+      const messagesPerSec = (received * 1000) / elapsed;
+      callback(null, {
+        messages: received,
+        messagesPerSec,
+        mbPerSec: (receivedBytes * 1000) / elapsed / (1024 * 1024),
+        messageBytes,
+        averageChunkBytes: receivedBytes / chunks,
+        monitor,
+        heapGrowth,
+      });
+    });
+  });
+
+  getAddress(args.transport, address => {
+    server.listen(address, () => {
+      const client = net.connect(
+        args.transport === 'tcp'
+          ? { port: server.address().port, host: address.host }
+          : { path: address.path }
+      );
+      client.setNoDelay(true);
+      client.on('connect', () => {
+        collectGarbage();
+        heapBefore = process.memoryUsage().heapUsed;
+        stopMonitor = startMonitor();
+        start = now();
+        const end = start + args.time;
+        // Every batch is written in a separate turn of the event loop, so
+        // that the server can read the data as a real peer would.
+        const write = () => {
+          if (now() >= end) {
+            client.end();
+            return;
+          }
+          const data = impl.stringifyJSTPMessages(batch);
+          sent += batch.length;
+          let flushed = true;
+          if (scenario.fragment > 0) {
+            for (let i = 0; i < data.length; i += scenario.fragment) {
+              flushed = client.write(data.slice(i, i + scenario.fragment));
+            }
+          } else {
+            flushed = client.write(data);
+          }
+          if (flushed) {
+            setImmediate(write);
+          } else {
+            client.once('drain', write);
+          }
+        };
+        write();
+      });
+    });
+  });
+};
+
+const main = () => {
+  const args = parseArgs(process.argv.slice(2));
+  const implementations = getImplementations();
+  const cases = [];
+  for (const scenario of getScenarios(args)) {
+    for (const implementation of implementations) {
+      const name = `${scenario.name}/${implementation.name}`;
+      if (args.filter && !args.filter.test(name)) continue;
+      cases.push({ name, scenario, implementation });
+    }
+  }
+  if (!global.gc) {
+    console.warn('Run with --expose-gc to measure the heap growth after GC');
+  }
+
+  const results = [];
+  const next = index => {
+    if (index === cases.length) {
+      report(args, results);
+      return;
+    }
+    const current = cases[index];
+    runCase(current.implementation, current.scenario, args, (error, r) => {
+      if (error) throw error;
+      const result = {
+        benchmark: `loopback/${args.transport}/${args.parser}`,
+        corpus: current.scenario.name,
+        implementation: current.implementation.name,
+        bytes: r.messageBytes,
+        fragmentBytes: current.scenario.fragment,
+        batch: current.scenario.batch,
+        messages: r.messages,
+        opsPerSec: round(r.messagesPerSec, 2),
+        mbPerSec: round(r.mbPerSec, 2),
+        averageChunkBytes: round(r.averageChunkBytes, 1),
+        eventLoopDelayP50Ms: round(r.monitor.delayP50, 3),
+        eventLoopDelayP99Ms: round(r.monitor.delayP99, 3),
+        eventLoopDelayMaxMs: round(r.monitor.delayMax, 3),
+        peakHeapBytes: r.monitor.peakHeap,
+        heapGrowthBytes: r.heapGrowth,
+      };
+      results.push(result);
+      console.warn(
+        `${current.name}: ${result.opsPerSec} messages/s, ` +
+          `${result.mbPerSec} MB/s, ` +
+          `event loop delay p99 ${result.eventLoopDelayP99Ms} ms, ` +
+          `heap growth ${result.heapGrowthBytes} bytes`
+      );
+      next(index + 1);
+    });
+  };
+  next(0);
+};
+
+const report = (args, results) => {
+  const data = JSON.stringify(
+    {
+      node: process.version,
+      platform: process.platform,
+      arch: process.arch,
+      cpu: os.cpus()[0].model,
+      date: new Date().toISOString(),
+      results,
+    },
+    null,
+    2
+  );
+  if (args.output) {
+    fs.writeFileSync(args.output, data + '\n');
+  } else {
+    console.log(data);
+  }
+};
+
+main();
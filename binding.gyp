@@ -8,20 +8,38 @@
     ],
     'mdsf_debug_ccflags': ['-g', '-O0'],
     'mdsf_release_ccflags': ['-O3'],
-    'mdsf_use_short_unicode_tables': '<!(node ./tools/echo-env MDSF_USE_SHORT_UNICODE_TABLES)'
+    'mdsf_use_short_unicode_tables': '<!(node ./tools/echo-env MDSF_USE_SHORT_UNICODE_TABLES)',
+    'mdsf_use_full_unicode_tables': '<!(node ./tools/echo-env MDSF_USE_FULL_UNICODE_TABLES)',
+    'mdsf_enable_stats': '<!(node ./tools/echo-env MDSF_ENABLE_STATS)'
   },
   'targets': [
     {
       'target_name': 'mdsf',
       'sources': [
         'src/node_bindings.cc',
+        'src/json_transcoder.cc',
+        'src/parse_stats.cc',
         'src/parser.cc',
+        'src/message_cache.cc',
         'src/message_parser.cc',
-        'src/unicode_utils.cc'
+        'src/number_format.cc',
+        'src/serializer.cc',
+        'src/simd.cc',
+        'src/stream_parser.cc',
+        'src/structural_index.cc',
+        'src/tracing.cc',
+        'src/unicode_utils.cc',
+        'src/validator.cc'
       ],
       'conditions': [
-        ['not mdsf_use_short_unicode_tables', {
+        ['mdsf_use_short_unicode_tables', {
+          'defines': ['_PARSER_USE_SHORT_TABLES_']
+        }],
+        ['mdsf_use_full_unicode_tables and not mdsf_use_short_unicode_tables', {
           'defines': ['_PARSER_USE_FULL_TABLES_']
+        }],
+        ['mdsf_enable_stats', {
+          'defines': ['_PARSER_ENABLE_STATS_']
         }]
       ],
       'configurations': {
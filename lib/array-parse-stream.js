@@ -0,0 +1,66 @@
+'use strict';
+
+const Transform = require('stream').Transform;
+
+// Transform stream that receives a serialized top-level array in chunks and
+// emits each of its elements as soon as the element has been received
+// completely, so that memory usage is bounded by the size of the largest
+// element rather than by the size of the whole array. Elements are emitted
+// as `{ index, value }` objects since `null` cannot be pushed to a stream.
+//   ArrayStreamParser - ArrayStreamParser implementation to use
+//   options - stream options, `readableObjectMode` is always set, parsing
+//       options (maxDepth, typedArrays, deduplicateStrings) are passed to
+//       the parser
+//
+class ArrayParseStream extends Transform {
+  constructor(ArrayStreamParser, options) {
+    super(Object.assign({}, options, { readableObjectMode: true }));
+    this.parser = new ArrayStreamParser(options);
+    this.index = 0;
+    this.failed = false;
+  }
+
+  _transform(chunk, encoding, callback) {
+    // Old versions of Node.js keep writing to a stream after an error, the
+    // parser has been reset by then and the rest of the data is ignored.
+    if (this.failed) {
+      callback();
+      return;
+    }
+    const elements = [];
+    try {
+      this.parser.parse(chunk, elements);
+    } catch (error) {
+      this.failed = true;
+      callback(error);
+      return;
+    }
+    this.pushElements(elements);
+    callback();
+  }
+
+  _flush(callback) {
+    // Neither is the stream ended after an error, just as newer versions of
+    // Node.js do it.
+    if (this.failed) {
+      return;
+    }
+    const elements = [];
+    try {
+      this.parser.finish(elements);
+    } catch (error) {
+      callback(error);
+      return;
+    }
+    this.pushElements(elements);
+    callback();
+  }
+
+  pushElements(elements) {
+    for (let i = 0; i < elements.length; i++) {
+      this.push({ index: this.index++, value: elements[i] });
+    }
+  }
+}
+
+module.exports = ArrayParseStream;
@@ -2,6 +2,8 @@
 
 const safeRequire = require('./common').safeRequire;
 const stringify = require('./stringify');
+const ArrayParseStream = require('./array-parse-stream');
+const StringifyStream = require('./stringify-stream');
 
 let [error, mdsfNative] = safeRequire('../build/Release/mdsf');
 
@@ -10,9 +12,32 @@ if (error) {
   [error, mdsfNative] = safeRequire('../build/Debug/mdsf');
 }
 
+// Create a stream that parses a top-level array and emits its elements.
+//   impl - module providing ArrayStreamParser
+//
+const getCreateArrayParseStream = impl => options =>
+  new ArrayParseStream(impl.ArrayStreamParser, options);
+
+// Create a function with the arguments of stringify() and stream options
+// returning a readable stream of the serialization.
+//   stringifyParts - stringifyParts() implementation to use
+//
+const getStringifyStream = stringifyParts => (
+  value,
+  replacer,
+  space,
+  options
+) => new StringifyStream(stringifyParts(value, replacer, space), options);
+
 if (mdsfNative) {
   module.exports = Object.assign(Object.create(null), mdsfNative, {
-    stringify,
+    stringify: stringify.createStringify(mdsfNative),
+    stringifyJSTPMessages: stringify.createStringifyJSTPMessages(mdsfNative),
+    KeyDictionary: stringify.KeyDictionary,
+    createArrayParseStream: getCreateArrayParseStream(mdsfNative),
+    stringifyStream: getStringifyStream(
+      stringify.createStringifyParts(mdsfNative)
+    ),
   });
 } else {
   console.warn(
@@ -22,5 +47,9 @@ if (mdsfNative) {
       'Run `npm install` in order to build it, otherwise you will get ' +
       'poor performance.'
   );
-  module.exports = require('./serde-fallback');
+  const jsParser = require('./serde-fallback');
+  module.exports = Object.assign(Object.create(null), jsParser, {
+    createArrayParseStream: getCreateArrayParseStream(jsParser),
+    stringifyStream: getStringifyStream(stringify.stringifyParts),
+  });
 }
@@ -2,43 +2,682 @@
 
 const stringify = require('./stringify');
 
+const DEFAULT_MAX_DEPTH = 1000;
+
+// Maximum length of string values deduplicated by the deduplicateStrings
+// option and maximum number of distinct values remembered per parse.
+const MAX_DEDUPLICATED_STRING_LENGTH = 32;
+const MAX_DEDUPLICATED_STRINGS = 3072;
+
+// Maximum number of keys remembered by a MessageStream with the key
+// dictionary enabled, must be the same as in KeyDictionary.
+const MAX_KEY_DICTIONARY_SIZE = 65536;
+
 // Deserialize a string into a JavaScript value and return it.
 //   data - a string or Buffer to parse
+//   options - optional parsing options
+//     maxDepth - maximum nesting depth of arrays and objects
+//     dialect - grammar of the data, either 'mdsf' (default) or 'json'
+//     typedArrays - return arrays of numbers as Int32Array or Float64Array
+//     deduplicateStrings - return the same string for repeated short string
+//         values
 //
-const parse = data => {
+const parse = (data, options) => {
   if (Buffer.isBuffer(data)) {
-    data = data.toString();
+    data = decodeUtf8(data);
   }
 
-  const parser = new Parser(data);
+  const maxDepth = getMaxDepth(options);
+  const typedArrays = getTypedArrays(options);
+  const deduplicateStrings = getDeduplicateStrings(options);
+  if (getDialect(options) === 'json') {
+    // maxDepth is not enforced here, JSON.parse() can't overflow the stack.
+    return JSON.parse(data, typedArrays ? typedArraysReviver : undefined);
+  }
+  const parser = new Parser(
+    data,
+    maxDepth,
+    typedArrays,
+    null,
+    deduplicateStrings
+  );
   return parser.parse();
 };
 
+// Get whether numeric arrays must be returned as typed arrays from parsing
+// options
+//   options - parsing options
+//
+const getTypedArrays = options =>
+  options !== undefined && !!options.typedArrays;
+
+// Get whether repeated string values must be deduplicated from parsing
+// options
+//   options - parsing options
+//
+const getDeduplicateStrings = options =>
+  options !== undefined && !!options.deduplicateStrings;
+
+const isInt32 = number => (number | 0) === number && !Object.is(number, -0);
+
+// Convert a non-empty array containing only numbers to Int32Array if all of
+// them fit into int32, or to Float64Array otherwise. Other arrays are
+// returned as is.
+//   array - array to convert
+//
+const toTypedArray = array => {
+  if (array.length === 0) return array;
+  let int32 = true;
+  for (let i = 0; i < array.length; i++) {
+    const value = array[i];
+    if (typeof value !== 'number') return array;
+    if (int32 && !isInt32(value)) int32 = false;
+  }
+  return int32 ? Int32Array.from(array) : Float64Array.from(array);
+};
+
+const typedArraysReviver = (key, value) =>
+  Array.isArray(value) ? toTypedArray(value) : value;
+
+// Decode a Buffer as UTF-8 throwing on malformed sequences instead of
+// replacing them with U+FFFD the way Buffer#toString() does.
+//   buffer - Buffer to decode
+//
+const decodeUtf8 = buffer => {
+  const str = buffer.toString();
+  const position = findInvalidUtf8(buffer, str);
+  if (position === -1) return str;
+  throw new SyntaxError(`Invalid UTF-8 sequence at position ${position}`);
+};
+
+// Find the first malformed UTF-8 sequence in a Buffer
+//   buffer - Buffer to check
+//   str - buffer decoded with Buffer#toString()
+// Returns the offset of the sequence or -1 if the buffer is valid.
+//
+const findInvalidUtf8 = (buffer, str) => {
+  const encoded = Buffer.from(str);
+  if (encoded.equals(buffer)) return -1;
+  let position = 0;
+  while (encoded[position] === buffer[position]) position++;
+  return position;
+};
+
+// Get the number of bytes at the end of a Buffer that begin a UTF-8 sequence
+// truncated by the end of the Buffer
+//   buffer - Buffer to check
+//
+const getIncompleteUtf8Length = buffer => {
+  for (let i = 1; i <= 3 && i <= buffer.length; i++) {
+    const byte = buffer[buffer.length - i];
+    if (byte < 0x80) return 0;
+    if (byte >= 0xc0) {
+      const sequenceLength = byte >= 0xf0 ? 4 : byte >= 0xe0 ? 3 : 2;
+      return sequenceLength > i ? i : 0;
+    }
+  }
+  return 0;
+};
+
+// Get the maximum nesting depth from parsing options
+//   options - parsing options
+//
+const getMaxDepth = options => {
+  if (options === undefined || options.maxDepth === undefined) {
+    return DEFAULT_MAX_DEPTH;
+  }
+  const maxDepth = options.maxDepth;
+  if (!Number.isInteger(maxDepth) || maxDepth <= 0) {
+    throw new TypeError('maxDepth must be a positive integer');
+  }
+  return maxDepth;
+};
+
+// Get the grammar dialect from parsing options
+//   options - parsing options
+//
+const getDialect = options => {
+  if (options === undefined || options.dialect === undefined) {
+    return 'mdsf';
+  }
+  const dialect = options.dialect;
+  if (dialect !== 'mdsf' && dialect !== 'json') {
+    throw new TypeError("dialect must be either 'mdsf' or 'json'");
+  }
+  return dialect;
+};
+
+// Throw if parsing options select a dialect other than MDSF, which is the
+// only one supported by the message and array stream parsers
+//   options - parsing options
+//
+const checkMdsfDialect = options => {
+  if (getDialect(options) !== 'mdsf') {
+    throw new TypeError("Only the 'mdsf' dialect is supported");
+  }
+};
+
+const parseMessage = (data, maxDepth, typedArrays, deduplicateStrings) => {
+  const parser = new Parser(
+    data,
+    maxDepth,
+    typedArrays,
+    null,
+    deduplicateStrings
+  );
+  const message = parser.parseObject();
+  parser.ensureEndOfData();
+  return message;
+};
+
 // Parse a buffer of JSTP network messages.
 //   data - buffer contents
 //   messages - target array
+//   cache - optional MessageCache
+//   errors - optional array, if it is passed an invalid message doesn't stop
+//       the parsing, an object describing it is pushed to this array instead
+//     index - index of the message in the data, invalid ones included
+//     begin - offset of the message in the UTF-8 encoded data
+//     end - offset of its terminator
+//     reason - error message
+//   options - optional parsing options
+//     maxDepth - maximum nesting depth of arrays and objects
+//     typedArrays - return arrays of numbers as Int32Array or Float64Array
+//     deduplicateStrings - return the same string for repeated short string
+//         values within a message
 //   Returns the part of the message that has not been received yet
 //
-const parseJSTPMessages = (data, messages) => {
+const parseJSTPMessages = (data, messages, cache, errors, options) => {
+  if (cache !== undefined && !(cache instanceof MessageCache)) {
+    throw new TypeError('Cache must be a MessageCache');
+  }
+  if (errors !== undefined && !Array.isArray(errors)) {
+    throw new TypeError('Errors must be an array');
+  }
+  checkMdsfDialect(options);
+  const maxDepth = getMaxDepth(options);
+  const typedArrays = getTypedArrays(options);
+  const deduplicateStrings = getDeduplicateStrings(options);
+  const parse = data =>
+    parseMessage(data, maxDepth, typedArrays, deduplicateStrings);
   const chunks = data.split('\u0000');
   const readyMessagesCount = chunks.length - 1;
+  let offset = 0;
+
+  for (let i = 0; i < readyMessagesCount; i++) {
+    let message = cache ? cache.lookup(chunks[i]) : undefined;
+    if (message === undefined) {
+      if (errors) {
+        try {
+          message = parse(chunks[i]);
+        } catch (error) {
+          const end = offset + Buffer.byteLength(chunks[i]);
+          errors.push({ index: i, begin: offset, end, reason: error.message });
+          offset = end + 1;
+          continue;
+        }
+      } else {
+        message = parse(chunks[i]);
+      }
+      if (cache) cache.insert(chunks[i], message);
+    }
+    messages.push(message);
+    if (errors) offset += Buffer.byteLength(chunks[i]) + 1;
+  }
+
+  return chunks[readyMessagesCount];
+};
+
+// Default limit of the total size of the messages in a MessageCache.
+const DEFAULT_MESSAGE_CACHE_SIZE = 1024 * 1024;
+
+// Bytes accounted for every MessageCache entry in addition to the message
+// and the values parsed from it.
+const MESSAGE_CACHE_ENTRY_OVERHEAD = 64;
+
+// Estimated bytes retained by every value of a cached message, including the
+// objects and arrays themselves.
+const MESSAGE_CACHE_NODE_SIZE = 32;
+
+// Adds the value and the objects reachable from it to `objects` and returns
+// the number of values found, or a number greater than `maxNodeCount` if
+// there are more of them or some of them are typed arrays, which cannot be
+// frozen.
+const collectObjects = (value, objects, maxNodeCount) => {
+  const stack = [value];
+  let nodeCount = 0;
+  while (stack.length > 0 && nodeCount <= maxNodeCount) {
+    const node = stack.pop();
+    nodeCount++;
+    if (typeof node !== 'object' || node === null) continue;
+    if (ArrayBuffer.isView(node)) return maxNodeCount + 1;
+    objects.push(node);
+    for (const key of Object.keys(node)) stack.push(node[key]);
+  }
+  return nodeCount;
+};
+
+// Cache of parsed messages keyed by their contents for parseJSTPMessages().
+// The cached messages are deeply frozen since they are shared. The size of an
+// entry is the size of the message plus an estimate of the memory retained by
+// its values, the least recently used entries are evicted when the total size
+// exceeds the limit.
+//   options - optional cache options
+//     maxSize - limit of the total size of the cached messages in bytes
+//
+class MessageCache {
+  constructor(options) {
+    let maxSize = DEFAULT_MESSAGE_CACHE_SIZE;
+    if (typeof options === 'object' && options !== null) {
+      if (options.maxSize !== undefined) {
+        maxSize = options.maxSize;
+        if (typeof maxSize !== 'number' || !(maxSize >= 0)) {
+          throw new RangeError('maxSize must be a non-negative number');
+        }
+      }
+    } else if (options !== undefined) {
+      throw new TypeError('Options must be an object');
+    }
+    this.maxSize = maxSize;
+    this.size = 0;
+    this.entries = new Map();
+    this.hits = 0;
+    this.misses = 0;
+    this.evictions = 0;
+    this.updates = 0;
+  }
+
+  lookup(message) {
+    const entry = this.entries.get(message);
+    if (entry === undefined) {
+      this.misses++;
+      return undefined;
+    }
+    // Map keeps the insertion order, so re-inserting the entry makes it the
+    // most recently used one.
+    this.entries.delete(message);
+    this.entries.set(message, entry);
+    this.hits++;
+    return entry.value;
+  }
+
+  // Entries larger than a sixteenth of the cache and messages containing
+  // typed arrays are not stored.
+  insert(message, value) {
+    const maxEntrySize = this.maxSize / 16;
+    let size = Buffer.byteLength(message) + MESSAGE_CACHE_ENTRY_OVERHEAD;
+    if (size > maxEntrySize) return;
+    const maxNodeCount = Math.floor(
+      (maxEntrySize - size) / MESSAGE_CACHE_NODE_SIZE
+    );
+    const objects = [];
+    const nodeCount = collectObjects(value, objects, maxNodeCount);
+    if (nodeCount > maxNodeCount) return;
+    for (const object of objects) Object.freeze(object);
+    size += nodeCount * MESSAGE_CACHE_NODE_SIZE;
+
+    const previous = this.entries.get(message);
+    if (previous !== undefined) {
+      this.entries.delete(message);
+      this.size -= previous.size;
+      this.updates++;
+    }
+    this.entries.set(message, { value, size });
+    this.size += size;
+    for (const [oldest, entry] of this.entries) {
+      if (this.size <= this.maxSize) break;
+      this.entries.delete(oldest);
+      this.size -= entry.size;
+      this.evictions++;
+    }
+  }
+
+  getStats() {
+    return {
+      hits: this.hits,
+      misses: this.misses,
+      evictions: this.evictions,
+      updates: this.updates,
+      entries: this.entries.size,
+      size: this.size,
+      maxSize: this.maxSize,
+    };
+  }
+
+  clear() {
+    this.entries.clear();
+    this.size = 0;
+  }
+}
+
+// Decoder of UTF-8 data received in chunks, which validates the data and
+// keeps a sequence split between chunks until the rest of it arrives.
+class Utf8ChunkDecoder {
+  constructor() {
+    // Beginning of a UTF-8 sequence truncated by the end of the last chunk
+    this.incomplete = null;
+    // Number of bytes received so far
+    this.receivedLength = 0;
+  }
+
+  // Decode the next chunk, a string chunk is returned as is.
+  //   chunk - a string or Buffer
+  //
+  write(chunk) {
+    if (!Buffer.isBuffer(chunk)) {
+      this.receivedLength += Buffer.byteLength(chunk);
+      return chunk;
+    }
+
+    const incomplete = this.incomplete;
+    const data = incomplete ? Buffer.concat([incomplete, chunk]) : chunk;
+    const offset = this.receivedLength - (incomplete ? incomplete.length : 0);
+    this.receivedLength += chunk.length;
+
+    const completeLength = data.length - getIncompleteUtf8Length(data);
+    const complete = data.slice(0, completeLength);
+    const str = complete.toString();
+    const position = findInvalidUtf8(complete, str);
+    if (position !== -1) {
+      this.reset();
+      throw new SyntaxError(
+        `Invalid UTF-8 sequence at position ${offset + position}`
+      );
+    }
+    this.incomplete =
+      completeLength < data.length
+        ? Buffer.from(data.slice(completeLength))
+        : null;
+    return str;
+  }
+
+  // Check that the data doesn't end with a truncated sequence.
+  //
+  end() {
+    const incomplete = this.incomplete;
+    const position = this.receivedLength - (incomplete ? incomplete.length : 0);
+    this.reset();
+    if (incomplete) {
+      throw new SyntaxError(`Invalid UTF-8 sequence at position ${position}`);
+    }
+  }
+
+  reset() {
+    this.incomplete = null;
+    this.receivedLength = 0;
+  }
+}
+
+// Parser of JSTP messages from a stream received in chunks.
+//   options - optional parsing options
+//     maxDepth - maximum nesting depth of arrays and objects
+//     typedArrays - return arrays of numbers as Int32Array or Float64Array
+//     deduplicateStrings - return the same string for repeated short string
+//         values within a message
+//     keyDictionary - resolve references to the keys seen earlier in the
+//         stream, produced by stringifyJSTPMessages() with a KeyDictionary
+//
+function MessageStream(options) {
+  checkMdsfDialect(options);
+  this.maxDepth = getMaxDepth(options);
+  this.typedArrays = getTypedArrays(options);
+  this.deduplicateStrings = getDeduplicateStrings(options);
+  this.keyDictionary =
+    options !== undefined && options.keyDictionary ? [] : null;
+  this.data = '';
+  this.decoder = new Utf8ChunkDecoder();
+}
+
+// Parse the next chunk of the stream.
+//   chunk - a string or Buffer
+//   messages - target array
+//
+MessageStream.prototype.parse = function(chunk, messages) {
+  try {
+    chunk = this.decoder.write(chunk);
+  } catch (error) {
+    this.data = '';
+    throw error;
+  }
+
+  const chunks = (this.data + chunk).split('\u0000');
+  const readyMessagesCount = chunks.length - 1;
+  this.data = chunks[readyMessagesCount];
 
   for (let i = 0; i < readyMessagesCount; i++) {
-    const parser = new Parser(chunks[i]);
+    const parser = new Parser(
+      chunks[i],
+      this.maxDepth,
+      this.typedArrays,
+      this.keyDictionary,
+      this.deduplicateStrings
+    );
     const message = parser.parseObject();
     parser.ensureEndOfData();
     messages.push(message);
   }
+};
 
-  return chunks[readyMessagesCount];
+const ARRAY_STATE_BEFORE = 0;
+const ARRAY_STATE_INSIDE = 1;
+const ARRAY_STATE_AFTER = 2;
+
+// Parser of a top-level array received in chunks, which emits each element
+// of the array as soon as it has been received completely. Lexical state is
+// kept between chunks, so every character is scanned once no matter how many
+// chunks an element is split into.
+//   options - optional parsing options
+//     maxDepth - maximum nesting depth of arrays and objects
+//     typedArrays - return arrays of numbers as Int32Array or Float64Array
+//     deduplicateStrings - return the same string for repeated short string
+//         values within an element
+//
+function ArrayStreamParser(options) {
+  checkMdsfDialect(options);
+  this.maxDepth = getMaxDepth(options);
+  this.typedArrays = getTypedArrays(options);
+  this.deduplicateStrings = getDeduplicateStrings(options);
+  this.decoder = new Utf8ChunkDecoder();
+  this.reset();
+}
+
+ArrayStreamParser.prototype.reset = function() {
+  this.state = ARRAY_STATE_BEFORE;
+  // Scanned parts of the current element
+  this.pieces = [];
+  // Nesting depth inside the current element
+  this.depth = 0;
+  // Quote of the string being scanned
+  this.quote = null;
+  this.escaped = false;
+  // Whether the last character is a slash that may begin a comment
+  this.slash = false;
+  this.lineComment = false;
+  this.blockComment = false;
+  // Whether the last character of a block comment is an asterisk
+  this.star = false;
+  this.decoder.reset();
+};
+
+// Parse the next chunk of the array.
+//   chunk - a string or Buffer
+//   elements - target array for the elements completed by the chunk
+//
+ArrayStreamParser.prototype.parse = function(chunk, elements) {
+  try {
+    this.scan(this.decoder.write(chunk), elements);
+  } catch (error) {
+    this.reset();
+    throw error;
+  }
 };
 
+// Check that the whole array has been received.
+//   elements - target array, nothing is ever added to it since every
+//       element is completed by a delimiter
+//
+ArrayStreamParser.prototype.finish = function(elements) {
+  try {
+    this.decoder.end();
+    this.scan('', elements);
+    if (this.slash) {
+      this.throwUnexpected();
+    }
+    if (this.state !== ARRAY_STATE_AFTER || this.blockComment) {
+      throw new SyntaxError('Unexpected end of data');
+    }
+  } finally {
+    this.reset();
+  }
+};
+
+ArrayStreamParser.prototype.throwUnexpected = function() {
+  throw new SyntaxError(
+    this.state === ARRAY_STATE_BEFORE
+      ? 'Top-level value is not an array'
+      : 'Unexpected data after the array'
+  );
+};
+
+ArrayStreamParser.prototype.scan = function(data, elements) {
+  let start = 0;
+
+  for (let i = 0; i < data.length; i++) {
+    const character = data[i];
+
+    if (this.quote !== null) {
+      if (this.escaped) {
+        this.escaped = false;
+      } else if (character === '\\') {
+        this.escaped = true;
+      } else if (character === this.quote) {
+        this.quote = null;
+      }
+      continue;
+    }
+    if (this.lineComment) {
+      this.lineComment = character !== '\n' && character !== '\r';
+      continue;
+    }
+    if (this.blockComment) {
+      this.blockComment = !(this.star && character === '/');
+      this.star = character === '*';
+      continue;
+    }
+    if (this.slash) {
+      this.slash = false;
+      if (character === '/') {
+        this.lineComment = true;
+        continue;
+      } else if (character === '*') {
+        this.blockComment = true;
+        continue;
+      } else if (this.state !== ARRAY_STATE_INSIDE) {
+        this.throwUnexpected();
+      }
+    }
+    if (character === '/') {
+      this.slash = true;
+      continue;
+    }
+
+    if (this.state !== ARRAY_STATE_INSIDE) {
+      if (' \f\n\r\t\v'.includes(character)) {
+        continue;
+      }
+      if (this.state === ARRAY_STATE_BEFORE && character === '[') {
+        this.state = ARRAY_STATE_INSIDE;
+        start = i + 1;
+        continue;
+      }
+      this.throwUnexpected();
+    }
+
+    if (character === "'" || character === '"') {
+      this.quote = character;
+    } else if (character === '[' || character === '{') {
+      this.depth++;
+    } else if (
+      (character === ']' || character === '}' || character === ',') &&
+      this.depth === 0
+    ) {
+      this.pieces.push(data.slice(start, i));
+      this.parseElement(this.pieces.join(''), character, elements);
+      this.pieces = [];
+      start = i + 1;
+    } else if (character === ']' || character === '}') {
+      this.depth--;
+    }
+  }
+
+  if (this.state === ARRAY_STATE_INSIDE && start < data.length) {
+    this.pieces.push(data.slice(start));
+  }
+};
+
+ArrayStreamParser.prototype.parseElement = function(
+  data,
+  delimiter,
+  elements
+) {
+  if (delimiter === '}') {
+    throw new SyntaxError('Invalid format in array');
+  }
+
+  const parser = new Parser(
+    data,
+    this.maxDepth,
+    this.typedArrays,
+    null,
+    this.deduplicateStrings
+  );
+  parser.skipClutter();
+  if (parser.lookaheadIndex < parser.string.length) {
+    elements.push(parser.parseValue());
+    parser.ensureEndOfData();
+  } else if (delimiter === ',') {
+    elements.push(undefined);
+  }
+
+  if (delimiter === ']') {
+    this.state = ARRAY_STATE_AFTER;
+  }
+};
+
+// Parser counters are only collected by the native addon when it is built
+// with MDSF_ENABLE_STATS, the JavaScript implementation doesn't have them.
+const getStats = () => null;
+
+const resetStats = () => {};
+
 // Internal parser class
 //   string - a string to parse
+//   maxDepth - maximum nesting depth of arrays and objects
+//   typedArrays - return arrays of numbers as Int32Array or Float64Array
+//   keyDictionary - array of the keys that can be referred to as #<index>,
+//       the keys spelled out in full are appended to it, or null
+//   deduplicateStrings - return the same string for repeated short string
+//       values
+//   transcoding - return undefined values as UNDEFINED and objects as
+//       ObjectEntries, keeping everything that has been written
 //
-function Parser(string) {
+function Parser(
+  string,
+  maxDepth = DEFAULT_MAX_DEPTH,
+  typedArrays = false,
+  keyDictionary = null,
+  deduplicateStrings = false,
+  transcoding = false
+) {
   this.string = string;
   this.lookaheadIndex = 0;
+  this.maxDepth = maxDepth;
+  this.typedArrays = typedArrays;
+  this.keyDictionary = keyDictionary;
+  this.strings = deduplicateStrings ? new Map() : null;
+  this.undefinedValue = transcoding ? UNDEFINED : undefined;
+  this.transcoding = transcoding;
+  this.depth = 0;
 }
 
 // Start parsing
@@ -298,7 +937,8 @@ Parser.prototype.parseValue = function() {
   } else if (this.isLetter(look)) {
     return this.parseIdentifier();
   } else if (this.isQuoteCharacter(look)) {
-    return this.parseString();
+    const string = this.parseString();
+    return this.strings === null ? string : this.deduplicateString(string);
   } else if (look === '[') {
     return this.parseArray();
   } else if (look === '{') {
@@ -308,6 +948,24 @@ Parser.prototype.parseValue = function() {
   }
 };
 
+// Get the string equal to a parsed one that has been returned earlier, so
+// that repeated values share memory
+//   string - parsed string value
+//
+Parser.prototype.deduplicateString = function(string) {
+  if (string.length > MAX_DEDUPLICATED_STRING_LENGTH) {
+    return string;
+  }
+  const existing = this.strings.get(string);
+  if (existing !== undefined) {
+    return existing;
+  }
+  if (this.strings.size < MAX_DEDUPLICATED_STRINGS) {
+    this.strings.set(string, string);
+  }
+  return string;
+};
+
 // Parse a number
 //
 Parser.prototype.parseNumber = function() {
@@ -434,7 +1092,7 @@ Parser.prototype.parseIdentifier = function() {
   }
 
   const matching = {
-    undefined,
+    undefined: this.undefinedValue,
     null: null,
     true: true,
     false: false,
@@ -606,11 +1264,21 @@ Parser.prototype.parseEs6UnicodeLiteral = function() {
   return String.fromCodePoint(code);
 };
 
+// Enter a nested array or object and throw an error if it is nested too
+// deeply
+//
+Parser.prototype.enterNested = function() {
+  if (++this.depth > this.maxDepth) {
+    throw new RangeError('Maximum nesting depth exceeded');
+  }
+};
+
 // Parse an array
 //
 Parser.prototype.parseArray = function() {
   this.skipClutter();
   this.match('[');
+  this.enterNested();
 
   const array = [];
 
@@ -618,7 +1286,7 @@ Parser.prototype.parseArray = function() {
     this.skipClutter();
 
     if (this.lookahead() === ',') {
-      array.push(undefined);
+      array.push(this.undefinedValue);
     } else if (this.lookahead() === ']') {
       break;
     } else {
@@ -633,8 +1301,9 @@ Parser.prototype.parseArray = function() {
   }
 
   this.match(']');
+  this.depth--;
 
-  return array;
+  return this.typedArrays ? toTypedArray(array) : array;
 };
 
 // Parse an object
@@ -642,16 +1311,19 @@ Parser.prototype.parseArray = function() {
 Parser.prototype.parseObject = function() {
   this.skipClutter();
 
-  const object = {};
+  const object = this.transcoding ? new ObjectEntries() : {};
 
   this.match('{');
+  this.enterNested();
 
   while (this.lookahead() !== '}') {
     const key = this.parseObjectKey();
     this.match(':');
     const value = this.parseValue();
 
-    if (value !== undefined) {
+    if (this.transcoding) {
+      object.push([key, value]);
+    } else if (value !== undefined) {
       object[key] = value;
     }
 
@@ -664,6 +1336,7 @@ Parser.prototype.parseObject = function() {
 
   this.skipClutter();
   this.match('}');
+  this.depth--;
 
   return object;
 };
@@ -673,24 +1346,276 @@ Parser.prototype.parseObject = function() {
 Parser.prototype.parseObjectKey = function() {
   this.skipClutter();
 
+  const dictionary = this.keyDictionary;
+  if (dictionary !== null && this.lookahead() === '#') {
+    return this.parseKeyReference();
+  }
+
+  let key = '';
   if (this.isQuoteCharacter(this.lookahead())) {
-    return this.parseString();
+    key = this.parseString();
+  } else {
+    if (!this.isInitialIdentifierCharacter(this.lookahead())) {
+      this.throwExpected('String or identifier');
+    }
+    while (this.isIdentifierCharacter(this.lookahead())) {
+      key += this.advance();
+    }
   }
 
-  if (!this.isInitialIdentifierCharacter(this.lookahead())) {
-    this.throwExpected('String or identifier');
+  if (dictionary !== null && dictionary.length < MAX_KEY_DICTIONARY_SIZE) {
+    dictionary.push(key);
   }
+  return key;
+};
 
-  let key = '';
-  while (this.isIdentifierCharacter(this.lookahead())) {
-    key += this.advance();
+// Parse a reference to a key from the key dictionary
+//
+Parser.prototype.parseKeyReference = function() {
+  this.match('#');
+  let digits = '';
+  while (this.isDecimalDigit(this.lookahead())) {
+    digits += this.advance();
   }
+  const index = digits === '' ? -1 : Number(digits);
+  if (index < 0 || index >= this.keyDictionary.length) {
+    this.throwError('Unknown key reference');
+  }
+  return this.keyDictionary[index];
+};
 
-  return key;
+// Value of undefined and elided array elements when transcoding
+const UNDEFINED = Symbol('undefined');
+
+// Properties of an object in the order they have been written in, including
+// the repeated ones, when transcoding
+class ObjectEntries extends Array {}
+
+const UNDEFINED_POLICIES = ['omit', 'null', 'error'];
+const NON_FINITE_POLICIES = ['null', 'string', 'error'];
+
+// Get a policy of toJSON() from its options
+//   options - toJSON() options
+//   name - name of the option
+//   policies - valid values, the first one is the default
+//
+const getPolicy = (options, name, policies) => {
+  if (options === undefined || options[name] === undefined) {
+    return policies[0];
+  }
+  const policy = options[name];
+  if (!policies.includes(policy)) {
+    const last = policies.length - 1;
+    const names = policies.map(policy => `'${policy}'`);
+    throw new TypeError(
+      `${name} must be ${names.slice(0, last).join(', ')} or ${names[last]}`
+    );
+  }
+  return policy;
+};
+
+// Write a transcoded value as JSON
+//   value - value returned by Parser in the transcoding mode
+//   undefinedPolicy - what to write in place of undefined values
+//   nonFinitePolicy - what to write in place of NaN and Infinity
+//
+const writeJSON = (value, undefinedPolicy, nonFinitePolicy) => {
+  if (value === UNDEFINED) {
+    if (undefinedPolicy === 'error') {
+      throw new TypeError('undefined cannot be represented in JSON');
+    }
+    return 'null';
+  }
+  if (typeof value === 'number' && !Number.isFinite(value)) {
+    if (nonFinitePolicy === 'error') {
+      throw new TypeError('NaN and Infinity cannot be represented in JSON');
+    }
+    return nonFinitePolicy === 'string' ? `"${value}"` : 'null';
+  }
+  if (value instanceof ObjectEntries) {
+    const properties = [];
+    for (let i = 0; i < value.length; i++) {
+      const property = value[i];
+      if (property[1] === UNDEFINED && undefinedPolicy === 'omit') continue;
+      properties.push(
+        JSON.stringify(property[0]) +
+          ':' +
+          writeJSON(property[1], undefinedPolicy, nonFinitePolicy)
+      );
+    }
+    return '{' + properties.join(',') + '}';
+  }
+  if (Array.isArray(value)) {
+    const elements = value.map(element =>
+      writeJSON(element, undefinedPolicy, nonFinitePolicy)
+    );
+    return '[' + elements.join(',') + ']';
+  }
+  return JSON.stringify(value);
+};
+
+// Convert MDSF data into JSON without creating the objects of the data
+//   data - string or Buffer to convert
+//   options - optional object:
+//     maxDepth - maximum nesting depth of arrays and objects
+//     dialect - grammar of the data, either 'mdsf' (default) or 'json'
+//     undefined - what to write in place of undefined values: 'omit'
+//         (default) skips object properties, writes null in arrays and
+//         throws a TypeError for a top-level undefined, 'null' writes null
+//         everywhere and 'error' throws a TypeError
+//     nonFinite - what to write in place of NaN and Infinity: 'null'
+//         (default), 'string' or 'error'
+// Returns a Buffer with the JSON. Object keys are written in the order they
+// are written in the data, repeated ones included.
+//
+const toJSON = (data, options) => {
+  if (Buffer.isBuffer(data)) {
+    data = decodeUtf8(data);
+  }
+
+  const maxDepth = getMaxDepth(options);
+  const dialect = getDialect(options);
+  const undefinedPolicy = getPolicy(options, 'undefined', UNDEFINED_POLICIES);
+  const nonFinitePolicy = getPolicy(
+    options,
+    'nonFinite',
+    NON_FINITE_POLICIES
+  );
+  if (dialect === 'json') {
+    // Only check the grammar, JSON.parse() would reorder the keys.
+    JSON.parse(data);
+  }
+  const parser = new Parser(data, maxDepth, false, null, false, true);
+  const value = parser.parse();
+  if (value === UNDEFINED && undefinedPolicy === 'omit') {
+    // JSON.stringify() returns undefined here, there is no JSON to write.
+    throw new TypeError('Top-level undefined cannot be represented in JSON');
+  }
+  return Buffer.from(writeJSON(value, undefinedPolicy, nonFinitePolicy));
+};
+
+// Get the maximum size of data in bytes from validation limits
+//   limits - validate() limits
+//
+const getMaxSize = limits => {
+  if (limits === undefined || limits.maxSize === undefined) {
+    return Infinity;
+  }
+  const maxSize = limits.maxSize;
+  if (!Number.isInteger(maxSize) || maxSize < 0) {
+    throw new TypeError('maxSize must be a non-negative integer');
+  }
+  return maxSize;
+};
+
+// Count the values of a transcoded value into validation statistics
+//   value - value returned by Parser in the transcoding mode
+//   stats - statistics to update
+//   depth - nesting depth of the value
+//
+const countValues = (value, stats, depth) => {
+  stats.values++;
+  if (typeof value === 'string') {
+    stats.strings++;
+  } else if (typeof value === 'number') {
+    stats.numbers++;
+  } else if (Array.isArray(value)) {
+    depth++;
+    if (depth > stats.depth) stats.depth = depth;
+    if (value instanceof ObjectEntries) {
+      stats.objects++;
+      stats.keys += value.length;
+      value.forEach(property => countValues(property[1], stats, depth));
+    } else {
+      stats.arrays++;
+      value.forEach(element => countValues(element, stats, depth));
+    }
+  }
+};
+
+// Check that data is well-formed without keeping the objects of the data
+//   data - string or Buffer to check
+//   limits - optional object:
+//     maxSize - maximum size of the data in bytes
+//     maxDepth - maximum nesting depth of arrays and objects
+//     dialect - grammar of the data, either 'mdsf' (default) or 'json'
+// Returns an object with `valid: true`, the size of the data in bytes and
+// the counts of the values, or with `valid: false`, the size and the type,
+// message and byte offset of the error.
+//
+const validate = (data, limits) => {
+  const maxSize = getMaxSize(limits);
+  const maxDepth = getMaxDepth(limits);
+  const dialect = getDialect(limits);
+
+  const isBuffer = Buffer.isBuffer(data);
+  const size = isBuffer ? data.length : Buffer.byteLength(data);
+  const fail = (type, message, offset) => ({
+    valid: false,
+    size,
+    type,
+    message,
+    offset,
+  });
+  if (size > maxSize) {
+    return fail('RangeError', 'Maximum size exceeded', maxSize);
+  }
+  if (isBuffer) {
+    const buffer = data;
+    data = buffer.toString();
+    const position = findInvalidUtf8(buffer, data);
+    if (position !== -1) {
+      return fail('SyntaxError', 'Invalid UTF-8 sequence', position);
+    }
+  }
+
+  const byteOffset = index =>
+    Buffer.byteLength(data.slice(0, Math.min(index, data.length)));
+  if (dialect === 'json') {
+    try {
+      JSON.parse(data);
+    } catch (error) {
+      const match = /position (\d+)/.exec(error.message);
+      const index = match ? Number(match[1]) : 0;
+      return fail(error.name, error.message, byteOffset(index));
+    }
+  }
+  const parser = new Parser(data, maxDepth, false, null, false, true);
+  let value;
+  try {
+    value = parser.parse();
+  } catch (error) {
+    return fail(error.name, error.message, byteOffset(parser.lookaheadIndex));
+  }
+
+  const stats = {
+    valid: true,
+    size,
+    depth: 0,
+    values: 0,
+    arrays: 0,
+    objects: 0,
+    keys: 0,
+    strings: 0,
+    numbers: 0,
+  };
+  countValues(value, stats, 0);
+  return stats;
 };
 
 module.exports = {
   stringify,
+  stringifyNumbers: stringify.stringifyNumbers,
+  stringifyString: stringify.stringifyString,
+  stringifyJSTPMessages: stringify.stringifyJSTPMessages,
+  KeyDictionary: stringify.KeyDictionary,
   parse,
   parseJSTPMessages,
+  toJSON,
+  validate,
+  MessageStream,
+  ArrayStreamParser,
+  MessageCache,
+  getStats,
+  resetStats,
 };
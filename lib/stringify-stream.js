@@ -0,0 +1,77 @@
+'use strict';
+
+const Readable = require('stream').Readable;
+
+const DEFAULT_CHUNK_SIZE = 16384;
+
+// Readable stream of the serialization of a value, which is produced
+// incrementally so that memory usage is bounded by the size of the chunks
+// and of the largest scalar value rather than by the size of the whole
+// output. Every chunk is serialized in a separate turn of the event loop.
+//   parts - iterator over the parts of the serialization, created by
+//       stringifyParts()
+//   options - stream options, `highWaterMark` is also the maximal size of
+//       the chunks in bytes, `objectMode` is never set
+//
+class StringifyStream extends Readable {
+  constructor(parts, options) {
+    super(Object.assign({}, options, { objectMode: false }));
+    this.parts = parts;
+    this.chunkSize =
+      options && options.highWaterMark > 0
+        ? options.highWaterMark
+        : DEFAULT_CHUNK_SIZE;
+    // Serialized data not pushed yet, null if there is none
+    this.pending = null;
+    this.done = false;
+    this.scheduled = false;
+  }
+
+  _read() {
+    if (this.scheduled) return;
+    this.scheduled = true;
+    setImmediate(() => {
+      this.scheduled = false;
+      let chunk;
+      try {
+        chunk = this.nextChunk();
+      } catch (error) {
+        this.emit('error', error);
+        return;
+      }
+      this.push(chunk);
+    });
+  }
+
+  // Get the next chunk of at most `chunkSize` bytes, or null at the end.
+  nextChunk() {
+    if (this.pending === null || this.pending.length < this.chunkSize) {
+      const pendingLength = this.pending === null ? 0 : this.pending.length;
+      // The length of a string never exceeds its size in UTF-8.
+      let text = '';
+      while (!this.done && pendingLength + text.length < this.chunkSize) {
+        const part = this.parts.next();
+        if (part.done) {
+          this.done = true;
+        } else {
+          text += part.value;
+        }
+      }
+      if (text !== '') {
+        const data = Buffer.from(text);
+        this.pending =
+          this.pending === null ? data : Buffer.concat([this.pending, data]);
+      }
+    }
+
+    if (this.pending === null) return null;
+    const chunk = this.pending.slice(0, this.chunkSize);
+    this.pending =
+      this.pending.length > this.chunkSize
+        ? this.pending.slice(this.chunkSize)
+        : null;
+    return chunk;
+  }
+}
+
+module.exports = StringifyStream;
@@ -8,6 +8,77 @@ const objectToScalarConverters = {
   '[object Boolean]': x => Boolean(x),
 };
 
+const MESSAGE_TERMINATOR = '\0';
+
+const TYPED_ARRAY_TAGS = new Set([
+  '[object Int8Array]',
+  '[object Uint8Array]',
+  '[object Uint8ClampedArray]',
+  '[object Int16Array]',
+  '[object Uint16Array]',
+  '[object Int32Array]',
+  '[object Uint32Array]',
+  '[object Float32Array]',
+  '[object Float64Array]',
+]);
+
+// TypedArrays that the native stringifyNumbers() serializes faster than the
+// JavaScript loop. Reading the elements of plain arrays through the V8 API
+// costs more than the loop itself, and V8 converts doubles to strings faster
+// than the native formatter.
+const NATIVE_NUMBERS_TAGS = new Set([
+  '[object Int8Array]',
+  '[object Uint8Array]',
+  '[object Uint8ClampedArray]',
+  '[object Int16Array]',
+  '[object Uint16Array]',
+  '[object Int32Array]',
+  '[object Uint32Array]',
+]);
+
+// Serialize an array or a TypedArray containing only numbers into an array
+// literal without whitespace, returns undefined if there is anything else in
+// it. The native addon provides a faster implementation of this function.
+//
+const stringifyNumbersJS = array => {
+  let result = '[';
+  for (let index = 0; index < array.length; index++) {
+    const value = array[index];
+    if (typeof value !== 'number') {
+      return undefined;
+    }
+    if (index !== 0) {
+      result += ',';
+    }
+    result += value + '';
+  }
+  return result + ']';
+};
+
+// Serialize a string into a single-quoted string literal. The native addon
+// provides a faster implementation of this function.
+//
+const stringifyStringJS = string => {
+  const content = JSON.stringify(string).slice(1, -1);
+  return `'${content.replace(/'/g, "\\'")}'`;
+};
+
+const JS_IMPL = {
+  stringifyNumbers: stringifyNumbersJS,
+  stringifyString: stringifyStringJS,
+};
+
+// Implementation of the functions above used by the current stringify() call.
+let impl = JS_IMPL;
+
+// Serialize an array containing only numbers with the faster of the
+// implementations, returns undefined if there is anything else in it.
+//
+const stringifyNumbers = array =>
+  NATIVE_NUMBERS_TAGS.has(getObjString(array))
+    ? impl.stringifyNumbers(array)
+    : stringifyNumbersJS(array);
+
 const STRINGIFIERS = {
   number: number => number + '',
   boolean: boolean => (boolean ? 'true' : 'false'),
@@ -15,12 +86,20 @@ const STRINGIFIERS = {
   null: () => 'null',
   buffer: buf => `'${buf.toString('base64')}'`,
 
-  string(string) {
-    const content = JSON.stringify(string).slice(1, -1);
-    return `'${content.replace(/'/g, "\\'")}'`;
-  },
+  string: string => impl.stringifyString(string),
 
   array(array, replacer, space, startIndent) {
+    if (
+      !space &&
+      typeof replacer !== 'function' &&
+      typeof array[0] === 'number'
+    ) {
+      const result = stringifyNumbers(array);
+      if (result !== undefined) {
+        return result;
+      }
+    }
+
     let result = '[';
 
     const indent = startIndent + space;
@@ -73,6 +152,10 @@ const STRINGIFIERS = {
 
     for (let i = 0; i < objectKeys.length; i++) {
       let key = objectKeys[i];
+      // The key has to be added to the dictionary before the keys of its
+      // value, in the same order the receiving side sees them.
+      const reference =
+        keyDictionary === null ? undefined : keyDictionary.encode(key);
       const value = stringifyInternal(
         object[key],
         replacer,
@@ -83,10 +166,15 @@ const STRINGIFIERS = {
       );
 
       if (value === '' || value === 'undefined') {
+        if (keyDictionary !== null && reference === undefined) {
+          keyDictionary.discard(key);
+        }
         continue;
       }
 
-      if (!/^[a-zA-Z_$][\w$]*$/.test(key)) {
+      if (reference !== undefined) {
+        key = '#' + reference;
+      } else if (!/^[a-zA-Z_$][\w$]*$/.test(key)) {
         key = STRINGIFIERS.string(key);
       }
 
@@ -115,7 +203,10 @@ const STRINGIFIERS = {
   },
 };
 
-function stringifyInternal(value, replacer, space, indent, key = '', holder) {
+// Get the value to be serialized in place of `value`, i.e. the result of its
+// toMDSF() or toJSON() method and of the replacer function.
+//
+const resolveValue = (value, replacer, key, holder) => {
   if (typeof value === 'object' && value !== null) {
     if (typeof value.toMDSF === 'function') {
       value = value.toMDSF(key);
@@ -126,21 +217,182 @@ function stringifyInternal(value, replacer, space, indent, key = '', holder) {
   if (typeof replacer === 'function') {
     value = replacer.call(holder ? holder : { '': value }, key, value);
   }
-  let type;
+  return value;
+};
+
+// Get the name of the function in STRINGIFIERS serializing `value`.
+//
+const getType = value => {
   if (Array.isArray(value)) {
-    type = 'array';
+    return 'array';
   } else if (Buffer.isBuffer(value)) {
-    type = 'buffer';
+    return 'buffer';
+  } else if (TYPED_ARRAY_TAGS.has(getObjString(value))) {
+    return 'array';
   } else if (value === null) {
-    type = 'null';
-  } else {
-    type = typeof value;
+    return 'null';
   }
+  return typeof value;
+};
 
+// Serialize a value returned by resolveValue().
+//
+const stringifyResolved = (value, type, replacer, space, indent) => {
   const stringifier = STRINGIFIERS[type];
   if (stringifier) return stringifier(value, replacer, space, indent);
-
   return '';
+};
+
+function stringifyInternal(value, replacer, space, indent, key = '', holder) {
+  value = resolveValue(value, replacer, key, holder);
+  return stringifyResolved(value, getType(value), replacer, space, indent);
+}
+
+// Number of array elements serialized with a single stringifyNumbers() call
+// by stringifyParts().
+const NUMBERS_SLICE_LENGTH = 4096;
+
+// Length of the serialized text above which stringifyParts() yields it
+// without waiting for a nested array or object.
+const PART_LENGTH = 4096;
+
+// Check whether a resolved value of the given type is serialized element by
+// element by stringifyParts().
+//
+const isContainer = (value, type) =>
+  type === 'array' ||
+  (type === 'object' && !objectToScalarConverters[getObjString(value)]);
+
+// The generators below produce the same output as STRINGIFIERS.array() and
+// STRINGIFIERS.object() in parts, without a key dictionary: arrays and
+// objects are traversed element by element, so that no part is much longer
+// than PART_LENGTH except for the serialization of a scalar value or of a
+// slice of an array of numbers.
+//
+function* stringifyResolvedParts(value, type, replacer, space, indent) {
+  if (type === 'array') {
+    yield* stringifyArrayParts(value, replacer, space, indent);
+  } else if (isContainer(value, type)) {
+    yield* stringifyObjectParts(value, replacer, space, indent);
+  } else {
+    yield stringifyResolved(value, type, replacer, space, indent);
+  }
+}
+
+function* stringifyArrayParts(array, replacer, space, startIndent) {
+  // stringifyNumbers() returns the same as the generic serialization of the
+  // elements for the slices that only contain numbers.
+  const useNumbers = !space && typeof replacer !== 'function';
+  const indent = startIndent + space;
+  const len = array.length;
+  let isNotEmpty = false;
+  let result = '[';
+
+  for (let index = 0; index < len; index++) {
+    if (useNumbers && index % NUMBERS_SLICE_LENGTH === 0) {
+      const end = Math.min(index + NUMBERS_SLICE_LENGTH, len);
+      const slice =
+        typeof array.subarray === 'function'
+          ? array.subarray(index, end)
+          : array.slice(index, end);
+      const numbers = stringifyNumbers(slice);
+      if (numbers !== undefined) {
+        yield result + numbers.slice(1, -1) + (end !== len ? ',' : '');
+        result = '';
+        isNotEmpty = true;
+        index = end - 1;
+        continue;
+      }
+    }
+
+    let value = array[index];
+    if (value !== undefined) {
+      if (space) {
+        result += '\n' + indent;
+      }
+      value = resolveValue(value, replacer, index.toString(), array);
+      const type = getType(value);
+      if (isContainer(value, type)) {
+        yield result;
+        result = '';
+        yield* stringifyResolvedParts(value, type, replacer, space, indent);
+      } else {
+        result += stringifyResolved(value, type, replacer, space, indent);
+      }
+      isNotEmpty = true;
+    }
+
+    if (index !== len - 1) {
+      result += ',';
+      isNotEmpty = true;
+    }
+    if (result.length > PART_LENGTH) {
+      yield result;
+      result = '';
+    }
+  }
+
+  if (space && isNotEmpty) {
+    result += '\n' + startIndent;
+  }
+  yield result + ']';
+}
+
+function* stringifyObjectParts(object, replacer, space, startIndent) {
+  let firstKey = true;
+
+  let objectKeys = Object.keys(object);
+  if (Array.isArray(replacer)) {
+    objectKeys = objectKeys.filter(key => replacer.includes(key));
+  }
+  const indent = startIndent + space;
+  let result = '{';
+
+  for (let i = 0; i < objectKeys.length; i++) {
+    let key = objectKeys[i];
+    const value = resolveValue(object[key], replacer, key, object);
+    const type = getType(value);
+    // Arrays and objects are never serialized as '' or 'undefined', so
+    // their key can be written before them.
+    const container = isContainer(value, type);
+    let serialized = null;
+    if (!container) {
+      serialized = stringifyResolved(value, type, replacer, space, indent);
+      if (serialized === '' || serialized === 'undefined') {
+        continue;
+      }
+    }
+
+    if (!/^[a-zA-Z_$][\w$]*$/.test(key)) {
+      key = STRINGIFIERS.string(key);
+    }
+
+    if (!firstKey) {
+      result += ',';
+    }
+    firstKey = false;
+    if (space) {
+      result += '\n' + indent;
+    }
+    result += key + (space ? ': ' : ':');
+
+    if (container) {
+      yield result;
+      result = '';
+      yield* stringifyResolvedParts(value, type, replacer, space, indent);
+    } else {
+      result += serialized;
+    }
+    if (result.length > PART_LENGTH) {
+      yield result;
+      result = '';
+    }
+  }
+
+  if (space && !firstKey) {
+    result += '\n' + startIndent;
+  }
+  yield result + '}';
 }
 
 const filterReplacer = replacer =>
@@ -158,7 +410,10 @@ const filterReplacer = replacer =>
     })
     .map(prop => String(prop));
 
-function stringify(value, replacer, space = '') {
+// Normalize the arguments of stringify()
+//   Returns an array of the replacer and the indentation string
+//
+const normalizeArgs = (replacer, space) => {
   if (space) {
     if (typeof space === 'object') {
       const objStr = getObjString(space);
@@ -180,8 +435,134 @@ function stringify(value, replacer, space = '') {
   if (Array.isArray(replacer)) {
     replacer = filterReplacer(replacer);
   }
+  return [replacer, space];
+};
 
+function stringify(value, replacer, space = '') {
+  [replacer, space] = normalizeArgs(replacer, space);
   return stringifyInternal(value, replacer, space, '');
 }
 
+// Serialize a value the same way as stringify() does, in parts
+//   Returns an iterator over the parts
+//
+function* stringifyParts(value, replacer, space = '') {
+  [replacer, space] = normalizeArgs(replacer, space);
+  value = resolveValue(value, replacer, '');
+  yield* stringifyResolvedParts(value, getType(value), replacer, space, '');
+}
+
+// Maximum number of keys in a KeyDictionary, the keys sent after it is full
+// are always spelled out in full. Must be the same as on the receiving side.
+const MAX_KEY_DICTIONARY_SIZE = 65536;
+
+// Dictionary of the object keys sent over a connection. Once a key has been
+// sent, it is written as #<index> in the following messages serialized with
+// the same dictionary. The receiving MessageStream has to be created with
+// the keyDictionary option and must receive all the messages in order.
+//
+class KeyDictionary {
+  constructor() {
+    this.indices = new Map();
+  }
+
+  // Get the index of a key sent earlier, or add it to the dictionary
+  //   key - object key
+  //   Returns the index or undefined if the key has to be sent in full
+  //
+  encode(key) {
+    const index = this.indices.get(key);
+    if (index === undefined && this.indices.size < MAX_KEY_DICTIONARY_SIZE) {
+      this.indices.set(key, this.indices.size);
+    }
+    return index;
+  }
+
+  // Remove a key just added by encode() which is not going to be sent
+  //   key - object key
+  //
+  discard(key) {
+    if (this.indices.get(key) === this.indices.size - 1) {
+      this.indices.delete(key);
+    }
+  }
+}
+
+// Key dictionary used by the current stringify() call, if any.
+let keyDictionary = null;
+
+// Call a serialization function using the given implementation of the
+// functions above and key dictionary.
+//   implementation - object with stringifyNumbers() and stringifyString()
+//   dictionary - KeyDictionary or null
+//   fn - stringify() or a method of an iterator created by stringifyParts()
+//   args - arguments of `fn`
+//
+const callWith = (implementation, dictionary, fn, args) => {
+  const previousImpl = impl;
+  const previousDictionary = keyDictionary;
+  impl = implementation;
+  keyDictionary = dictionary;
+  try {
+    return fn(...args);
+  } finally {
+    impl = previousImpl;
+    keyDictionary = previousDictionary;
+  }
+};
+
+// Create a stringify() function that uses stringifyNumbers() and
+// stringifyString() provided by `implementation`, which must behave exactly
+// as the JavaScript ones.
+//
+const createStringify = implementation => (...args) =>
+  callWith(implementation, null, stringify, args);
+
+// Create a function with the arguments of stringify() returning an iterator
+// over the parts of the serialization, see stringifyParts(). Every step of
+// the iterator uses the functions provided by `implementation`.
+//
+const createStringifyParts = implementation => (...args) => {
+  const parts = stringifyParts(...args);
+  return {
+    next: () => callWith(implementation, null, () => parts.next(), []),
+    [Symbol.iterator]() {
+      return this;
+    },
+  };
+};
+
+// Create a function serializing an array of JSTP messages into a single
+// Buffer, with each message followed by the terminator expected by
+// parseJSTPMessages(), ready to be written to a socket at once. The keys
+// are compressed if a KeyDictionary of the connection is passed as the
+// second argument.
+//
+const createStringifyJSTPMessages = implementation => (
+  messages,
+  dictionary = null
+) => {
+  if (!Array.isArray(messages)) {
+    throw new TypeError('Messages must be an array');
+  }
+  if (dictionary !== null && !(dictionary instanceof KeyDictionary)) {
+    throw new TypeError('Dictionary must be a KeyDictionary');
+  }
+  let result = '';
+  for (let i = 0; i < messages.length; i++) {
+    result +=
+      callWith(implementation, dictionary, stringify, [messages[i]]) +
+      MESSAGE_TERMINATOR;
+  }
+  return Buffer.from(result);
+};
+
 module.exports = stringify;
+module.exports.stringifyNumbers = stringifyNumbersJS;
+module.exports.stringifyString = stringifyStringJS;
+module.exports.stringifyJSTPMessages = createStringifyJSTPMessages(JS_IMPL);
+module.exports.stringifyParts = createStringifyParts(JS_IMPL);
+module.exports.createStringify = createStringify;
+module.exports.createStringifyParts = createStringifyParts;
+module.exports.createStringifyJSTPMessages = createStringifyJSTPMessages;
+module.exports.KeyDictionary = KeyDictionary;
@@ -0,0 +1,148 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef SRC_CHAR_CLASS_H_
+#define SRC_CHAR_CLASS_H_
+
+#include <cstdint>
+
+namespace mdsf {
+
+namespace char_class {
+
+// Classes of bytes used by the tokenizer. A byte may belong to several
+// classes at once.
+enum CharClass : std::uint16_t {
+  // Single-byte white space characters: \t \v \f space and a lone 0xA0.
+  kWhiteSpace = 1 << 0,
+  // Single-byte line terminators: \n \r.
+  kLineTerminator = 1 << 1,
+  // First bytes of the multibyte white space characters and line
+  // terminators. The following bytes have to be checked as well.
+  kUnicodeSpaceLead = 1 << 2,
+  // White space allowed in JSON: \t \n \r space.
+  kJsonWhiteSpace = 1 << 3,
+  kDigit = 1 << 4,
+  kHexDigit = 1 << 5,
+  // ASCII characters that may start or continue unquoted object keys. The
+  // rest are handled by decoding code points and looking them up in the
+  // Unicode tables.
+  kIdentifierStart = 1 << 6,
+  kIdentifierPart = 1 << 7,
+  // Characters delimiting values: { } [ ] : ,
+  kStructural = 1 << 8,
+  // Characters a value may start with in some dialect. The kind of the value
+  // is stored in the bits starting at kValueKindShift.
+  kValueStart = 1 << 9,
+  // The value start depends on the dialect or is a keyword that has to be
+  // checked further.
+  kCheckedValueStart = 1 << 10
+};
+
+// Kinds of values a character may start, in the order of parser::Type.
+enum ValueKind {
+  kUndefinedValue = 0,
+  kNullValue,
+  kBoolValue,
+  kNumberValue,
+  kStringValue,
+  kArrayValue,
+  kObjectValue
+};
+
+const int kValueKindShift = 12;
+
+namespace internal {
+
+constexpr bool IsIn(unsigned c, unsigned first, unsigned last) {
+  return c >= first && c <= last;
+}
+
+constexpr unsigned ValueStart(ValueKind kind, bool is_checked) {
+  return kValueStart | (is_checked ? kCheckedValueStart : 0) |
+         (static_cast<unsigned>(kind) << kValueKindShift);
+}
+
+constexpr unsigned ClassifyValueStart(unsigned c) {
+  return c == '{' ? ValueStart(kObjectValue, false) :
+         c == '[' ? ValueStart(kArrayValue, false) :
+         c == '"' ? ValueStart(kStringValue, false) :
+         c == '\'' ? ValueStart(kStringValue, true) :
+         c == 't' || c == 'f' ? ValueStart(kBoolValue, false) :
+         c == 'n' ? ValueStart(kNullValue, true) :
+         c == 'u' || c == ',' || c == ']' ? ValueStart(kUndefinedValue, true) :
+         c == '-' || IsIn(c, '0', '9') ? ValueStart(kNumberValue, false) :
+         c == 'N' || c == 'I' || c == '.' || c == '+' ?
+             ValueStart(kNumberValue, true) :
+         0;
+}
+
+constexpr unsigned Classify(unsigned c) {
+  return (c == '\t' || c == '\v' || c == '\f' || c == ' ' || c == 0xA0 ?
+              kWhiteSpace : 0) |
+         (c == '\n' || c == '\r' ? kLineTerminator : 0) |
+         (c == 0xC2 || c == 0xE1 || c == 0xE2 || c == 0xE3 || c == 0xEF ?
+              kUnicodeSpaceLead : 0) |
+         (c == '\t' || c == '\n' || c == '\r' || c == ' ' ?
+              kJsonWhiteSpace : 0) |
+         (IsIn(c, '0', '9') ? kDigit | kHexDigit | kIdentifierPart : 0) |
+         (IsIn(c, 'A', 'F') || IsIn(c, 'a', 'f') ? kHexDigit : 0) |
+         (IsIn(c, 'A', 'Z') || IsIn(c, 'a', 'z') || c == '$' || c == '_' ?
+              kIdentifierStart | kIdentifierPart : 0) |
+         (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' ||
+          c == ',' ? kStructural : 0) |
+         ClassifyValueStart(c);
+}
+
+}  // namespace internal
+
+#define MDSF_CHAR_CLASS_4(c)                                                \
+  static_cast<std::uint16_t>(internal::Classify(c)),                        \
+  static_cast<std::uint16_t>(internal::Classify(c + 1)),                    \
+  static_cast<std::uint16_t>(internal::Classify(c + 2)),                    \
+  static_cast<std::uint16_t>(internal::Classify(c + 3))
+#define MDSF_CHAR_CLASS_16(c)                                               \
+  MDSF_CHAR_CLASS_4(c), MDSF_CHAR_CLASS_4(c + 4),                           \
+  MDSF_CHAR_CLASS_4(c + 8), MDSF_CHAR_CLASS_4(c + 12)
+#define MDSF_CHAR_CLASS_64(c)                                               \
+  MDSF_CHAR_CLASS_16(c), MDSF_CHAR_CLASS_16(c + 16),                        \
+  MDSF_CHAR_CLASS_16(c + 32), MDSF_CHAR_CLASS_16(c + 48)
+
+// Classes of every byte value, so that a character is classified with a
+// single load instead of a chain of comparisons or a call into the
+// locale-aware C library functions.
+constexpr std::uint16_t kCharClasses[256] = {
+  MDSF_CHAR_CLASS_64(0), MDSF_CHAR_CLASS_64(64),
+  MDSF_CHAR_CLASS_64(128), MDSF_CHAR_CLASS_64(192)
+};
+
+#undef MDSF_CHAR_CLASS_64
+#undef MDSF_CHAR_CLASS_16
+#undef MDSF_CHAR_CLASS_4
+
+inline std::uint16_t GetCharClasses(char c) {
+  return kCharClasses[static_cast<unsigned char>(c)];
+}
+
+inline bool IsDigit(char c) {
+  return GetCharClasses(c) & kDigit;
+}
+
+inline bool IsHexDigit(char c) {
+  return GetCharClasses(c) & kHexDigit;
+}
+
+// Returns the value of the hexadecimal digit `c`, which must be one.
+inline int HexDigitValue(char c) {
+  return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+}
+
+inline ValueKind GetValueKind(std::uint16_t classes) {
+  return static_cast<ValueKind>(classes >> kValueKindShift);
+}
+
+}  // namespace char_class
+
+}  // namespace mdsf
+
+#endif  // SRC_CHAR_CLASS_H_
@@ -0,0 +1,395 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#include "json_transcoder.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <node_buffer.h>
+#include <v8.h>
+
+#include "common.h"
+#include "number_format.h"
+#include "parser.h"
+#include "value_scanner.h"
+
+using std::size_t;
+
+using v8::Isolate;
+using v8::Local;
+using v8::MaybeLocal;
+using v8::Object;
+
+using mdsf::number_format::kMaxDoubleLength;
+using mdsf::number_format::WriteDouble;
+using mdsf::parser::internal::DecodedString;
+using mdsf::value_scanner::Error;
+using mdsf::value_scanner::ErrorType;
+
+namespace mdsf {
+
+namespace json_transcoder {
+
+static const char kHexDigits[] = "0123456789abcdef";
+
+// Growable buffer allocated with malloc(), so that it can be handed over to
+// a Buffer without copying.
+class Output {
+ public:
+  explicit Output(size_t capacity)
+      : data_(static_cast<char*>(std::malloc(capacity))),
+        length_(0),
+        capacity_(data_ != nullptr ? capacity : 0) {}
+
+  ~Output() { std::free(data_); }
+
+  Output(const Output&) = delete;
+  Output& operator=(const Output&) = delete;
+
+  // Returns the place to write at most `size` bytes to, or nullptr if the
+  // memory can't be allocated. The bytes are added by Commit().
+  char* Reserve(size_t size) {
+    if (capacity_ - length_ < size) {
+      size_t capacity = capacity_ * 2;
+      if (capacity < length_ + size) {
+        capacity = length_ + size;
+      }
+      char* data = static_cast<char*>(std::realloc(data_, capacity));
+      if (data == nullptr) {
+        return nullptr;
+      }
+      data_ = data;
+      capacity_ = capacity;
+    }
+    return data_ + length_;
+  }
+
+  void Commit(char* end) { length_ = end - data_; }
+
+  bool Append(const char* data, size_t size) {
+    char* out = Reserve(size);
+    if (out == nullptr) {
+      return false;
+    }
+    std::memcpy(out, data, size);
+    length_ += size;
+    return true;
+  }
+
+  size_t length() const { return length_; }
+
+  void Truncate(size_t length) { length_ = length; }
+
+  // Passes the ownership of the data to the caller.
+  char* Release() {
+    char* data = data_;
+    data_ = nullptr;
+    length_ = capacity_ = 0;
+    return data;
+  }
+
+ private:
+  char* data_;
+  size_t length_;
+  size_t capacity_;
+};
+
+// Returns true if the byte is written to JSON strings as is.
+static inline bool IsPlainStringByte(unsigned char c) {
+  return c >= 0x20 && c != '"' && c != '\\';
+}
+
+// Handler of value_scanner::Scan() writing the tokens as JSON.
+class JsonWriter {
+ public:
+  JsonWriter(const TranscodeOptions& options, size_t capacity)
+      : options_(options),
+        output_(capacity),
+        key_offset_(0),
+        key_was_empty_(false),
+        error_message_(nullptr),
+        error_type_(ErrorType::kTypeError) {}
+
+  bool StartArray() {
+    return BeginValue() && Write("[", 1) && Push(false);
+  }
+
+  bool EndArray() {
+    containers_.pop_back();
+    return Write("]", 1);
+  }
+
+  bool StartObject() {
+    return BeginValue() && Write("{", 1) && Push(true);
+  }
+
+  bool EndObject() {
+    containers_.pop_back();
+    return Write("}", 1);
+  }
+
+  bool Key(const DecodedString& key) {
+    return BeginKey() && WriteString(key.data, key.length) && Write(":", 1);
+  }
+
+  bool NumericKey(double key) {
+    // Numeric keys are converted to strings the same way as numbers are.
+    char digits[kMaxDoubleLength];
+    char* digits_end = WriteDouble(key, digits);
+    return BeginKey() && WriteString(digits, digits_end - digits) &&
+           Write(":", 1);
+  }
+
+  bool Undefined() {
+    switch (options_.undefined_policy) {
+      case UndefinedPolicy::kError: {
+        return Fail("undefined cannot be represented in JSON");
+      }
+      case UndefinedPolicy::kOmit: {
+        if (containers_.empty()) {
+          return Fail("Top-level undefined cannot be represented in JSON");
+        }
+        if (containers_.back().is_object) {
+          // Take the key back.
+          output_.Truncate(key_offset_);
+          containers_.back().is_empty = key_was_empty_;
+          return true;
+        }
+        break;
+      }
+      case UndefinedPolicy::kNull: {
+        break;
+      }
+    }
+    return Null();
+  }
+
+  bool Null() {
+    return BeginValue() && Write("null", 4);
+  }
+
+  bool Bool(bool value) {
+    return BeginValue() &&
+           (value ? Write("true", 4) : Write("false", 5));
+  }
+
+  bool Number(double value) {
+    if (!std::isfinite(value)) {
+      switch (options_.non_finite_policy) {
+        case NonFinitePolicy::kError: {
+          return Fail("NaN and Infinity cannot be represented in JSON");
+        }
+        case NonFinitePolicy::kString: {
+          char name[kMaxDoubleLength];
+          char* name_end = WriteDouble(value, name);
+          return BeginValue() && WriteString(name, name_end - name);
+        }
+        case NonFinitePolicy::kNull: {
+          return Null();
+        }
+      }
+    }
+    if (!BeginValue()) {
+      return false;
+    }
+    char* out = output_.Reserve(kMaxDoubleLength);
+    if (out == nullptr) {
+      return OutOfMemory();
+    }
+    output_.Commit(WriteDouble(value, out));
+    return true;
+  }
+
+  bool String(const DecodedString& value) {
+    return BeginValue() && WriteString(value.data, value.length);
+  }
+
+  Error GetError() const {
+    Error error;
+    error.type = error_type_;
+    error.message = error_message_;
+    error.offset = 0;
+    return error;
+  }
+
+  Output* output() { return &output_; }
+
+ private:
+  struct Container {
+    bool is_object;
+    bool is_empty;
+  };
+
+  bool Push(bool is_object) {
+    Container container;
+    container.is_object = is_object;
+    container.is_empty = true;
+    containers_.push_back(container);
+    return true;
+  }
+
+  // Writes the comma before an array element.
+  bool BeginValue() {
+    if (containers_.empty() || containers_.back().is_object) {
+      return true;
+    }
+    Container& container = containers_.back();
+    if (container.is_empty) {
+      container.is_empty = false;
+      return true;
+    }
+    return Write(",", 1);
+  }
+
+  // Writes the comma before an object key and remembers where the key
+  // starts, so that it can be taken back if the value is omitted.
+  bool BeginKey() {
+    Container& container = containers_.back();
+    key_offset_ = output_.length();
+    key_was_empty_ = container.is_empty;
+    if (container.is_empty) {
+      container.is_empty = false;
+      return true;
+    }
+    return Write(",", 1);
+  }
+
+  bool Write(const char* data, size_t size) {
+    return output_.Append(data, size) || OutOfMemory();
+  }
+
+  // Writes UTF-8 data as a JSON string literal. Decoded strings never
+  // contain surrogates, lone ones are replaced with U+FFFD by the parser.
+  bool WriteString(const char* data, size_t length) {
+    const unsigned char* current = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* end = current + length;
+    if (!Write("\"", 1)) {
+      return false;
+    }
+    while (current < end) {
+      const unsigned char* plain = current;
+      while (current < end && IsPlainStringByte(*current)) {
+        current++;
+      }
+      if (current != plain &&
+          !Write(reinterpret_cast<const char*>(plain), current - plain)) {
+        return false;
+      }
+      if (current == end) {
+        break;
+      }
+
+      unsigned char code = *current++;
+      char* out = output_.Reserve(6);
+      if (out == nullptr) {
+        return OutOfMemory();
+      }
+      *out++ = '\\';
+      switch (code) {
+        case '"':
+        case '\\': {
+          *out++ = static_cast<char>(code);
+          break;
+        }
+        case '\b': {
+          *out++ = 'b';
+          break;
+        }
+        case '\f': {
+          *out++ = 'f';
+          break;
+        }
+        case '\n': {
+          *out++ = 'n';
+          break;
+        }
+        case '\r': {
+          *out++ = 'r';
+          break;
+        }
+        case '\t': {
+          *out++ = 't';
+          break;
+        }
+        default: {
+          *out++ = 'u';
+          *out++ = '0';
+          *out++ = '0';
+          *out++ = kHexDigits[code >> 4];
+          *out++ = kHexDigits[code & 0x0F];
+        }
+      }
+      output_.Commit(out);
+    }
+    return Write("\"", 1);
+  }
+
+  bool Fail(const char* message) {
+    error_type_ = ErrorType::kTypeError;
+    error_message_ = message;
+    return false;
+  }
+
+  bool OutOfMemory() {
+    error_type_ = ErrorType::kRangeError;
+    error_message_ = "Out of memory";
+    return false;
+  }
+
+  const TranscodeOptions& options_;
+  Output output_;
+  std::vector<Container> containers_;
+  size_t key_offset_;
+  bool key_was_empty_;
+  const char* error_message_;
+  ErrorType error_type_;
+};
+
+static void FreeOutput(char* data, void* hint) {
+  std::free(data);
+}
+
+MaybeLocal<Object> TranscodeToJson(Isolate*                isolate,
+                                   const char*             str,
+                                   size_t                  length,
+                                   const TranscodeOptions& options) {
+  // JSON is rarely much longer than the data it is converted from.
+  JsonWriter writer(options, length + 16);
+  Error error;
+  bool is_valid = options.dialect == parser::Dialect::kJson ?
+      value_scanner::Scan<parser::JsonDialect>(
+          str, str + length, options.max_depth, &writer, &error) :
+      value_scanner::Scan<parser::MdsfDialect>(
+          str, str + length, options.max_depth, &writer, &error);
+  if (!is_valid) {
+    switch (error.type) {
+      case ErrorType::kSyntaxError: {
+        THROW_EXCEPTION(SyntaxError, error.message);
+        break;
+      }
+      case ErrorType::kTypeError: {
+        THROW_EXCEPTION(TypeError, error.message);
+        break;
+      }
+      case ErrorType::kRangeError: {
+        THROW_EXCEPTION(RangeError, error.message);
+        break;
+      }
+    }
+    return MaybeLocal<Object>();
+  }
+
+  Output* output = writer.output();
+  size_t output_length = output->length();
+  char* data = output->Release();
+  // The data is freed by FreeOutput() even if the Buffer can't be created.
+  return node::Buffer::New(isolate, data, output_length, FreeOutput, nullptr);
+}
+
+}  // namespace json_transcoder
+
+}  // namespace mdsf
@@ -0,0 +1,71 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef SRC_JSON_TRANSCODER_H_
+#define SRC_JSON_TRANSCODER_H_
+
+#include <cstddef>
+
+#include <v8.h>
+
+#include "parser.h"
+
+namespace mdsf {
+
+namespace json_transcoder {
+
+// What to write in place of undefined values, including elided array
+// elements.
+enum class UndefinedPolicy {
+  // null in arrays, object properties are skipped, the same as
+  // JSON.stringify(parse(data)) does. A top-level undefined, for which
+  // JSON.stringify() returns undefined rather than JSON, fails with a
+  // TypeError.
+  kOmit = 0,
+  // null everywhere, including object properties.
+  kNull,
+  // Fail with a TypeError.
+  kError
+};
+
+// What to write in place of NaN, Infinity and -Infinity.
+enum class NonFinitePolicy {
+  // null, the same as JSON.stringify() does.
+  kNull = 0,
+  // Strings "NaN", "Infinity" and "-Infinity".
+  kString,
+  // Fail with a TypeError.
+  kError
+};
+
+struct TranscodeOptions {
+  TranscodeOptions() : max_depth(parser::kDefaultMaxDepth),
+                       dialect(parser::Dialect::kMdsf),
+                       undefined_policy(UndefinedPolicy::kOmit),
+                       non_finite_policy(NonFinitePolicy::kNull) {}
+
+  // Maximum nesting depth of arrays and objects.
+  std::size_t max_depth;
+  // Grammar the data is read with.
+  parser::Dialect dialect;
+  UndefinedPolicy undefined_policy;
+  NonFinitePolicy non_finite_policy;
+};
+
+// Converts `length` bytes of MDSF data at `str` into strict JSON in a
+// single pass, without creating the JavaScript values, and returns it as a
+// Buffer. Comments and white space are dropped, strings are written in
+// double quotes with the escapes JSON.stringify() uses and numbers the way
+// Number.prototype.toString() writes them. Object keys are kept in the
+// order they are written in. Throws the same exception as parser::Parse()
+// if the data is malformed and returns an empty handle.
+v8::MaybeLocal<v8::Object> TranscodeToJson(v8::Isolate* isolate,
+                                           const char*  str,
+                                           std::size_t  length,
+                                           const TranscodeOptions& options);
+
+}  // namespace json_transcoder
+
+}  // namespace mdsf
+
+#endif  // SRC_JSON_TRANSCODER_H_
@@ -0,0 +1,214 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#include "message_cache.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <node_version.h>
+#include <v8.h>
+
+using std::size_t;
+using std::uint64_t;
+
+using v8::Array;
+using v8::Context;
+using v8::Isolate;
+using v8::Local;
+using v8::Object;
+using v8::Value;
+
+namespace mdsf {
+
+namespace message_cache {
+
+// Hashes 8 bytes at a time, the collisions are resolved by comparing the
+// messages anyway.
+static uint64_t HashMessage(const char* message, size_t length) {
+  const uint64_t kMultiplier = 0x9E3779B97F4A7C15ULL;
+  uint64_t hash = length * kMultiplier;
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, message + i, sizeof(word));
+    hash = ((hash << 5) | (hash >> 59)) ^ word;
+    hash *= kMultiplier;
+  }
+  if (i < length) {
+    uint64_t word = 0;
+    std::memcpy(&word, message + i, length - i);
+    hash = ((hash << 5) | (hash >> 59)) ^ word;
+    hash *= kMultiplier;
+  }
+  return hash ^ (hash >> 32);
+}
+
+// Adds `value` and the objects reachable from it to `objects` and returns
+// the number of values found, or a number greater than `max_node_count` if
+// there are more of them or some of them are typed arrays, which cannot be
+// frozen. Returns false if an exception has been thrown.
+static bool CollectObjects(Local<Context> context,
+                           Local<Object> value,
+                           size_t max_node_count,
+                           size_t* node_count,
+                           std::vector<Local<Object>>* objects) {
+  std::vector<Local<Value>> stack(1, value);
+  *node_count = 0;
+  while (!stack.empty() && *node_count <= max_node_count) {
+    Local<Value> node = stack.back();
+    stack.pop_back();
+    ++*node_count;
+    if (!node->IsObject()) {
+      continue;
+    }
+    if (node->IsArrayBufferView()) {
+      *node_count = max_node_count + 1;
+      break;
+    }
+    Local<Object> object = node.As<Object>();
+    objects->push_back(object);
+    Local<Array> names;
+    if (!object->GetOwnPropertyNames(context).ToLocal(&names)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < names->Length(); i++) {
+      Local<Value> name;
+      Local<Value> property;
+      if (!names->Get(context, i).ToLocal(&name) ||
+          !object->Get(context, name).ToLocal(&property)) {
+        return false;
+      }
+      stack.push_back(property);
+    }
+  }
+  return true;
+}
+
+// Returns false if an exception has been thrown.
+static bool Freeze(Isolate* isolate,
+                   Local<Context> context,
+                   Local<Object> object) {
+#if NODE_MODULE_VERSION >= 51
+  return object->SetIntegrityLevel(context, v8::IntegrityLevel::kFrozen)
+      .FromMaybe(false);
+#else
+  Local<Value> object_constructor;
+  Local<Value> freeze;
+  auto object_name = v8::String::NewFromUtf8(isolate, "Object");
+  auto freeze_name = v8::String::NewFromUtf8(isolate, "freeze");
+  if (!context->Global()->Get(context, object_name)
+           .ToLocal(&object_constructor) ||
+      !object_constructor.As<Object>()->Get(context, freeze_name)
+           .ToLocal(&freeze)) {
+    return false;
+  }
+  Local<Value> argv[] = {object};
+  return !freeze.As<v8::Function>()
+              ->Call(context, object_constructor, 1, argv)
+              .IsEmpty();
+#endif
+}
+
+MessageCache::MessageCache(size_t max_size)
+    : max_size_(max_size),
+      size_(0),
+      hits_(0),
+      misses_(0),
+      evictions_(0),
+      updates_(0) {}
+
+bool MessageCache::Lookup(Isolate* isolate,
+                          const char* message,
+                          size_t length,
+                          Local<Object>* result) {
+  auto found = index_.find(HashMessage(message, length));
+  if (found == index_.end() ||
+      found->second->message.size() != length ||
+      std::memcmp(found->second->message.data(), message, length) != 0) {
+    misses_++;
+    return false;
+  }
+  entries_.splice(entries_.begin(), entries_, found->second);
+  *result = Local<Object>::New(isolate, found->second->value);
+  hits_++;
+  return true;
+}
+
+bool MessageCache::Insert(Isolate* isolate,
+                          const char* message,
+                          size_t length,
+                          Local<Object> value) {
+  size_t max_entry_size = max_size_ / 16;
+  size_t entry_size = length + kEntryOverhead;
+  if (entry_size > max_entry_size) {
+    return true;
+  }
+
+  v8::HandleScope scope(isolate);
+  auto context = isolate->GetCurrentContext();
+  size_t max_node_count = (max_entry_size - entry_size) / kNodeSize;
+  size_t node_count;
+  std::vector<Local<Object>> objects;
+  if (!CollectObjects(context, value, max_node_count, &node_count,
+                      &objects)) {
+    return false;
+  }
+  if (node_count > max_node_count) {
+    return true;
+  }
+  for (auto object : objects) {
+    if (!Freeze(isolate, context, object)) {
+      return false;
+    }
+  }
+  entry_size += node_count * kNodeSize;
+
+  uint64_t hash = HashMessage(message, length);
+  auto found = index_.find(hash);
+  if (found != index_.end()) {
+    const std::string& previous = found->second->message;
+    if (previous.size() == length &&
+        std::memcmp(previous.data(), message, length) == 0) {
+      updates_++;
+    } else {
+      evictions_++;
+    }
+    Remove(found->second);
+  }
+
+  entries_.emplace_front();
+  Entry& entry = entries_.front();
+  entry.hash = hash;
+  entry.message.assign(message, length);
+  entry.value.Reset(isolate, value);
+  entry.size = entry_size;
+  index_[hash] = entries_.begin();
+  size_ += entry_size;
+
+  while (size_ > max_size_) {
+    Remove(std::prev(entries_.end()));
+    evictions_++;
+  }
+  return true;
+}
+
+void MessageCache::Clear() {
+  entries_.clear();
+  index_.clear();
+  size_ = 0;
+}
+
+void MessageCache::Remove(EntryList::iterator entry) {
+  size_ -= entry->size;
+  index_.erase(entry->hash);
+  entries_.erase(entry);
+}
+
+}  // namespace message_cache
+
+}  // namespace mdsf
@@ -0,0 +1,96 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef SRC_MESSAGE_CACHE_H_
+#define SRC_MESSAGE_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include <v8.h>
+
+namespace mdsf {
+
+namespace message_cache {
+
+// Default limit of the total size of the cached messages.
+const std::size_t kDefaultMaxSize = 1024 * 1024;
+
+// Bytes accounted for every entry in addition to the message and the values
+// parsed from it.
+const std::size_t kEntryOverhead = 64;
+
+// Estimated bytes retained by every value of a cached message, including the
+// objects and arrays themselves.
+const std::size_t kNodeSize = 32;
+
+// Cache of parsed messages keyed by their contents. Since the cached values
+// are shared by everyone who receives the same message, they are deeply
+// frozen before being stored. The size of an entry is the size of the message
+// plus an estimate of the memory retained by its values. When the total size
+// of the entries exceeds the limit, the least recently used ones are evicted.
+class MessageCache {
+ public:
+  explicit MessageCache(std::size_t max_size = kDefaultMaxSize);
+
+  // Returns true and sets `result` to the value parsed earlier from the
+  // same `length` bytes at `message`, or returns false.
+  bool Lookup(v8::Isolate* isolate,
+              const char* message,
+              std::size_t length,
+              v8::Local<v8::Object>* result);
+
+  // Deeply freezes `value` parsed from the `length` bytes at `message` and
+  // stores it, replacing the entry of the same message if there is one.
+  // Entries larger than a sixteenth of the cache and messages containing
+  // typed arrays, which cannot be frozen, are not stored. Returns false if an
+  // exception has been thrown.
+  bool Insert(v8::Isolate* isolate,
+              const char* message,
+              std::size_t length,
+              v8::Local<v8::Object> value);
+
+  // Removes all of the entries, the counters are kept.
+  void Clear();
+
+  std::size_t max_size() const { return max_size_; }
+  std::size_t size() const { return size_; }
+  std::size_t entry_count() const { return entries_.size(); }
+  std::uint64_t hits() const { return hits_; }
+  std::uint64_t misses() const { return misses_; }
+  std::uint64_t evictions() const { return evictions_; }
+  std::uint64_t updates() const { return updates_; }
+
+ private:
+  struct Entry {
+    std::uint64_t hash;
+    std::string message;
+    v8::Global<v8::Object> value;
+    std::size_t size;
+  };
+
+  // Most recently used entries go first.
+  typedef std::list<Entry> EntryList;
+
+  void Remove(EntryList::iterator entry);
+
+  std::size_t max_size_;
+  std::size_t size_;
+  EntryList entries_;
+  // Messages with colliding hashes are not cached simultaneously, the entry
+  // is evicted instead.
+  std::unordered_map<std::uint64_t, EntryList::iterator> index_;
+  std::uint64_t hits_;
+  std::uint64_t misses_;
+  std::uint64_t evictions_;
+  std::uint64_t updates_;
+};
+
+}  // namespace message_cache
+
+}  // namespace mdsf
+
+#endif  // SRC_MESSAGE_CACHE_H_
@@ -6,34 +6,122 @@
 #include "message_parser.h"
 
 #include <cstddef>
+#include <cstdio>
 #include <cstring>
+#include <string>
 
 #include <v8.h>
 
 #include "common.h"
+#include "parse_stats.h"
 #include "parser.h"
+#include "unicode_utils.h"
 
+using std::memchr;
 using std::size_t;
+using std::string;
 using std::strlen;
 
 using v8::Array;
+using v8::Integer;
 using v8::Isolate;
 using v8::Local;
+using v8::MaybeLocal;
+using v8::NewStringType;
+using v8::Number;
+using v8::Object;
 using v8::String;
+using v8::TryCatch;
+using v8::Value;
 
+using mdsf::message_cache::MessageCache;
+using mdsf::parser::ValueParser;
 using mdsf::parser::internal::ParseObject;
 using mdsf::parser::internal::SkipToNextToken;
+using mdsf::parser::internal::SkipToNextTokenInChunk;
 
 namespace mdsf {
 
 namespace message_parser {
 
+// Parses a single message between `begin` and `end`, which must be an object
+// optionally surrounded by white space and comments.
+static MaybeLocal<Value> ParseMessage(Isolate* isolate,
+                                      const char* begin,
+                                      const char* end,
+                                      const parser::ParseOptions& options) {
+  size_t skipped_size = SkipToNextToken(begin, end);
+  size_t parsed_message_size = 0;
+  if (begin[skipped_size] != '{') {
+    THROW_EXCEPTION(SyntaxError, "Invalid message type");
+    return MaybeLocal<Value>();
+  }
+  auto message_object = ParseObject(isolate,
+                                    begin + skipped_size,
+                                    end,
+                                    &parsed_message_size,
+                                    options);
+
+  if (message_object.IsEmpty()) {
+    return MaybeLocal<Value>();
+  }
+
+  parsed_message_size += skipped_size;
+  parsed_message_size += SkipToNextToken(begin + parsed_message_size, end);
+
+  if (parsed_message_size != static_cast<size_t>(end - begin)) {
+    THROW_EXCEPTION(SyntaxError, "Invalid format");
+    return MaybeLocal<Value>();
+  }
+  return message_object;
+}
+
+// Appends the description of an invalid message to `errors`: its index in
+// the data, the byte range and the message of the exception.
+static bool AddMessageError(Isolate* isolate,
+                            Local<Array> errors,
+                            uint32_t index,
+                            size_t begin,
+                            size_t end,
+                            Local<Value> exception) {
+  auto context = isolate->GetCurrentContext();
+  auto key = [isolate](const char* name) {
+    return String::NewFromUtf8(isolate, name, NewStringType::kInternalized)
+        .ToLocalChecked();
+  };
+
+  Local<Value> reason = exception;
+  if (exception->IsObject() &&
+      !exception.As<Object>()->Get(context, key("message")).ToLocal(&reason)) {
+    return false;
+  }
+  Local<String> reason_string;
+  if (!reason->ToString(context).ToLocal(&reason_string)) {
+    return false;
+  }
+
+  Local<Object> error = Object::New(isolate);
+  auto set = [context, error, &key](const char* name, Local<Value> value) {
+    return error->Set(context, key(name), value).FromMaybe(false);
+  };
+  return set("index", Integer::NewFromUnsigned(isolate, index)) &&
+         set("begin", Number::New(isolate, static_cast<double>(begin))) &&
+         set("end", Number::New(isolate, static_cast<double>(end))) &&
+         set("reason", reason_string) &&
+         errors->Set(context, errors->Length(), error).FromMaybe(false);
+}
+
 Local<String> ParseJSTPMessages(Isolate* isolate,
                                 const char* str,
                                 size_t length,
-                                Local<Array> out) {
+                                Local<Array> out,
+                                const parser::ParseOptions& options,
+                                MessageCache* cache,
+                                Local<Array> errors) {
   auto context = isolate->GetCurrentContext();
   uint32_t out_index = 0;
+  // Index of the current message in the data, the invalid ones included.
+  uint32_t message_index = 0;
   int32_t parsed_length = 0;
 
   for (size_t i = 0; i < length; i++) {
@@ -42,27 +130,56 @@ Local<String> ParseJSTPMessages(Isolate* isolate,
     }
     const char* current_message = str + parsed_length;
     const char* current_message_end = str + i;
-    size_t skipped_size = SkipToNextToken(current_message, current_message_end);
-    size_t parsed_message_size = 0;
-    if (current_message[skipped_size] != '{') {
-      THROW_EXCEPTION(SyntaxError, "Invalid message type");
-      return Local<String>();
-    }
-    auto message_object = ParseObject(isolate,
-                                      current_message + skipped_size,
-                                      current_message_end,
-                                      &parsed_message_size);
 
-    if (message_object.IsEmpty()) {
-      return Local<String>();
+    Local<Object> cached_message;
+    if (cache && cache->Lookup(isolate, current_message, i - parsed_length,
+                               &cached_message)) {
+      if (!out->Set(context, out_index++, cached_message).FromMaybe(false)) {
+        return Local<String>();
+      }
+      MDSF_STATS_INC(messages_parsed);
+      message_index++;
+      parsed_length = i + 1;
+      continue;
     }
 
-    parsed_message_size += skipped_size;
-    parsed_message_size += SkipToNextToken(
-        current_message + parsed_message_size, current_message_end);
+    MaybeLocal<Value> message_object;
+    if (errors.IsEmpty()) {
+      message_object = ParseMessage(isolate, current_message,
+                                    current_message_end, options);
+      if (message_object.IsEmpty()) {
+        return Local<String>();
+      }
+    } else {
+      // The terminator of the invalid message is already known, so the
+      // parsing continues from the next message.
+      Local<Value> exception;
+      {
+        TryCatch try_catch(isolate);
+        message_object = ParseMessage(isolate, current_message,
+                                      current_message_end, options);
+        if (message_object.IsEmpty()) {
+          if (!try_catch.CanContinue()) {
+            try_catch.ReThrow();
+            return Local<String>();
+          }
+          exception = try_catch.Exception();
+        }
+      }
+      if (message_object.IsEmpty()) {
+        if (!AddMessageError(isolate, errors, message_index, parsed_length, i,
+                             exception)) {
+          return Local<String>();
+        }
+        message_index++;
+        parsed_length = i + 1;
+        continue;
+      }
+    }
 
-    if (parsed_message_size != i - parsed_length) {
-      THROW_EXCEPTION(SyntaxError, "Invalid format");
+    if (cache &&
+        !cache->Insert(isolate, current_message, i - parsed_length,
+                       message_object.ToLocalChecked().As<Object>())) {
       return Local<String>();
     }
 
@@ -70,13 +187,142 @@ Local<String> ParseJSTPMessages(Isolate* isolate,
     if (!mb.FromMaybe(false)) {
       return Local<String>();
     }
+    MDSF_STATS_INC(messages_parsed);
 
+    message_index++;
     parsed_length = i + 1;
   }
 
   return String::NewFromUtf8(isolate, str + parsed_length);
 }
 
+MessageStreamParser::MessageStreamParser(
+    const parser::ParseOptions& options)
+    : state_(kBeforeMessage),
+      parser_(options),
+      incomplete_utf8_length_(0),
+      received_length_(0) {}
+
+bool MessageStreamParser::Parse(Isolate* isolate,
+                                const char* chunk,
+                                size_t length,
+                                bool is_utf8,
+                                Local<Array> out) {
+  auto context = isolate->GetCurrentContext();
+  uint32_t out_index = out->Length();
+
+  const char* begin = chunk;
+  const char* end = chunk + length;
+  if (!pending_.empty()) {
+    pending_.append(chunk, length);
+    begin = pending_.data();
+    end = begin + pending_.size();
+  }
+
+  // The truncated sequence at the end of the previous chunk is validated
+  // along with this one.
+  size_t incomplete_length = 0;
+  if (!is_utf8) {
+    const char* unchecked = end - length - incomplete_utf8_length_;
+    size_t error_offset;
+    if (!unicode_utils::ValidateUtf8(unchecked, end - unchecked, true,
+                                     &error_offset)) {
+      char message[64];
+      std::snprintf(message, sizeof(message),
+                    "Invalid UTF-8 sequence at position %zu",
+                    received_length_ - incomplete_utf8_length_ +
+                        error_offset);
+      THROW_EXCEPTION(SyntaxError, message);
+      received_length_ += length;
+      Reset();
+      return false;
+    }
+    incomplete_length = unicode_utils::GetIncompleteUtf8Length(unchecked,
+                                                               end);
+  }
+  received_length_ += length;
+  incomplete_utf8_length_ = incomplete_length;
+  end -= incomplete_length;
+
+  const char* current = begin;
+  bool is_incomplete = false;
+
+  parser_.Resume(isolate);
+
+  while (current < end) {
+    auto terminator = static_cast<const char*>(
+        memchr(current, kMessageTerminator, end - current));
+    bool is_last = terminator != nullptr;
+    const char* message_end = is_last ? terminator : end;
+
+    if (state_ == kBeforeMessage) {
+      current += SkipToNextTokenInChunk(current, message_end, is_last,
+                                        &is_incomplete);
+      if (is_incomplete || current == end) {
+        break;
+      }
+      if (*current != '{') {
+        THROW_EXCEPTION(SyntaxError, "Invalid message type");
+        Reset();
+        return false;
+      }
+      state_ = kInMessage;
+    }
+
+    if (state_ == kInMessage) {
+      size_t parsed_size = 0;
+      auto status = parser_.Parse(isolate, current, message_end, is_last,
+                                  &parsed_size);
+      current += parsed_size;
+      if (status == ValueParser::kError) {
+        Reset();
+        return false;
+      } else if (status == ValueParser::kIncomplete) {
+        break;
+      }
+      state_ = kAfterMessage;
+    }
+
+    current += SkipToNextTokenInChunk(current, message_end, is_last,
+                                      &is_incomplete);
+    if (is_incomplete || current == end) {
+      break;
+    }
+    if (current != terminator) {
+      THROW_EXCEPTION(SyntaxError, "Invalid format");
+      Reset();
+      return false;
+    }
+
+    auto mb = out->Set(context, out_index++, parser_.Result());
+    if (!mb.FromMaybe(false)) {
+      Reset();
+      return false;
+    }
+    MDSF_STATS_INC(messages_parsed);
+    parser_.Reset();
+    state_ = kBeforeMessage;
+    current = terminator + 1;
+  }
+
+  if (pending_.empty()) {
+    pending_.assign(current, end + incomplete_length - current);
+  } else {
+    pending_.erase(0, current - begin);
+  }
+  if (state_ != kBeforeMessage) {
+    parser_.Suspend(isolate);
+  }
+  return true;
+}
+
+void MessageStreamParser::Reset() {
+  state_ = kBeforeMessage;
+  parser_.Reset();
+  pending_.clear();
+  incomplete_utf8_length_ = 0;
+}
+
 }  // namespace message_parser
 
 }  // namespace mdsf
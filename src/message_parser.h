@@ -7,9 +7,13 @@
 #define SRC_MESSAGE_PARSER_H_
 
 #include <cstddef>
+#include <string>
 
 #include <v8.h>
 
+#include "message_cache.h"
+#include "parser.h"
+
 namespace mdsf {
 
 namespace message_parser {
@@ -18,9 +22,59 @@ const char kMessageTerminator = '\0';
 
 // Efficiently parses JSTP messages for transports that require message
 // delimiters eliminating the need to split the stream data into parts before
-// parsing and allowing to do that in one pass.
+// parsing and allowing to do that in one pass. The messages are parsed with
+// the limits and flags of `options`. If `cache` is not null, the messages
+// found in it are not parsed again (so they are only checked against the
+// options they were parsed with), and the parsed ones are added to it. If
+// `errors` is not empty, an invalid message doesn't stop the parsing: an
+// object with its index among the messages, the byte range [begin, end) and
+// the reason is appended to `errors` instead of throwing, and the parsing
+// continues after its terminator.
 v8::Local<v8::String> ParseJSTPMessages(v8::Isolate* isolate,
-    const char* str, std::size_t length, v8::Local<v8::Array> out);
+    const char* str, std::size_t length, v8::Local<v8::Array> out,
+    const parser::ParseOptions& options = parser::ParseOptions(),
+    message_cache::MessageCache* cache = nullptr,
+    v8::Local<v8::Array> errors = v8::Local<v8::Array>());
+
+// Parses JSTP messages from a stream which is received in chunks. Unlike
+// ParseJSTPMessages, which has to be called with the incomplete message
+// again once more data arrives, a message received partially is suspended
+// along with everything that has been parsed from it so far, and the parsing
+// is resumed from the same point when the next chunk arrives.
+class MessageStreamParser {
+ public:
+  explicit MessageStreamParser(
+      const parser::ParseOptions& options = parser::ParseOptions());
+
+  // Parses the next chunk of the stream and appends complete messages to
+  // `out`. Unless `is_utf8` tells that the chunk is known to be valid UTF-8
+  // (it comes from a JavaScript string), it is validated first, a sequence
+  // split between chunks is checked once the rest of it arrives. Returns
+  // false if an error has occurred, in which case a JavaScript exception is
+  // thrown and the state of the stream is reset.
+  bool Parse(v8::Isolate* isolate,
+             const char* chunk,
+             std::size_t length,
+             bool is_utf8,
+             v8::Local<v8::Array> out);
+
+ private:
+  enum State { kBeforeMessage = 0, kInMessage, kAfterMessage };
+
+  void Reset();
+
+  State state_;
+  parser::ValueParser parser_;
+  // Data that has been received but not consumed yet (an incomplete token).
+  std::string pending_;
+  // Number of bytes at the end of `pending_` that begin a UTF-8 sequence
+  // truncated by the end of the chunk, they are not parsed until the rest
+  // of the sequence arrives.
+  std::size_t incomplete_utf8_length_;
+  // Number of bytes received so far, used to report the positions of
+  // invalid UTF-8 sequences in the stream.
+  std::size_t received_length_;
+};
 
 }  // namespace message_parser
 
@@ -3,18 +3,42 @@
 // Copyright (c) 2018 mdsf project authors. Use of this source code is
 // governed by the MIT license that can be found in the LICENSE file.
 
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
 #include <node.h>
+#include <node_object_wrap.h>
 #include <v8.h>
 
 #include "common.h"
 #include "parser.h"
+#include "json_transcoder.h"
+#include "message_cache.h"
 #include "message_parser.h"
+#include "parse_stats.h"
+#include "serializer.h"
+#include "simd.h"
+#include "stream_parser.h"
+#include "tracing.h"
+#include "unicode_utils.h"
+#include "validator.h"
 
 using v8::Array;
+using v8::Context;
+using v8::External;
+using v8::FunctionCallback;
 using v8::FunctionCallbackInfo;
+using v8::FunctionTemplate;
+using v8::Global;
 using v8::HandleScope;
 using v8::Isolate;
 using v8::Local;
+using v8::NewStringType;
+using v8::Number;
 using v8::Object;
 using v8::String;
 using v8::Value;
@@ -24,18 +48,402 @@ namespace mdsf {
 
 namespace bindings {
 
+// State of a single instance of the addon. The addon is context-aware, so
+// the main thread and every worker thread load their own instance, and
+// nothing referring to JavaScript objects may be shared between them.
+struct AddonData {
+  Global<FunctionTemplate> message_cache_template;
+};
+
+#if NODE_MODULE_VERSION >= 64
+static void DeleteAddonData(void* data) {
+  delete static_cast<AddonData*>(data);
+}
+#endif
+
+// Returns the data passed to the functions created with SetMethod().
+static AddonData* GetAddonData(const FunctionCallbackInfo<Value>& args) {
+  return static_cast<AddonData*>(args.Data().As<External>()->Value());
+}
+
+// Same as NODE_SET_METHOD, but makes `data` available to the callback via
+// GetAddonData().
+static void SetMethod(Local<Context> context,
+                      Local<Object> target,
+                      const char* name,
+                      FunctionCallback callback,
+                      AddonData* data) {
+  Isolate* isolate = context->GetIsolate();
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(
+      isolate, callback, External::New(isolate, data));
+  auto fn_name = String::NewFromUtf8(isolate, name,
+                                     NewStringType::kInternalized)
+                     .ToLocalChecked();
+  tpl->SetClassName(fn_name);
+  target->Set(context, fn_name, tpl->GetFunction(context).ToLocalChecked())
+      .FromJust();
+}
+
+// Reads the property `name` of the options object into `value`. Returns
+// false if an exception has been thrown.
+static bool GetOption(Isolate* isolate,
+                      Local<Object> options,
+                      const char* name,
+                      Local<Value>* value) {
+  auto context = isolate->GetCurrentContext();
+  auto key = String::NewFromUtf8(isolate, name, NewStringType::kInternalized)
+                 .ToLocalChecked();
+  return options->Get(context, key).ToLocal(value);
+}
+
+// Reads the parsing options passed from JavaScript into `result`. Returns
+// false and throws an exception if the options are invalid.
+static bool GetParseOptions(Isolate* isolate,
+                            Local<Value> options,
+                            mdsf::parser::ParseOptions* result) {
+  *result = mdsf::parser::ParseOptions();
+  if (options->IsUndefined()) {
+    return true;
+  }
+  if (!options->IsObject()) {
+    THROW_EXCEPTION(TypeError, "Options must be an object");
+    return false;
+  }
+  auto object = options.As<Object>();
+
+  Local<Value> value;
+  if (!GetOption(isolate, object, "maxDepth", &value)) {
+    return false;
+  }
+  if (!value->IsUndefined()) {
+    if (!value->IsUint32() || value.As<v8::Uint32>()->Value() == 0) {
+      THROW_EXCEPTION(TypeError, "maxDepth must be a positive integer");
+      return false;
+    }
+    result->max_depth = value.As<v8::Uint32>()->Value();
+  }
+
+  if (!GetOption(isolate, object, "dialect", &value)) {
+    return false;
+  }
+  if (!value->IsUndefined()) {
+    bool is_valid = false;
+    if (value->IsString()) {
+      String::Utf8Value name(
+#if NODE_MODULE_VERSION >= 57
+          isolate,
+#endif
+          value
+      );
+      if (std::strcmp(*name, "mdsf") == 0) {
+        result->dialect = mdsf::parser::Dialect::kMdsf;
+        is_valid = true;
+      } else if (std::strcmp(*name, "json") == 0) {
+        result->dialect = mdsf::parser::Dialect::kJson;
+        is_valid = true;
+      }
+    }
+    if (!is_valid) {
+      THROW_EXCEPTION(TypeError, "dialect must be either 'mdsf' or 'json'");
+      return false;
+    }
+  }
+
+  if (!GetOption(isolate, object, "typedArrays", &value)) {
+    return false;
+  }
+#if NODE_MODULE_VERSION >= 67
+  result->typed_arrays = value->BooleanValue(isolate);
+#else
+  result->typed_arrays =
+      value->BooleanValue(isolate->GetCurrentContext()).FromJust();
+#endif
+
+  if (!GetOption(isolate, object, "deduplicateStrings", &value)) {
+    return false;
+  }
+#if NODE_MODULE_VERSION >= 67
+  result->deduplicate_strings = value->BooleanValue(isolate);
+#else
+  result->deduplicate_strings =
+      value->BooleanValue(isolate->GetCurrentContext()).FromJust();
+#endif
+  return true;
+}
+
+// Reads the parsing options of the message and array parsers, which only
+// support the MDSF dialect. Returns false and throws an exception if the
+// options are invalid.
+static bool GetMdsfParseOptions(Isolate* isolate,
+                                Local<Value> options,
+                                mdsf::parser::ParseOptions* result) {
+  if (!GetParseOptions(isolate, options, result)) {
+    return false;
+  }
+  if (result->dialect != mdsf::parser::Dialect::kMdsf) {
+    THROW_EXCEPTION(TypeError, "Only the 'mdsf' dialect is supported");
+    return false;
+  }
+  return true;
+}
+
+// Checks that raw bytes passed from JavaScript are valid UTF-8. Unlike
+// strings coming from V8, they are not guaranteed to be, so this must be
+// done before creating any strings from them. Returns false and throws an
+// exception otherwise.
+static bool ValidateUtf8(Isolate* isolate, const char* str,
+                         std::size_t length) {
+  std::size_t error_offset;
+  if (!mdsf::unicode_utils::ValidateUtf8(str, length, false, &error_offset)) {
+    char message[64];
+    std::snprintf(message, sizeof(message),
+                  "Invalid UTF-8 sequence at position %zu", error_offset);
+    THROW_EXCEPTION(SyntaxError, message);
+    return false;
+  }
+  return true;
+}
+
 void Parse(const FunctionCallbackInfo<Value>& args) {
   Isolate* isolate = args.GetIsolate();
 
-  if (args.Length() != 1) {
+  if (args.Length() < 1 || args.Length() > 2) {
     THROW_EXCEPTION(TypeError, "Wrong number of arguments");
     return;
   }
 
   HandleScope scope(isolate);
 
+  mdsf::parser::ParseOptions options;
+  if (!GetParseOptions(isolate, args[1], &options)) {
+    return;
+  }
+
   Local<Value> result;
   std::size_t length;
+  mdsf::tracing::ScopedSpan span("mdsf.parse");
+
+  if (args[0]->IsString()) {
+    mdsf::tracing::ScopedSpan decode_span("mdsf.parse.decode");
+    String::Utf8Value str(
+#if NODE_MODULE_VERSION >= 57
+        isolate,
+#endif
+        args[0]
+    );
+    decode_span.End();
+    length = str.length();
+    span.AddArg("inputSize", length);
+    mdsf::parse_stats::ScopedParseTimer timer(length);
+    mdsf::tracing::ScopedSpan materialize_span("mdsf.parse.materialize");
+    result = mdsf::parser::Parse(isolate, *str, length, options);
+  } else if (args[0]->IsUint8Array()) {
+    Local<Uint8Array> buf = args[0].As<Uint8Array>();
+    length = buf->ByteLength();
+    span.AddArg("inputSize", length);
+    void* data = buf->Buffer()->GetContents().Data();
+    const char* str = static_cast<const char*>(data) + buf->ByteOffset();
+    mdsf::tracing::ScopedSpan validate_span("mdsf.parse.validate");
+    if (!ValidateUtf8(isolate, str, length)) {
+      return;
+    }
+    validate_span.End();
+    mdsf::parse_stats::ScopedParseTimer timer(length);
+    mdsf::tracing::ScopedSpan materialize_span("mdsf.parse.materialize");
+    result = mdsf::parser::Parse(isolate, str, length, options);
+  } else {
+    THROW_EXCEPTION(TypeError, "Wrong argument type");
+    return;
+  }
+
+  args.GetReturnValue().Set(result);
+}
+
+// Reads the option `name`, which must be one of `count` strings in `names`,
+// into `index`, which is left intact if the option is undefined. Returns
+// false and throws an exception if the option is invalid.
+static bool GetEnumOption(Isolate* isolate,
+                          Local<Object> options,
+                          const char* name,
+                          const char* const* names,
+                          std::size_t count,
+                          const char* error,
+                          std::size_t* index) {
+  Local<Value> value;
+  if (!GetOption(isolate, options, name, &value)) {
+    return false;
+  }
+  if (value->IsUndefined()) {
+    return true;
+  }
+  if (value->IsString()) {
+    String::Utf8Value str(
+#if NODE_MODULE_VERSION >= 57
+        isolate,
+#endif
+        value
+    );
+    for (std::size_t i = 0; i < count; i++) {
+      if (std::strcmp(*str, names[i]) == 0) {
+        *index = i;
+        return true;
+      }
+    }
+  }
+  THROW_EXCEPTION(TypeError, error);
+  return false;
+}
+
+// Reads the options of toJSON() into `result`. Returns false and throws an
+// exception if the options are invalid.
+static bool GetTranscodeOptions(
+    Isolate* isolate,
+    Local<Value> options,
+    mdsf::json_transcoder::TranscodeOptions* result) {
+  using mdsf::json_transcoder::NonFinitePolicy;
+  using mdsf::json_transcoder::UndefinedPolicy;
+
+  mdsf::parser::ParseOptions parse_options;
+  if (!GetParseOptions(isolate, options, &parse_options)) {
+    return false;
+  }
+  *result = mdsf::json_transcoder::TranscodeOptions();
+  result->max_depth = parse_options.max_depth;
+  result->dialect = parse_options.dialect;
+  if (options->IsUndefined()) {
+    return true;
+  }
+  auto object = options.As<Object>();
+
+  // In the order of the enumerators.
+  static const char* const kUndefinedPolicies[] = {"omit", "null", "error"};
+  static const char* const kNonFinitePolicies[] = {"null", "string", "error"};
+  std::size_t index = 0;
+  if (!GetEnumOption(isolate, object, "undefined", kUndefinedPolicies, 3,
+                     "undefined must be 'omit', 'null' or 'error'", &index)) {
+    return false;
+  }
+  result->undefined_policy = static_cast<UndefinedPolicy>(index);
+  index = 0;
+  if (!GetEnumOption(isolate, object, "nonFinite", kNonFinitePolicies, 3,
+                     "nonFinite must be 'null', 'string' or 'error'",
+                     &index)) {
+    return false;
+  }
+  result->non_finite_policy = static_cast<NonFinitePolicy>(index);
+  return true;
+}
+
+// toJSON(data[, options])
+// Converts MDSF data into a Buffer with JSON without creating the values,
+// see json_transcoder::TranscodeToJson().
+void ToJSON(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (args.Length() < 1 || args.Length() > 2) {
+    THROW_EXCEPTION(TypeError, "Wrong number of arguments");
+    return;
+  }
+
+  HandleScope scope(isolate);
+
+  mdsf::json_transcoder::TranscodeOptions options;
+  if (!GetTranscodeOptions(isolate, args[1], &options)) {
+    return;
+  }
+
+  Local<Object> result;
+  mdsf::tracing::ScopedSpan span("mdsf.toJSON");
+
+  if (args[0]->IsString()) {
+    String::Utf8Value str(
+#if NODE_MODULE_VERSION >= 57
+        isolate,
+#endif
+        args[0]
+    );
+    span.AddArg("inputSize", str.length());
+    if (!mdsf::json_transcoder::TranscodeToJson(isolate, *str, str.length(),
+                                                options).ToLocal(&result)) {
+      return;
+    }
+  } else if (args[0]->IsUint8Array()) {
+    Local<Uint8Array> buf = args[0].As<Uint8Array>();
+    std::size_t length = buf->ByteLength();
+    span.AddArg("inputSize", length);
+    void* data = buf->Buffer()->GetContents().Data();
+    const char* str = static_cast<const char*>(data) + buf->ByteOffset();
+    if (!ValidateUtf8(isolate, str, length) ||
+        !mdsf::json_transcoder::TranscodeToJson(isolate, str, length,
+                                                options).ToLocal(&result)) {
+      return;
+    }
+  } else {
+    THROW_EXCEPTION(TypeError, "Wrong argument type");
+    return;
+  }
+
+  args.GetReturnValue().Set(result);
+}
+
+// Reads the limits of validate() into `result`. Returns false and throws an
+// exception if the limits are invalid.
+static bool GetValidateLimits(Isolate* isolate,
+                              Local<Value> limits,
+                              mdsf::validator::ValidateLimits* result) {
+  mdsf::parser::ParseOptions parse_options;
+  if (!GetParseOptions(isolate, limits, &parse_options)) {
+    return false;
+  }
+  *result = mdsf::validator::ValidateLimits();
+  result->max_depth = parse_options.max_depth;
+  result->dialect = parse_options.dialect;
+  if (limits->IsUndefined()) {
+    return true;
+  }
+
+  Local<Value> value;
+  if (!GetOption(isolate, limits.As<Object>(), "maxSize", &value)) {
+    return false;
+  }
+  if (!value->IsUndefined()) {
+    double max_size = value->IsNumber() ? value.As<Number>()->Value() : -1;
+    if (!(max_size >= 0) || max_size != std::floor(max_size)) {
+      THROW_EXCEPTION(TypeError, "maxSize must be a non-negative integer");
+      return false;
+    }
+    if (max_size < static_cast<double>(result->max_size)) {
+      result->max_size = static_cast<std::size_t>(max_size);
+    }
+  }
+  return true;
+}
+
+// validate(data[, limits])
+// Checks that the data is well-formed within the limits without creating
+// the values, see validator::Validate(). Returns an object with the
+// statistics and `valid: true`, or with `valid: false` and the type,
+// message and byte offset of the error.
+void Validate(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (args.Length() < 1 || args.Length() > 2) {
+    THROW_EXCEPTION(TypeError, "Wrong number of arguments");
+    return;
+  }
+
+  HandleScope scope(isolate);
+
+  mdsf::validator::ValidateLimits limits;
+  if (!GetValidateLimits(isolate, args[1], &limits)) {
+    return;
+  }
+
+  mdsf::validator::ValidateStats stats;
+  mdsf::value_scanner::Error error;
+  std::size_t length;
+  bool is_valid;
+  mdsf::tracing::ScopedSpan span("mdsf.validate");
 
   if (args[0]->IsString()) {
     String::Utf8Value str(
@@ -45,25 +453,174 @@ void Parse(const FunctionCallbackInfo<Value>& args) {
         args[0]
     );
     length = str.length();
-    result = mdsf::parser::Parse(isolate, *str, length);
+    span.AddArg("inputSize", length);
+    is_valid = mdsf::validator::Validate(*str, length, true, limits, &stats,
+                                         &error);
   } else if (args[0]->IsUint8Array()) {
     Local<Uint8Array> buf = args[0].As<Uint8Array>();
     length = buf->ByteLength();
+    span.AddArg("inputSize", length);
     void* data = buf->Buffer()->GetContents().Data();
     const char* str = static_cast<const char*>(data) + buf->ByteOffset();
-    result = mdsf::parser::Parse(isolate, str, length);
+    is_valid = mdsf::validator::Validate(str, length, false, limits, &stats,
+                                         &error);
   } else {
     THROW_EXCEPTION(TypeError, "Wrong argument type");
     return;
   }
 
+  auto context = isolate->GetCurrentContext();
+  auto set = [isolate, context](Local<Object> target, const char* name,
+                                Local<Value> value) {
+    auto key = String::NewFromUtf8(isolate, name, NewStringType::kInternalized)
+                   .ToLocalChecked();
+    target->Set(context, key, value).FromJust();
+  };
+  auto number = [isolate](std::size_t value) {
+    return Number::New(isolate, static_cast<double>(value));
+  };
+
+  Local<Object> result = Object::New(isolate);
+  set(result, "valid", v8::Boolean::New(isolate, is_valid));
+  set(result, "size", number(length));
+  if (is_valid) {
+    set(result, "depth", number(stats.depth));
+    set(result, "values", number(stats.values));
+    set(result, "arrays", number(stats.arrays));
+    set(result, "objects", number(stats.objects));
+    set(result, "keys", number(stats.keys));
+    set(result, "strings", number(stats.strings));
+    set(result, "numbers", number(stats.numbers));
+  } else {
+    static const char* const kErrorTypes[] = {
+      "SyntaxError", "TypeError", "RangeError"
+    };
+    auto string = [isolate](const char* value) {
+      return String::NewFromUtf8(isolate, value, NewStringType::kNormal)
+          .ToLocalChecked();
+    };
+    set(result, "type", string(kErrorTypes[static_cast<int>(error.type)]));
+    set(result, "message", string(error.message));
+    set(result, "offset", number(error.offset));
+  }
   args.GetReturnValue().Set(result);
 }
 
+// JavaScript wrapper for message_cache::MessageCache.
+class MessageCache : public node::ObjectWrap {
+ public:
+  static void Init(Local<Object> target, AddonData* data) {
+    Isolate* isolate = target->GetIsolate();
+    auto context = isolate->GetCurrentContext();
+
+    Local<FunctionTemplate> tpl = FunctionTemplate::New(isolate, New);
+    auto class_name = String::NewFromUtf8(isolate, "MessageCache",
+                                          NewStringType::kInternalized)
+                                              .ToLocalChecked();
+    tpl->SetClassName(class_name);
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "getStats", GetStats);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "clear", Clear);
+    data->message_cache_template.Reset(isolate, tpl);
+
+    target->Set(context, class_name,
+                tpl->GetFunction(context).ToLocalChecked()).FromJust();
+  }
+
+  // Returns the cache wrapped by `value`, or nullptr if `value` is not a
+  // MessageCache instance.
+  static mdsf::message_cache::MessageCache* FromValue(Isolate* isolate,
+                                                      AddonData* data,
+                                                      Local<Value> value) {
+    auto tpl = Local<FunctionTemplate>::New(isolate,
+                                            data->message_cache_template);
+    if (!tpl->HasInstance(value)) {
+      return nullptr;
+    }
+    return &ObjectWrap::Unwrap<MessageCache>(value.As<Object>())->cache_;
+  }
+
+ private:
+  explicit MessageCache(std::size_t max_size) : cache_(max_size) {}
+
+  // new MessageCache([options])
+  // `options.maxSize` limits the total size of the cached messages in bytes.
+  static void New(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = args.GetIsolate();
+
+    if (!args.IsConstructCall()) {
+      THROW_EXCEPTION(TypeError, "Class constructor cannot be invoked "
+                                 "without 'new'");
+      return;
+    }
+
+    double max_size = mdsf::message_cache::kDefaultMaxSize;
+    if (args[0]->IsObject()) {
+      Local<Value> value;
+      if (!GetOption(isolate, args[0].As<Object>(), "maxSize", &value)) {
+        return;
+      }
+      if (!value->IsUndefined()) {
+        if (!value->IsNumber() || !(value.As<Number>()->Value() >= 0)) {
+          THROW_EXCEPTION(RangeError,
+                          "maxSize must be a non-negative number");
+          return;
+        }
+        max_size = value.As<Number>()->Value();
+      }
+    } else if (!args[0]->IsUndefined()) {
+      THROW_EXCEPTION(TypeError, "Options must be an object");
+      return;
+    }
+
+    const double kMaxSize = std::numeric_limits<std::size_t>::max();
+    auto cache = new MessageCache(static_cast<std::size_t>(
+        max_size < kMaxSize ? max_size : kMaxSize));
+    cache->Wrap(args.This());
+    args.GetReturnValue().Set(args.This());
+  }
+
+  // cache.getStats()
+  static void GetStats(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+
+    auto context = isolate->GetCurrentContext();
+    const mdsf::message_cache::MessageCache& cache =
+        ObjectWrap::Unwrap<MessageCache>(args.Holder())->cache_;
+
+    auto set = [isolate, context](Local<Object> target, const char* name,
+                                  double value) {
+      auto key = String::NewFromUtf8(isolate, name,
+                                     NewStringType::kInternalized)
+                     .ToLocalChecked();
+      target->Set(context, key, Number::New(isolate, value)).FromJust();
+    };
+
+    Local<Object> stats = Object::New(isolate);
+    set(stats, "hits", static_cast<double>(cache.hits()));
+    set(stats, "misses", static_cast<double>(cache.misses()));
+    set(stats, "evictions", static_cast<double>(cache.evictions()));
+    set(stats, "updates", static_cast<double>(cache.updates()));
+    set(stats, "entries", static_cast<double>(cache.entry_count()));
+    set(stats, "size", static_cast<double>(cache.size()));
+    set(stats, "maxSize", static_cast<double>(cache.max_size()));
+    args.GetReturnValue().Set(stats);
+  }
+
+  // cache.clear()
+  static void Clear(const FunctionCallbackInfo<Value>& args) {
+    ObjectWrap::Unwrap<MessageCache>(args.Holder())->cache_.Clear();
+  }
+
+  mdsf::message_cache::MessageCache cache_;
+};
+
+// parseJSTPMessages(data, messages[, cache[, errors[, options]]])
 void ParseJSTPMessages(const FunctionCallbackInfo<Value>& args) {
   Isolate* isolate = args.GetIsolate();
 
-  if (args.Length() != 2) {
+  if (args.Length() < 2 || args.Length() > 5) {
     THROW_EXCEPTION(TypeError, "Wrong number of arguments");
     return;
   }
@@ -71,28 +628,393 @@ void ParseJSTPMessages(const FunctionCallbackInfo<Value>& args) {
     THROW_EXCEPTION(TypeError, "Wrong argument type");
     return;
   }
+  mdsf::message_cache::MessageCache* cache = nullptr;
+  if (args.Length() >= 3 && !args[2]->IsUndefined()) {
+    cache = MessageCache::FromValue(isolate, GetAddonData(args), args[2]);
+    if (cache == nullptr) {
+      THROW_EXCEPTION(TypeError, "Cache must be a MessageCache");
+      return;
+    }
+  }
+  Local<Array> errors;
+  if (args.Length() >= 4 && !args[3]->IsUndefined()) {
+    if (!args[3]->IsArray()) {
+      THROW_EXCEPTION(TypeError, "Errors must be an array");
+      return;
+    }
+    errors = args[3].As<Array>();
+  }
+  mdsf::parser::ParseOptions options;
+  if (args.Length() == 5 &&
+      !GetMdsfParseOptions(isolate, args[4], &options)) {
+    return;
+  }
 
   HandleScope scope(isolate);
 
+  mdsf::tracing::ScopedSpan span("mdsf.parseJSTPMessages");
+  mdsf::tracing::ScopedSpan decode_span("mdsf.parseJSTPMessages.decode");
   String::Utf8Value str(
 #if NODE_MODULE_VERSION >= 57
       isolate,
 #endif
       args[0].As<String>()
   );
+  decode_span.End();
   std::size_t length = str.length();
   auto array = args[1].As<Array>();
+  uint32_t initial_count = array->Length();
+  mdsf::parse_stats::ScopedParseTimer timer(length);
+  mdsf::tracing::ScopedSpan materialize_span(
+      "mdsf.parseJSTPMessages.materialize");
   auto result = mdsf::message_parser::ParseJSTPMessages(isolate, *str, length,
-                                                        array);
+                                                        array, options, cache,
+                                                        errors);
+  materialize_span.End();
+  span.AddArg("inputSize", length);
+  span.AddArg("messageCount", array->Length() - initial_count);
   args.GetReturnValue().Set(result);
 }
 
-void Init(Local<Object> target) {
+void StringifyNumbers(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (args.Length() != 1) {
+    THROW_EXCEPTION(TypeError, "Wrong number of arguments");
+    return;
+  }
+
+  HandleScope scope(isolate);
+
+  Local<Value> result = mdsf::serializer::StringifyNumbers(isolate, args[0]);
+  if (!result.IsEmpty()) {
+    args.GetReturnValue().Set(result);
+  }
+}
+
+void StringifyString(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (args.Length() != 1) {
+    THROW_EXCEPTION(TypeError, "Wrong number of arguments");
+    return;
+  }
+  if (!args[0]->IsString()) {
+    THROW_EXCEPTION(TypeError, "Wrong argument type");
+    return;
+  }
+
+  HandleScope scope(isolate);
+
+  Local<Value> result =
+      mdsf::serializer::StringifyString(isolate, args[0].As<String>());
+  if (!result.IsEmpty()) {
+    args.GetReturnValue().Set(result);
+  }
+}
+
+// Returns an object with the parser counters of the current isolate, or null
+// if the addon has been built without them.
+void GetStats(const FunctionCallbackInfo<Value>& args) {
+#if defined(_PARSER_ENABLE_STATS_)
+  Isolate* isolate = args.GetIsolate();
+  HandleScope scope(isolate);
+
+  auto context = isolate->GetCurrentContext();
+  const mdsf::parse_stats::Counters* counters =
+      mdsf::parse_stats::GetCounters();
+
+  auto set = [isolate, context](Local<Object> target, const char* name,
+                                Local<Value> value) {
+    auto key = String::NewFromUtf8(isolate, name, NewStringType::kInternalized)
+                   .ToLocalChecked();
+    target->Set(context, key, value).FromJust();
+  };
+  auto number = [isolate](std::uint64_t value) -> Local<Value> {
+    return Number::New(isolate, static_cast<double>(value));
+  };
+
+  Local<Object> stats = Object::New(isolate);
+  set(stats, "bytesParsed", number(counters->bytes_parsed));
+  set(stats, "messagesParsed", number(counters->messages_parsed));
+  set(stats, "objects", number(counters->objects));
+  set(stats, "arrays", number(counters->arrays));
+  set(stats, "strings", number(counters->strings));
+  set(stats, "escapedStrings", number(counters->escaped_strings));
+  set(stats, "deduplicatedStrings", number(counters->deduplicated_strings));
+  set(stats, "fastNumbers", number(counters->fast_numbers));
+  set(stats, "slowNumbers", number(counters->slow_numbers));
+  set(stats, "scratchAllocations", number(counters->scratch_allocations));
+
+  Local<Array> parse_time =
+      Array::New(isolate, mdsf::parse_stats::kSizeBucketCount);
+  for (std::size_t i = 0; i < mdsf::parse_stats::kSizeBucketCount; i++) {
+    const mdsf::parse_stats::TimeBucket& bucket = counters->parse_time[i];
+    std::size_t limit = mdsf::parse_stats::GetSizeBucketLimit(i);
+    Local<Object> entry = Object::New(isolate);
+    set(entry, "maxSize",
+        Number::New(isolate, limit == 0 ? INFINITY :
+                                          static_cast<double>(limit)));
+    set(entry, "count", number(bucket.count));
+    set(entry, "totalNs", number(bucket.total_ns));
+    set(entry, "maxNs", number(bucket.max_ns));
+    parse_time->Set(context, static_cast<uint32_t>(i), entry).FromJust();
+  }
+  set(stats, "parseTime", parse_time);
+
+  args.GetReturnValue().Set(stats);
+#else
+  args.GetReturnValue().SetNull();
+#endif
+}
+
+// Returns the name of the instruction set level of the kernels selected at
+// startup, see simd::GetLevelName().
+void GetSimdLevel(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  const char* name = mdsf::simd::GetLevelName(mdsf::simd::GetLevel());
+  args.GetReturnValue().Set(
+      String::NewFromUtf8(isolate, name, NewStringType::kInternalized)
+          .ToLocalChecked());
+}
+
+void ResetStats(const FunctionCallbackInfo<Value>& args) {
+#if defined(_PARSER_ENABLE_STATS_)
+  mdsf::parse_stats::ResetCounters();
+#endif
+}
+
+// JavaScript wrapper for MessageStreamParser.
+class MessageStream : public node::ObjectWrap {
+ public:
+  static void Init(Local<Object> target) {
+    Isolate* isolate = target->GetIsolate();
+    auto context = isolate->GetCurrentContext();
+
+    Local<FunctionTemplate> tpl = FunctionTemplate::New(isolate, New);
+    auto class_name = String::NewFromUtf8(isolate, "MessageStream",
+                                          NewStringType::kInternalized)
+                                              .ToLocalChecked();
+    tpl->SetClassName(class_name);
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "parse", Parse);
+
+    target->Set(context, class_name,
+                tpl->GetFunction(context).ToLocalChecked()).FromJust();
+  }
+
+ private:
+  explicit MessageStream(const mdsf::parser::ParseOptions& options)
+      : parser_(options) {}
+
+  // new MessageStream([options])
+  // Besides the parsing options, `options.keyDictionary` enables references
+  // to the keys seen earlier in the stream.
+  static void New(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = args.GetIsolate();
+
+    if (!args.IsConstructCall()) {
+      THROW_EXCEPTION(TypeError, "Class constructor cannot be invoked "
+                                 "without 'new'");
+      return;
+    }
+
+    mdsf::parser::ParseOptions options;
+    if (!GetMdsfParseOptions(isolate, args[0], &options)) {
+      return;
+    }
+    if (args[0]->IsObject()) {
+      Local<Value> value;
+      if (!GetOption(isolate, args[0].As<Object>(), "keyDictionary",
+                     &value)) {
+        return;
+      }
+#if NODE_MODULE_VERSION >= 67
+      options.key_dictionary = value->BooleanValue(isolate);
+#else
+      options.key_dictionary =
+          value->BooleanValue(isolate->GetCurrentContext()).FromJust();
+#endif
+    }
+
+    auto stream = new MessageStream(options);
+    stream->Wrap(args.This());
+    args.GetReturnValue().Set(args.This());
+  }
+
+  // stream.parse(chunk, out)
+  static void Parse(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = args.GetIsolate();
+
+    if (args.Length() != 2) {
+      THROW_EXCEPTION(TypeError, "Wrong number of arguments");
+      return;
+    }
+    if (!args[1]->IsArray()) {
+      THROW_EXCEPTION(TypeError, "Wrong argument type");
+      return;
+    }
+
+    HandleScope scope(isolate);
+
+    auto stream = ObjectWrap::Unwrap<MessageStream>(args.Holder());
+    auto array = args[1].As<Array>();
+
+    if (args[0]->IsString()) {
+      String::Utf8Value str(
+#if NODE_MODULE_VERSION >= 57
+          isolate,
+#endif
+          args[0]
+      );
+      mdsf::parse_stats::ScopedParseTimer timer(str.length());
+      stream->parser_.Parse(isolate, *str, str.length(), true, array);
+    } else if (args[0]->IsUint8Array()) {
+      Local<Uint8Array> buf = args[0].As<Uint8Array>();
+      void* data = buf->Buffer()->GetContents().Data();
+      const char* str = static_cast<const char*>(data) + buf->ByteOffset();
+      mdsf::parse_stats::ScopedParseTimer timer(buf->ByteLength());
+      stream->parser_.Parse(isolate, str, buf->ByteLength(), false, array);
+    } else {
+      THROW_EXCEPTION(TypeError, "Wrong argument type");
+    }
+  }
+
+  mdsf::message_parser::MessageStreamParser parser_;
+};
+
+class ArrayStreamParser : public node::ObjectWrap {
+ public:
+  static void Init(Local<Object> target) {
+    Isolate* isolate = target->GetIsolate();
+    auto context = isolate->GetCurrentContext();
+
+    Local<FunctionTemplate> tpl = FunctionTemplate::New(isolate, New);
+    auto class_name = String::NewFromUtf8(isolate, "ArrayStreamParser",
+                                          NewStringType::kInternalized)
+                                              .ToLocalChecked();
+    tpl->SetClassName(class_name);
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "parse", Parse);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "finish", Finish);
+
+    target->Set(context, class_name,
+                tpl->GetFunction(context).ToLocalChecked()).FromJust();
+  }
+
+ private:
+  explicit ArrayStreamParser(const mdsf::parser::ParseOptions& options)
+      : parser_(options) {}
+
+  // new ArrayStreamParser([options])
+  static void New(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = args.GetIsolate();
+
+    if (!args.IsConstructCall()) {
+      THROW_EXCEPTION(TypeError, "Class constructor cannot be invoked "
+                                 "without 'new'");
+      return;
+    }
+
+    mdsf::parser::ParseOptions options;
+    if (!GetMdsfParseOptions(isolate, args[0], &options)) {
+      return;
+    }
+
+    auto parser = new ArrayStreamParser(options);
+    parser->Wrap(args.This());
+    args.GetReturnValue().Set(args.This());
+  }
+
+  // parser.parse(chunk, elements)
+  static void Parse(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = args.GetIsolate();
+
+    if (args.Length() != 2) {
+      THROW_EXCEPTION(TypeError, "Wrong number of arguments");
+      return;
+    }
+    if (!args[1]->IsArray()) {
+      THROW_EXCEPTION(TypeError, "Wrong argument type");
+      return;
+    }
+
+    HandleScope scope(isolate);
+
+    auto parser = ObjectWrap::Unwrap<ArrayStreamParser>(args.Holder());
+    auto array = args[1].As<Array>();
+
+    if (args[0]->IsString()) {
+      String::Utf8Value str(
+#if NODE_MODULE_VERSION >= 57
+          isolate,
+#endif
+          args[0]
+      );
+      mdsf::parse_stats::ScopedParseTimer timer(str.length());
+      parser->parser_.Parse(isolate, *str, str.length(), true, array);
+    } else if (args[0]->IsUint8Array()) {
+      Local<Uint8Array> buf = args[0].As<Uint8Array>();
+      void* data = buf->Buffer()->GetContents().Data();
+      const char* str = static_cast<const char*>(data) + buf->ByteOffset();
+      mdsf::parse_stats::ScopedParseTimer timer(buf->ByteLength());
+      parser->parser_.Parse(isolate, str, buf->ByteLength(), false, array);
+    } else {
+      THROW_EXCEPTION(TypeError, "Wrong argument type");
+    }
+  }
+
+  // parser.finish(elements)
+  static void Finish(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = args.GetIsolate();
+
+    if (args.Length() != 1) {
+      THROW_EXCEPTION(TypeError, "Wrong number of arguments");
+      return;
+    }
+    if (!args[0]->IsArray()) {
+      THROW_EXCEPTION(TypeError, "Wrong argument type");
+      return;
+    }
+
+    HandleScope scope(isolate);
+
+    auto parser = ObjectWrap::Unwrap<ArrayStreamParser>(args.Holder());
+    parser->parser_.Finish(isolate, args[0].As<Array>());
+  }
+
+  mdsf::stream_parser::ArrayStreamParser parser_;
+};
+
+void Init(Local<Object> target,
+          Local<Value> module,
+          Local<Context> context,
+          void* priv) {
+  mdsf::simd::Initialize();
+
+  // Before worker threads were introduced the addon could only be loaded once
+  // per process, so the data lives as long as the process.
+  auto data = new AddonData();
+#if NODE_MODULE_VERSION >= 64
+  node::AddEnvironmentCleanupHook(context->GetIsolate(), DeleteAddonData,
+                                  data);
+#endif
+
   NODE_SET_METHOD(target, "parse", Parse);
-  NODE_SET_METHOD(target, "parseJSTPMessages", ParseJSTPMessages);
+  SetMethod(context, target, "parseJSTPMessages", ParseJSTPMessages, data);
+  NODE_SET_METHOD(target, "toJSON", ToJSON);
+  NODE_SET_METHOD(target, "validate", Validate);
+  NODE_SET_METHOD(target, "stringifyNumbers", StringifyNumbers);
+  NODE_SET_METHOD(target, "stringifyString", StringifyString);
+  NODE_SET_METHOD(target, "getStats", GetStats);
+  NODE_SET_METHOD(target, "resetStats", ResetStats);
+  NODE_SET_METHOD(target, "getSimdLevel", GetSimdLevel);
+  MessageStream::Init(target);
+  ArrayStreamParser::Init(target);
+  MessageCache::Init(target, data);
 }
 
-NODE_MODULE(mdsf, Init);
+NODE_MODULE_CONTEXT_AWARE(mdsf, Init);
 
 }  // namespace bindings
 
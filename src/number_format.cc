@@ -0,0 +1,445 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+//
+// Shortest round-trip formatting of doubles is done with the Grisu3
+// algorithm by Florian Loitsch ("Printing Floating-Point Numbers Quickly and
+// Accurately with Integers", PLDI 2010), the same one V8 uses as its fast
+// path. Grisu3 gives up on about 0.5% of doubles; for them the digits are
+// found by trying increasing precisions with the C library instead.
+
+#include "number_format.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace mdsf {
+
+namespace number_format {
+
+namespace {
+
+const char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// 64-bit floating-point number without a sign: f * 2^e.
+struct DiyFp {
+  std::uint64_t f;
+  int e;
+};
+
+const int kSignificandSize = 64;
+
+// Returns a * b rounded to 64 bits of the significand.
+DiyFp Multiply(DiyFp a, DiyFp b) {
+  const std::uint64_t kMask32 = 0xFFFFFFFFu;
+  std::uint64_t a_high = a.f >> 32, a_low = a.f & kMask32;
+  std::uint64_t b_high = b.f >> 32, b_low = b.f & kMask32;
+  std::uint64_t high_high = a_high * b_high;
+  std::uint64_t low_high = a_low * b_high;
+  std::uint64_t high_low = a_high * b_low;
+  std::uint64_t low_low = a_low * b_low;
+  std::uint64_t middle = (low_low >> 32) + (high_low & kMask32) +
+                         (low_high & kMask32);
+  middle += 1u << 31;  // Round the lower half.
+  return {high_high + (high_low >> 32) + (low_high >> 32) + (middle >> 32),
+          a.e + b.e + kSignificandSize};
+}
+
+DiyFp Normalize(DiyFp value) {
+  while ((value.f & (1ULL << 63)) == 0) {
+    value.f <<= 1;
+    value.e--;
+  }
+  return value;
+}
+
+struct CachedPower {
+  std::uint64_t significand;
+  std::int16_t binary_exponent;
+  std::int16_t decimal_exponent;
+};
+
+// Normalized approximations of 10^k for k from -348 to 340 in steps of 8.
+const CachedPower kCachedPowers[] = {
+    {0xfa8fd5a0081c0288ULL, -1220, -348},
+    {0xbaaee17fa23ebf76ULL, -1193, -340},
+    {0x8b16fb203055ac76ULL, -1166, -332},
+    {0xcf42894a5dce35eaULL, -1140, -324},
+    {0x9a6bb0aa55653b2dULL, -1113, -316},
+    {0xe61acf033d1a45dfULL, -1087, -308},
+    {0xab70fe17c79ac6caULL, -1060, -300},
+    {0xff77b1fcbebcdc4fULL, -1034, -292},
+    {0xbe5691ef416bd60cULL, -1007, -284},
+    {0x8dd01fad907ffc3cULL, -980, -276},
+    {0xd3515c2831559a83ULL, -954, -268},
+    {0x9d71ac8fada6c9b5ULL, -927, -260},
+    {0xea9c227723ee8bcbULL, -901, -252},
+    {0xaecc49914078536dULL, -874, -244},
+    {0x823c12795db6ce57ULL, -847, -236},
+    {0xc21094364dfb5637ULL, -821, -228},
+    {0x9096ea6f3848984fULL, -794, -220},
+    {0xd77485cb25823ac7ULL, -768, -212},
+    {0xa086cfcd97bf97f4ULL, -741, -204},
+    {0xef340a98172aace5ULL, -715, -196},
+    {0xb23867fb2a35b28eULL, -688, -188},
+    {0x84c8d4dfd2c63f3bULL, -661, -180},
+    {0xc5dd44271ad3cdbaULL, -635, -172},
+    {0x936b9fcebb25c996ULL, -608, -164},
+    {0xdbac6c247d62a584ULL, -582, -156},
+    {0xa3ab66580d5fdaf6ULL, -555, -148},
+    {0xf3e2f893dec3f126ULL, -529, -140},
+    {0xb5b5ada8aaff80b8ULL, -502, -132},
+    {0x87625f056c7c4a8bULL, -475, -124},
+    {0xc9bcff6034c13053ULL, -449, -116},
+    {0x964e858c91ba2655ULL, -422, -108},
+    {0xdff9772470297ebdULL, -396, -100},
+    {0xa6dfbd9fb8e5b88fULL, -369, -92},
+    {0xf8a95fcf88747d94ULL, -343, -84},
+    {0xb94470938fa89bcfULL, -316, -76},
+    {0x8a08f0f8bf0f156bULL, -289, -68},
+    {0xcdb02555653131b6ULL, -263, -60},
+    {0x993fe2c6d07b7facULL, -236, -52},
+    {0xe45c10c42a2b3b06ULL, -210, -44},
+    {0xaa242499697392d3ULL, -183, -36},
+    {0xfd87b5f28300ca0eULL, -157, -28},
+    {0xbce5086492111aebULL, -130, -20},
+    {0x8cbccc096f5088ccULL, -103, -12},
+    {0xd1b71758e219652cULL, -77, -4},
+    {0x9c40000000000000ULL, -50, 4},
+    {0xe8d4a51000000000ULL, -24, 12},
+    {0xad78ebc5ac620000ULL, 3, 20},
+    {0x813f3978f8940984ULL, 30, 28},
+    {0xc097ce7bc90715b3ULL, 56, 36},
+    {0x8f7e32ce7bea5c70ULL, 83, 44},
+    {0xd5d238a4abe98068ULL, 109, 52},
+    {0x9f4f2726179a2245ULL, 136, 60},
+    {0xed63a231d4c4fb27ULL, 162, 68},
+    {0xb0de65388cc8ada8ULL, 189, 76},
+    {0x83c7088e1aab65dbULL, 216, 84},
+    {0xc45d1df942711d9aULL, 242, 92},
+    {0x924d692ca61be758ULL, 269, 100},
+    {0xda01ee641a708deaULL, 295, 108},
+    {0xa26da3999aef774aULL, 322, 116},
+    {0xf209787bb47d6b85ULL, 348, 124},
+    {0xb454e4a179dd1877ULL, 375, 132},
+    {0x865b86925b9bc5c2ULL, 402, 140},
+    {0xc83553c5c8965d3dULL, 428, 148},
+    {0x952ab45cfa97a0b3ULL, 455, 156},
+    {0xde469fbd99a05fe3ULL, 481, 164},
+    {0xa59bc234db398c25ULL, 508, 172},
+    {0xf6c69a72a3989f5cULL, 534, 180},
+    {0xb7dcbf5354e9beceULL, 561, 188},
+    {0x88fcf317f22241e2ULL, 588, 196},
+    {0xcc20ce9bd35c78a5ULL, 614, 204},
+    {0x98165af37b2153dfULL, 641, 212},
+    {0xe2a0b5dc971f303aULL, 667, 220},
+    {0xa8d9d1535ce3b396ULL, 694, 228},
+    {0xfb9b7cd9a4a7443cULL, 720, 236},
+    {0xbb764c4ca7a44410ULL, 747, 244},
+    {0x8bab8eefb6409c1aULL, 774, 252},
+    {0xd01fef10a657842cULL, 800, 260},
+    {0x9b10a4e5e9913129ULL, 827, 268},
+    {0xe7109bfba19c0c9dULL, 853, 276},
+    {0xac2820d9623bf429ULL, 880, 284},
+    {0x80444b5e7aa7cf85ULL, 907, 292},
+    {0xbf21e44003acdd2dULL, 933, 300},
+    {0x8e679c2f5e44ff8fULL, 960, 308},
+    {0xd433179d9c8cb841ULL, 986, 316},
+    {0x9e19db92b4e31ba9ULL, 1013, 324},
+    {0xeb96bf6ebadf77d9ULL, 1039, 332},
+    {0xaf87023b9bf0ee6bULL, 1066, 340},
+};
+
+const int kCachedPowersOffset = 348;
+const int kDecimalExponentDistance = 8;
+
+// The range of binary exponents the scaled numbers must fall into so that
+// the digit generation can work with 32-bit integral parts.
+const int kMinimalTargetExponent = -60;
+const int kMaximalTargetExponent = -32;
+
+// Returns the cached power of ten c = 10^k such that the binary exponent of
+// w * c lies in the target range, where `exponent` is the binary exponent
+// of w.
+const CachedPower& GetCachedPower(int exponent) {
+  const double kInverseLog2Of10 = 0.30102999566398114;  // 1 / lg(10)
+  int min_exponent = kMinimalTargetExponent - (exponent + kSignificandSize);
+  int k = static_cast<int>(
+      std::ceil((min_exponent + kSignificandSize - 1) * kInverseLog2Of10));
+  int index = (kCachedPowersOffset + k - 1) / kDecimalExponentDistance + 1;
+  return kCachedPowers[index];
+}
+
+// Adjusts the last digit of the generated number towards `w` and checks
+// whether the result is guaranteed to be the closest shortest representation.
+// All the distances are in units of the scaled numbers.
+bool RoundWeed(char* buffer,
+               int length,
+               std::uint64_t distance_too_high_w,
+               std::uint64_t unsafe_interval,
+               std::uint64_t rest,
+               std::uint64_t ten_kappa,
+               std::uint64_t unit) {
+  std::uint64_t small_distance = distance_too_high_w - unit;
+  std::uint64_t big_distance = distance_too_high_w + unit;
+  while (rest < small_distance && unsafe_interval - rest >= ten_kappa &&
+         (rest + ten_kappa < small_distance ||
+          small_distance - rest >= rest + ten_kappa - small_distance)) {
+    buffer[length - 1]--;
+    rest += ten_kappa;
+  }
+  if (rest < big_distance && unsafe_interval - rest >= ten_kappa &&
+      (rest + ten_kappa < big_distance ||
+       big_distance - rest > rest + ten_kappa - big_distance)) {
+    return false;
+  }
+  return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+}
+
+// Generates the shortest digits of a number lying strictly between `low` and
+// `high` and as close to `w` as possible. `kappa` receives the decimal
+// exponent of the last generated digit.
+bool DigitGen(DiyFp low,
+              DiyFp w,
+              DiyFp high,
+              char* buffer,
+              int* length,
+              int* kappa) {
+  std::uint64_t unit = 1;
+  DiyFp too_low = {low.f - unit, low.e};
+  DiyFp too_high = {high.f + unit, high.e};
+  std::uint64_t unsafe_interval = too_high.f - too_low.f;
+  int one_shift = -w.e;
+  std::uint64_t one = 1ULL << one_shift;
+  std::uint32_t integrals = static_cast<std::uint32_t>(too_high.f >> one_shift);
+  std::uint64_t fractionals = too_high.f & (one - 1);
+
+  std::uint32_t divisor = 1000000000;
+  *kappa = 10;
+  while (divisor > integrals) {
+    divisor /= 10;
+    (*kappa)--;
+  }
+
+  *length = 0;
+  while (*kappa > 0) {
+    buffer[(*length)++] = static_cast<char>('0' + integrals / divisor);
+    integrals %= divisor;
+    (*kappa)--;
+    std::uint64_t rest =
+        (static_cast<std::uint64_t>(integrals) << one_shift) + fractionals;
+    if (rest < unsafe_interval) {
+      return RoundWeed(buffer, *length, too_high.f - w.f, unsafe_interval,
+                       rest, static_cast<std::uint64_t>(divisor) << one_shift,
+                       unit);
+    }
+    divisor /= 10;
+  }
+
+  for (;;) {
+    fractionals *= 10;
+    unit *= 10;
+    unsafe_interval *= 10;
+    buffer[(*length)++] = static_cast<char>('0' + (fractionals >> one_shift));
+    fractionals &= one - 1;
+    (*kappa)--;
+    if (fractionals < unsafe_interval) {
+      return RoundWeed(buffer, *length, (too_high.f - w.f) * unit,
+                       unsafe_interval, fractionals, one, unit);
+    }
+  }
+}
+
+// Finds the shortest digits of a positive finite `value` such that
+// value == digits * 10^exponent. Returns false if the result can't be
+// guaranteed to be correct.
+bool Grisu3(double value, char* digits, int* length, int* exponent) {
+  const std::uint64_t kHiddenBit = 1ULL << 52;
+  const std::uint64_t kSignificandMask = kHiddenBit - 1;
+  const int kExponentBias = 0x3FF + 52;
+  const int kDenormalExponent = 1 - kExponentBias;
+
+  std::uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  int biased_exponent = static_cast<int>(bits >> 52) & 0x7FF;
+  DiyFp v;
+  if (biased_exponent == 0) {
+    v = {bits & kSignificandMask, kDenormalExponent};
+  } else {
+    v = {(bits & kSignificandMask) | kHiddenBit,
+         biased_exponent - kExponentBias};
+  }
+
+  // The boundaries are halfway between `value` and its neighbours, the lower
+  // one is closer when `value` is a power of two.
+  DiyFp plus = Normalize({(v.f << 1) + 1, v.e - 1});
+  DiyFp minus;
+  if (v.f == kHiddenBit && v.e != kDenormalExponent) {
+    minus = {(v.f << 2) - 1, v.e - 2};
+  } else {
+    minus = {(v.f << 1) - 1, v.e - 1};
+  }
+  minus.f <<= minus.e - plus.e;
+  minus.e = plus.e;
+  DiyFp w = Normalize(v);
+
+  const CachedPower& cached = GetCachedPower(w.e);
+  DiyFp ten_mk = {cached.significand, cached.binary_exponent};
+
+  int kappa;
+  bool result = DigitGen(Multiply(minus, ten_mk), Multiply(w, ten_mk),
+                         Multiply(plus, ten_mk), digits, length, &kappa);
+  *exponent = kappa - cached.decimal_exponent;
+  return result;
+}
+
+// Slow but always correct replacement for Grisu3(): the correctly rounded
+// representation with the smallest precision that round-trips is both the
+// shortest and the closest one.
+void FindShortestDigits(double value, char* digits, int* length,
+                        int* exponent) {
+  char buffer[32];
+  for (int precision = 1; precision <= 17; precision++) {
+    std::snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, value);
+    if (std::strtod(buffer, nullptr) == value) {
+      break;
+    }
+  }
+  // The buffer contains "d.ddde[+-]xx" (without the point for a single
+  // digit), the point can be locale-specific.
+  char* cursor = buffer;
+  *length = 0;
+  for (; *cursor != 'e'; cursor++) {
+    if (*cursor >= '0' && *cursor <= '9') {
+      digits[(*length)++] = *cursor;
+    }
+  }
+  *exponent = std::atoi(cursor + 1) - (*length - 1);
+}
+
+char* WriteUint64(std::uint64_t value, char* out) {
+  char buffer[20];
+  char* cursor = buffer + sizeof(buffer);
+  while (value >= 100) {
+    std::size_t index = static_cast<std::size_t>(value % 100) * 2;
+    value /= 100;
+    *--cursor = kDigitPairs[index + 1];
+    *--cursor = kDigitPairs[index];
+  }
+  if (value >= 10) {
+    std::size_t index = static_cast<std::size_t>(value) * 2;
+    *--cursor = kDigitPairs[index + 1];
+    *--cursor = kDigitPairs[index];
+  } else {
+    *--cursor = static_cast<char>('0' + value);
+  }
+  std::size_t length = buffer + sizeof(buffer) - cursor;
+  std::memcpy(out, cursor, length);
+  return out + length;
+}
+
+char* WriteString(const char* str, std::size_t length, char* out) {
+  std::memcpy(out, str, length);
+  return out + length;
+}
+
+// Writes digits * 10^exponent following the rules of Number::toString() from
+// the ECMAScript specification.
+char* WriteDecimal(const char* digits, int length, int exponent, char* out) {
+  int point = length + exponent;
+  if (length <= point && point <= 21) {
+    out = WriteString(digits, length, out);
+    std::memset(out, '0', point - length);
+    return out + point - length;
+  }
+  if (0 < point && point <= 21) {
+    out = WriteString(digits, point, out);
+    *out++ = '.';
+    return WriteString(digits + point, length - point, out);
+  }
+  if (-6 < point && point <= 0) {
+    *out++ = '0';
+    *out++ = '.';
+    std::memset(out, '0', -point);
+    out += -point;
+    return WriteString(digits, length, out);
+  }
+  *out++ = digits[0];
+  if (length > 1) {
+    *out++ = '.';
+    out = WriteString(digits + 1, length - 1, out);
+  }
+  *out++ = 'e';
+  int decimal_exponent = point - 1;
+  if (decimal_exponent < 0) {
+    *out++ = '-';
+    decimal_exponent = -decimal_exponent;
+  } else {
+    *out++ = '+';
+  }
+  return WriteUint32(static_cast<std::uint32_t>(decimal_exponent), out);
+}
+
+}  // namespace
+
+char* WriteUint32(std::uint32_t value, char* out) {
+  return WriteUint64(value, out);
+}
+
+char* WriteInt32(std::int32_t value, char* out) {
+  std::uint32_t magnitude = static_cast<std::uint32_t>(value);
+  if (value < 0) {
+    *out++ = '-';
+    magnitude = 0u - magnitude;
+  }
+  return WriteUint64(magnitude, out);
+}
+
+char* WriteDouble(double value, char* out) {
+  if (std::isnan(value)) {
+    return WriteString("NaN", 3, out);
+  }
+  if (value == 0) {
+    // Both 0 and -0.
+    *out++ = '0';
+    return out;
+  }
+  if (value < 0) {
+    *out++ = '-';
+    value = -value;
+  }
+  if (std::isinf(value)) {
+    return WriteString("Infinity", 8, out);
+  }
+
+  // Every integer below 2^53 is exactly representable, so its own digits are
+  // the shortest ones.
+  const double kMaxSafeInteger = 9007199254740991.0;
+  if (value <= kMaxSafeInteger && std::floor(value) == value) {
+    return WriteUint64(static_cast<std::uint64_t>(value), out);
+  }
+
+  char digits[32];
+  int length;
+  int exponent;
+  if (!Grisu3(value, digits, &length, &exponent)) {
+    FindShortestDigits(value, digits, &length, &exponent);
+  }
+  return WriteDecimal(digits, length, exponent, out);
+}
+
+}  // namespace number_format
+
+}  // namespace mdsf
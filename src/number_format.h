@@ -0,0 +1,36 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef SRC_NUMBER_FORMAT_H_
+#define SRC_NUMBER_FORMAT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mdsf {
+
+namespace number_format {
+
+// Maximum number of characters written by WriteDouble(), reached by numbers
+// like "-0.0000022250738585072014".
+const std::size_t kMaxDoubleLength = 25;
+
+// Maximum number of characters written by WriteInt32() or WriteUint32().
+const std::size_t kMaxInt32Length = 11;
+
+// Writes the decimal representation of `value` to `out` and returns the
+// pointer past the last written character.
+char* WriteUint32(std::uint32_t value, char* out);
+char* WriteInt32(std::int32_t value, char* out);
+
+// Writes `value` to `out` exactly as Number.prototype.toString() would do it:
+// the shortest sequence of digits that round-trips to the same double, with
+// the same choice between the fixed and the exponential notation. Returns the
+// pointer past the last written character.
+char* WriteDouble(double value, char* out);
+
+}  // namespace number_format
+
+}  // namespace mdsf
+
+#endif  // SRC_NUMBER_FORMAT_H_
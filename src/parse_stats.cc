@@ -0,0 +1,64 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#include "parse_stats.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+using std::size_t;
+using std::uint64_t;
+
+namespace mdsf {
+
+namespace parse_stats {
+
+size_t GetSizeBucketLimit(size_t index) {
+  if (index + 1 >= kSizeBucketCount) {
+    return 0;
+  }
+  return static_cast<size_t>(64) << (2 * index);
+}
+
+#if defined(_PARSER_ENABLE_STATS_)
+
+static thread_local Counters counters;
+
+Counters* GetCounters() {
+  return &counters;
+}
+
+void ResetCounters() {
+  std::memset(&counters, 0, sizeof(counters));
+}
+
+static size_t GetSizeBucket(size_t input_size) {
+  size_t index = 0;
+  while (index + 1 < kSizeBucketCount &&
+         input_size >= GetSizeBucketLimit(index)) {
+    index++;
+  }
+  return index;
+}
+
+ScopedParseTimer::ScopedParseTimer(size_t input_size)
+    : input_size_(input_size), start_(std::chrono::steady_clock::now()) {}
+
+ScopedParseTimer::~ScopedParseTimer() {
+  auto elapsed = std::chrono::steady_clock::now() - start_;
+  uint64_t ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  TimeBucket& bucket = counters.parse_time[GetSizeBucket(input_size_)];
+  bucket.count++;
+  bucket.total_ns += ns;
+  if (ns > bucket.max_ns) {
+    bucket.max_ns = ns;
+  }
+}
+
+#endif  // defined(_PARSER_ENABLE_STATS_)
+
+}  // namespace parse_stats
+
+}  // namespace mdsf
@@ -0,0 +1,89 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef SRC_PARSE_STATS_H_
+#define SRC_PARSE_STATS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_PARSER_ENABLE_STATS_)
+#include <chrono>
+#endif
+
+namespace mdsf {
+
+namespace parse_stats {
+
+// Parse time histogram buckets are selected by the input size: the first
+// one is for inputs shorter than 64 bytes and each next one covers inputs up
+// to 4 times larger, the last one covers everything above 1 MiB.
+const std::size_t kSizeBucketCount = 9;
+
+struct TimeBucket {
+  std::uint64_t count;
+  std::uint64_t total_ns;
+  std::uint64_t max_ns;
+};
+
+struct Counters {
+  std::uint64_t bytes_parsed;
+  std::uint64_t messages_parsed;
+  std::uint64_t objects;
+  std::uint64_t arrays;
+  std::uint64_t strings;
+  std::uint64_t escaped_strings;
+  std::uint64_t deduplicated_strings;
+  std::uint64_t fast_numbers;
+  std::uint64_t slow_numbers;
+  std::uint64_t scratch_allocations;
+  TimeBucket parse_time[kSizeBucketCount];
+};
+
+// Returns the upper bound (exclusive) of the input sizes that fall into the
+// bucket `index`, or 0 for the last bucket which has no upper bound.
+std::size_t GetSizeBucketLimit(std::size_t index);
+
+#if defined(_PARSER_ENABLE_STATS_)
+
+// Returns the counters of the current thread. Since every isolate runs on its
+// own thread this makes the counters per-isolate without any locking.
+Counters* GetCounters();
+
+// Sets all of the counters of the current thread to zero.
+void ResetCounters();
+
+// Measures the time spent parsing an input of the given size and records
+// it in the histogram when destroyed.
+class ScopedParseTimer {
+ public:
+  explicit ScopedParseTimer(std::size_t input_size);
+  ~ScopedParseTimer();
+
+ private:
+  std::size_t input_size_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+#define MDSF_STATS_ADD(counter, value)                                         \
+  (::mdsf::parse_stats::GetCounters()->counter += (value))
+
+#else
+
+// Counters are not compiled in, so that they don't cost anything.
+class ScopedParseTimer {
+ public:
+  explicit ScopedParseTimer(std::size_t input_size) {}
+};
+
+#define MDSF_STATS_ADD(counter, value) ((void)0)
+
+#endif  // defined(_PARSER_ENABLE_STATS_)
+
+#define MDSF_STATS_INC(counter) MDSF_STATS_ADD(counter, 1)
+
+}  // namespace parse_stats
+
+}  // namespace mdsf
+
+#endif  // SRC_PARSE_STATS_H_
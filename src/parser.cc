@@ -15,15 +15,18 @@
 #include <functional>
 #include <vector>
 
+
+#include "char_class.h"
 #include "common.h"
+#include "parse_stats.h"
+#include "simd.h"
+#include "structural_index.h"
+#include "tracing.h"
 #include "unicode_utils.h"
 
 using std::atof;
 using std::function;
-using std::isalnum;
-using std::isalpha;
-using std::isdigit;
-using std::isxdigit;
+using std::memchr;
 using std::memcpy;
 using std::memset;
 using std::ptrdiff_t;
@@ -31,12 +34,15 @@ using std::size_t;
 using std::strncmp;
 using std::strncpy;
 using std::strtol;
-using std::toupper;
 
 using v8::Array;
+using v8::ArrayBuffer;
 using v8::False;
+using v8::Float64Array;
+using v8::Int32Array;
 using v8::Integer;
 using v8::Isolate;
+using v8::Just;
 using v8::Local;
 using v8::Maybe;
 using v8::MaybeLocal;
@@ -49,6 +55,19 @@ using v8::True;
 using v8::Undefined;
 using v8::Value;
 
+using mdsf::char_class::GetCharClasses;
+using mdsf::char_class::GetValueKind;
+using mdsf::char_class::HexDigitValue;
+using mdsf::char_class::IsDigit;
+using mdsf::char_class::IsHexDigit;
+using mdsf::char_class::kCheckedValueStart;
+using mdsf::char_class::kIdentifierPart;
+using mdsf::char_class::kIdentifierStart;
+using mdsf::char_class::kJsonWhiteSpace;
+using mdsf::char_class::kUnicodeSpaceLead;
+using mdsf::char_class::kValueStart;
+using mdsf::char_class::kWhiteSpace;
+
 using mdsf::unicode_utils::CodePointToUtf8;
 using mdsf::unicode_utils::IsWhiteSpaceCharacter;
 using mdsf::unicode_utils::IsLineTerminatorSequence;
@@ -60,120 +79,628 @@ namespace mdsf {
 
 namespace parser {
 
-// Enumeration of supported JavaScript types used for deserialization
-// function selection.
-enum Type {
-  kUndefined = 0, kNull, kBool, kNumber, kString, kArray, kObject, kDate
+static_assert(static_cast<int>(Type::kObject) ==
+                  static_cast<int>(char_class::kObjectValue),
+              "Type must list the kinds of values in the same order as "
+              "char_class::ValueKind");
+
+typedef MaybeLocal<Value> (*ParseFunction)(Isolate*,
+                                            const char*,
+                                            const char*,
+                                            size_t*);
+
+// The table of parsing functions of the dialect indexed with the values of
+// the Type enumeration.
+template <typename Dialect>
+struct ParseFunctions {
+  static const ParseFunction kTable[];
 };
 
-// Parses the type of the serialized JavaScript value at the position `begin`
-// and before `end`. Returns true if it was able to detect the type, false
-// otherwise.
-static bool GetType(const char* begin, const char* end, Type* type);
-
-// The table of parsing functions indexed with the values of the Type
-// enumeration.
-static constexpr MaybeLocal<Value> (*kParseFunctions[])(Isolate*,
-                                                        const char*,
-                                                        const char*,
-                                                        size_t*) = {
+template <typename Dialect>
+const ParseFunction ParseFunctions<Dialect>::kTable[] = {
   &internal::ParseUndefined,
   &internal::ParseNull,
   &internal::ParseBool,
-  &internal::ParseNumber,
-  &internal::ParseString,
-  &internal::ParseArray,
-  &internal::ParseObject
+  &internal::ParseNumber<Dialect>,
+  &internal::ParseString<Dialect>,
+  // Arrays and objects are parsed by BasicValueParser itself, which enforces
+  // the parsing options on them.
+  nullptr,
+  nullptr
 };
 
-Local<Value> Parse(Isolate* isolate, const char* str, size_t length) {
+template <typename Dialect>
+static Local<Value> ParseWithDialect(Isolate*            isolate,
+                                     const char*         str,
+                                     size_t              length,
+                                     const ParseOptions& options) {
   const char* end = str + length;
 
-  Type type;
-
-  size_t start_pos = internal::SkipToNextToken(str, end);
-  if (!GetType(str + start_pos, end, &type)) {
-    THROW_EXCEPTION(TypeError, "Invalid type");
-    return Undefined(isolate);
+  BasicValueParser<Dialect> parser(options);
+  structural_index::StructuralIndex index;
+  unsigned thread_count = structural_index::GetThreadCount();
+  if (length >= structural_index::kMinParallelSize && thread_count > 1) {
+    mdsf::tracing::ScopedSpan span("mdsf.parse.index");
+    if (index.Build<Dialect>(str, length, thread_count)) {
+      parser.SetStructuralIndex(&index);
+    }
   }
 
   size_t parsed_size = 0;
-  MaybeLocal<Value> result = kParseFunctions[type](isolate,
-                                                   str + start_pos,
-                                                   end,
-                                                   &parsed_size);
-
-  if (result.IsEmpty()) {
+  if (parser.Parse(isolate, str, end, true, &parsed_size) !=
+      BasicValueParser<Dialect>::kComplete) {
     return Undefined(isolate);
   }
 
-  parsed_size += internal::SkipToNextToken(str + start_pos + parsed_size, end);
-  parsed_size += start_pos;
+  parsed_size += internal::SkipToNextToken<Dialect>(str + parsed_size, end);
 
   if (length != parsed_size) {
     THROW_EXCEPTION(SyntaxError, "Invalid format");
     return Undefined(isolate);
   }
 
-  return result.ToLocalChecked();
+  return parser.Result();
 }
 
-static bool GetType(const char* begin, const char* end, Type* type) {
-  bool result = true;
+Local<Value> Parse(Isolate*            isolate,
+                   const char*         str,
+                   size_t              length,
+                   const ParseOptions& options) {
+  if (options.dialect == Dialect::kJson) {
+    return ParseWithDialect<JsonDialect>(isolate, str, length, options);
+  }
+  return ParseWithDialect<MdsfDialect>(isolate, str, length, options);
+}
+
+template <typename Dialect>
+bool GetType(const char* begin, const char* end, Type* type) {
+  const uint16_t classes = GetCharClasses(*begin);
+  if (!(classes & kValueStart)) {
+    return false;
+  }
+  *type = static_cast<Type>(GetValueKind(classes));
+  if (!(classes & kCheckedValueStart)) {
+    return true;
+  }
   switch (*begin) {
+    case '\'': {
+      return Dialect::kAllowSingleQuotes;
+    }
+    case 'n': {
+      return begin + 4 > end || strncmp(begin, "null", 4) == 0;
+    }
+    case 'u': {
+      return Dialect::kAllowUndefined &&
+             (begin + 9 > end || strncmp(begin, "undefined", 9) == 0);
+    }
     case ',':
     case ']': {
-      *type = Type::kUndefined;
-      break;
+      return Dialect::kAllowUndefined;
     }
-    case '{': {
-      *type = Type::kObject;
-      break;
+    default: {
+      // N, I, . and +.
+      return Dialect::kAllowExtendedNumbers;
     }
-    case '[': {
-      *type = Type::kArray;
-      break;
+  }
+}
+
+template <typename Dialect>
+BasicValueParser<Dialect>::BasicValueParser(const ParseOptions& options)
+    : max_depth_(options.max_depth),
+      typed_arrays_(options.typed_arrays),
+      deduplicate_strings_(options.deduplicate_strings),
+      use_key_dictionary_(options.key_dictionary),
+      is_complete_(false),
+      is_suspended_(false),
+      string_table_generation_(0),
+      string_table_count_(0),
+      token_scanned_length_(0),
+      structural_index_(nullptr) {}
+
+template <typename Dialect>
+typename BasicValueParser<Dialect>::Status BasicValueParser<Dialect>::Parse(
+    Isolate*    isolate,
+    const char* begin,
+    const char* end,
+    bool        is_last,
+    size_t*     size) {
+  Resume(isolate);
+
+  if (deduplicate_strings_) {
+    // The handles and the pointers to the data stored in the table are only
+    // valid during this call.
+    if (++string_table_generation_ == 0) {
+      string_table_.clear();
+      string_table_generation_ = 1;
     }
-    case '\"':
-    case '\'': {
-      *type = Type::kString;
-      break;
+    string_table_count_ = 0;
+  }
+
+  auto context = isolate->GetCurrentContext();
+  const char* current = begin;
+  bool is_incomplete = false;
+  size_t current_length = 0;
+  Type current_type;
+
+  while (!is_complete_) {
+    if (structural_index_ != nullptr) {
+      current = structural_index_->SkipToNextToken(current);
+    } else {
+      current += internal::SkipToNextTokenInChunk<Dialect>(current, end,
+                                                           is_last,
+                                                           &is_incomplete);
     }
-    case 't':
-    case 'f': {
-      *type = Type::kBool;
-      break;
+    if (is_incomplete || (current == end && !is_last)) {
+      *size = current - begin;
+      MDSF_STATS_ADD(bytes_parsed, *size);
+      return kIncomplete;
     }
-    case 'n': {
-      *type = Type::kNull;
-      if (begin + 4 <= end) {
-        result = (strncmp(begin, "null", 4) == 0);
+
+    if (current == end) {
+      if (stack_.empty()) {
+        THROW_EXCEPTION(TypeError, "Invalid type");
+      } else if (stack_.back().state == kArrayElement ||
+                 stack_.back().state == kArrayDelimiter) {
+        THROW_EXCEPTION(SyntaxError, "Missing closing bracket in array");
+      } else {
+        THROW_EXCEPTION(SyntaxError, "Missing closing brace in object");
       }
-      break;
+      Reset();
+      return kError;
     }
-    case 'u': {
-      *type = Type::kUndefined;
-      if (begin + 9 <= end) {
-        result = (strncmp(begin, "undefined", 9) == 0);
+
+    const char* invalid_type_message = "Invalid type";
+
+    if (!stack_.empty()) {
+      Frame& frame = stack_.back();
+      switch (frame.state) {
+        case kArrayElement: {
+          if (*current == ']' &&
+              (Dialect::kAllowTrailingCommas || frame.index == 0)) {
+            current++;
+            Local<Object> array = FinishArray(isolate, &frame);
+            stack_.pop_back();
+            if (!AddValue(isolate, array)) {
+              return kError;
+            }
+            continue;
+          }
+          invalid_type_message = "Invalid type in array";
+          break;
+        }
+        case kArrayDelimiter: {
+          if (*current == ',') {
+            current++;
+            frame.state = kArrayElement;
+          } else if (*current == ']') {
+            current++;
+            Local<Object> array = FinishArray(isolate, &frame);
+            stack_.pop_back();
+            if (!AddValue(isolate, array)) {
+              return kError;
+            }
+          } else {
+            THROW_EXCEPTION(SyntaxError,
+                            "Invalid format in array: missed comma");
+            Reset();
+            return kError;
+          }
+          continue;
+        }
+        case kObjectKey: {
+          if (*current == '}' &&
+              (Dialect::kAllowTrailingCommas || frame.index == 0)) {
+            current++;
+            Local<Object> object = frame.container;
+            stack_.pop_back();
+            if (!AddValue(isolate, object)) {
+              return kError;
+            }
+            continue;
+          }
+          if (use_key_dictionary_ && *current == '#') {
+            // A reference to a key from the dictionary.
+            const char* digits_end = current + 1;
+            size_t index = 0;
+            while (digits_end < end && IsDigit(*digits_end) &&
+                   index < kMaxKeyDictionarySize) {
+              index = index * 10 + (*digits_end - '0');
+              digits_end++;
+            }
+            if (digits_end == end && !is_last) {
+              *size = current - begin;
+              MDSF_STATS_ADD(bytes_parsed, *size);
+              return kIncomplete;
+            }
+            if (digits_end == current + 1 ||
+                index >= key_dictionary_.size()) {
+              THROW_EXCEPTION(SyntaxError, "Unknown key reference");
+              Reset();
+              return kError;
+            }
+            frame.key = Local<String>::New(isolate, key_dictionary_[index]);
+            frame.state = kObjectColon;
+            current = digits_end;
+            continue;
+          }
+          if (!is_last && !IsTokenCompleteInChunk(begin, current, end)) {
+            *size = current - begin;
+            MDSF_STATS_ADD(bytes_parsed, *size);
+            return kIncomplete;
+          }
+          MaybeLocal<String> key;
+          if (!Dialect::kAllowUnquotedKeys || !IsDigit(*current)) {
+            key = internal::ParseKeyInObject<Dialect>(isolate, current, end,
+                                                      &current_length);
+          } else {
+            MaybeLocal<Value> numeric_key = internal::ParseNumber<Dialect>(
+                isolate, current, end, &current_length);
+            if (!numeric_key.IsEmpty()) {
+              key = numeric_key.ToLocalChecked()->ToString(context);
+            }
+          }
+          if (key.IsEmpty()) {
+            Reset();
+            return kError;
+          }
+          frame.key = key.ToLocalChecked();
+          if (use_key_dictionary_ &&
+              key_dictionary_.size() < kMaxKeyDictionarySize) {
+            key_dictionary_.emplace_back(isolate, frame.key);
+          }
+          frame.state = kObjectColon;
+          current += current_length;
+          continue;
+        }
+        case kObjectColon: {
+          if (*current != ':') {
+            THROW_EXCEPTION(SyntaxError, "Unexpected token");
+            Reset();
+            return kError;
+          }
+          current++;
+          frame.state = kObjectValue;
+          continue;
+        }
+        case kObjectValue: {
+          if (*current == ',') {
+            THROW_EXCEPTION(SyntaxError, "Value is missing in object");
+            Reset();
+            return kError;
+          }
+          invalid_type_message = "Invalid type in object";
+          break;
+        }
+        case kObjectDelimiter: {
+          if (*current == ',') {
+            current++;
+            frame.state = kObjectKey;
+          } else if (*current == '}') {
+            current++;
+            Local<Object> object = frame.container;
+            stack_.pop_back();
+            if (!AddValue(isolate, object)) {
+              return kError;
+            }
+          } else {
+            THROW_EXCEPTION(SyntaxError, "Invalid format in object");
+            Reset();
+            return kError;
+          }
+          continue;
+        }
       }
-      break;
     }
-    case 'N':
-    case 'I': {
-      *type = Type::kNumber;
-      break;
+
+    // A value is expected at this point.
+    if (!GetType<Dialect>(current, end, &current_type)) {
+      THROW_EXCEPTION(TypeError, invalid_type_message);
+      Reset();
+      return kError;
     }
-    default: {
-      result = false;
-      if (isdigit(*begin) || *begin == '.' || *begin == '+' || *begin == '-') {
-        *type = Type::kNumber;
-        result = true;
+
+    if (current_type == Type::kArray || current_type == Type::kObject) {
+      if (stack_.size() >= max_depth_) {
+        THROW_EXCEPTION(RangeError, "Maximum nesting depth exceeded");
+        Reset();
+        return kError;
+      }
+      if (!stack_.empty() && stack_.back().is_numeric &&
+          !MaterializeNumbers(isolate, &stack_.back())) {
+        return kError;
+      }
+      Frame frame;
+      frame.index = 0;
+      frame.is_numeric = false;
+      frame.is_int32 = false;
+      if (current_type == Type::kArray) {
+        frame.state = kArrayElement;
+        if (typed_arrays_) {
+          frame.is_numeric = true;
+          frame.is_int32 = true;
+        } else {
+          frame.container = Array::New(isolate);
+        }
+        MDSF_STATS_INC(arrays);
+      } else {
+        frame.state = kObjectKey;
+        frame.container = Object::New(isolate);
+        MDSF_STATS_INC(objects);
+      }
+      stack_.push_back(frame);
+      current++;
+      continue;
+    }
+
+    if (!is_last && !IsTokenCompleteInChunk(begin, current, end)) {
+      *size = current - begin;
+      MDSF_STATS_ADD(bytes_parsed, *size);
+      return kIncomplete;
+    }
+
+    if (!stack_.empty() && stack_.back().is_numeric) {
+      Frame& frame = stack_.back();
+      if (current_type == Type::kNumber) {
+        // Elements of numeric arrays are stored without creating any handles.
+        double number;
+        if (!internal::ParseNumberValue<Dialect>(isolate, current, end,
+                                                 &current_length, &number)) {
+          Reset();
+          return kError;
+        }
+        current += current_length;
+        if (current > end) {
+          THROW_EXCEPTION(SyntaxError, "Unexpected end of data");
+          Reset();
+          return kError;
+        }
+        numbers_.push_back(number);
+        frame.is_int32 = frame.is_int32 && internal::IsInt32(number);
+        frame.index++;
+        frame.state = kArrayDelimiter;
+        continue;
+      }
+      if (!MaterializeNumbers(isolate, &frame)) {
+        return kError;
       }
     }
+
+    MaybeLocal<Value> value;
+    if (deduplicate_strings_ && current_type == Type::kString) {
+      value = ParseDeduplicatedString(isolate, current, end, &current_length);
+    } else {
+      value = ParseFunctions<Dialect>::kTable[current_type](isolate,
+                                                            current,
+                                                            end,
+                                                            &current_length);
+    }
+    if (value.IsEmpty()) {
+      Reset();
+      return kError;
+    }
+    current += current_length;
+    if (current > end) {
+      THROW_EXCEPTION(SyntaxError, "Unexpected end of data");
+      Reset();
+      return kError;
+    }
+    if (!AddValue(isolate, value.ToLocalChecked())) {
+      return kError;
+    }
+  }
+
+  *size = current - begin;
+  MDSF_STATS_ADD(bytes_parsed, *size);
+  return kComplete;
+}
+
+template <typename Dialect>
+bool BasicValueParser<Dialect>::IsTokenCompleteInChunk(const char* begin,
+                                                       const char* current,
+                                                       const char* end) {
+  if (current != begin) {
+    token_scanned_length_ = 0;
+  }
+  if (internal::IsTokenComplete(current, end, &token_scanned_length_)) {
+    token_scanned_length_ = 0;
+    return true;
   }
+  return false;
+}
+
+template <typename Dialect>
+bool BasicValueParser<Dialect>::AddValue(Isolate* isolate,
+                                         Local<Value> value) {
+  if (stack_.empty()) {
+    result_ = value;
+    is_complete_ = true;
+    return true;
+  }
+
+  Frame& frame = stack_.back();
+  Maybe<bool> is_ok = Just(true);
+  if (frame.state == kArrayElement) {
+    is_ok = frame.container->Set(isolate->GetCurrentContext(),
+                                 frame.index++,
+                                 value);
+    frame.state = kArrayDelimiter;
+  } else {
+    if (!value->IsUndefined()) {
+      is_ok = frame.container->Set(isolate->GetCurrentContext(),
+                                   frame.key,
+                                   value);
+    }
+    // Only used to tell whether the object is empty.
+    frame.index++;
+    frame.state = kObjectDelimiter;
+  }
+
+  if (is_ok.IsNothing()) {
+    THROW_EXCEPTION(Error, "Cannot add value to array or object");
+    Reset();
+    return false;
+  }
+  return true;
+}
+
+template <typename Dialect>
+bool BasicValueParser<Dialect>::MaterializeNumbers(Isolate* isolate,
+                                                   Frame* frame) {
+  auto context = isolate->GetCurrentContext();
+  Local<Array> array = Array::New(isolate, static_cast<int>(numbers_.size()));
+  for (uint32_t i = 0; i < numbers_.size(); i++) {
+    if (array->Set(context, i, internal::NewNumber(isolate, numbers_[i]))
+            .IsNothing()) {
+      THROW_EXCEPTION(Error, "Cannot add value to array or object");
+      Reset();
+      return false;
+    }
+  }
+  numbers_.clear();
+  frame->container = array;
+  frame->is_numeric = false;
+  return true;
+}
+
+template <typename Dialect>
+Local<Object> BasicValueParser<Dialect>::FinishArray(Isolate* isolate,
+                                                     Frame* frame) {
+  if (!frame->is_numeric) {
+    return frame->container;
+  }
+  size_t length = numbers_.size();
+  if (length == 0) {
+    // The type of elements of an empty array is unknown.
+    return Array::New(isolate);
+  }
+
+  Local<Object> result;
+  if (frame->is_int32) {
+    Local<ArrayBuffer> buffer =
+        ArrayBuffer::New(isolate, length * sizeof(int32_t));
+    auto data = static_cast<int32_t*>(buffer->GetContents().Data());
+    for (size_t i = 0; i < length; i++) {
+      data[i] = static_cast<int32_t>(numbers_[i]);
+    }
+    result = Int32Array::New(buffer, 0, length);
+  } else {
+    Local<ArrayBuffer> buffer =
+        ArrayBuffer::New(isolate, length * sizeof(double));
+    memcpy(buffer->GetContents().Data(), numbers_.data(),
+           length * sizeof(double));
+    result = Float64Array::New(buffer, 0, length);
+  }
+  numbers_.clear();
   return result;
 }
 
+template <typename Dialect>
+MaybeLocal<Value> BasicValueParser<Dialect>::ParseDeduplicatedString(
+    Isolate*    isolate,
+    const char* begin,
+    const char* end,
+    size_t*     size) {
+  // Find the end of the token without decoding it. Tokens that are too long
+  // or not terminated are left to ParseString() entirely.
+  const char quote = *begin;
+  const char* limit = begin + kMaxDeduplicatedStringLength + 2;
+  if (limit > end) {
+    limit = end;
+  }
+  const char* current = begin + 1;
+  while (current < limit && *current != quote) {
+    if (*current == '\\') {
+      current++;
+    }
+    current++;
+  }
+  if (current >= limit) {
+    return internal::ParseString<Dialect>(isolate, begin, end, size);
+  }
+  size_t length = current + 1 - begin;
+
+  // FNV-1a.
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++) {
+    hash = (hash ^ static_cast<unsigned char>(begin[i])) * 16777619u;
+  }
+
+  if (string_table_.empty()) {
+    string_table_.resize(kStringTableSize);
+  }
+  const size_t mask = kStringTableSize - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    StringTableEntry& entry = string_table_[i];
+    if (entry.generation != string_table_generation_) {
+      MaybeLocal<Value> value =
+          internal::ParseString<Dialect>(isolate, begin, end, size);
+      // Keep a quarter of the table empty so that lookups stay short.
+      if (!value.IsEmpty() &&
+          string_table_count_ < kStringTableSize / 4 * 3) {
+        entry.generation = string_table_generation_;
+        entry.hash = hash;
+        entry.token = begin;
+        entry.length = length;
+        entry.value = value.ToLocalChecked().As<String>();
+        string_table_count_++;
+      }
+      return value;
+    }
+    if (entry.hash == hash && entry.length == length &&
+        memcmp(entry.token, begin, length) == 0) {
+      *size = length;
+      MDSF_STATS_INC(deduplicated_strings);
+      return entry.value;
+    }
+  }
+}
+
+template <typename Dialect>
+void BasicValueParser<Dialect>::Suspend(Isolate* isolate) {
+  suspended_handles_.clear();
+  suspended_handles_.reserve(stack_.size() * 2 + 1);
+  for (const Frame& frame : stack_) {
+    suspended_handles_.emplace_back(isolate, frame.container);
+    suspended_handles_.emplace_back(isolate, frame.key);
+  }
+  suspended_handles_.emplace_back(isolate, result_);
+  is_suspended_ = true;
+}
+
+template <typename Dialect>
+void BasicValueParser<Dialect>::Resume(Isolate* isolate) {
+  if (!is_suspended_) {
+    return;
+  }
+  size_t index = 0;
+  for (Frame& frame : stack_) {
+    frame.container = Local<Value>::New(
+        isolate, suspended_handles_[index++]).As<Object>();
+    frame.key = Local<Value>::New(
+        isolate, suspended_handles_[index++]).As<String>();
+  }
+  result_ = Local<Value>::New(isolate, suspended_handles_[index]);
+  suspended_handles_.clear();
+  is_suspended_ = false;
+}
+
+template <typename Dialect>
+void BasicValueParser<Dialect>::Reset() {
+  is_complete_ = false;
+  is_suspended_ = false;
+  stack_.clear();
+  result_.Clear();
+  suspended_handles_.clear();
+  numbers_.clear();
+  token_scanned_length_ = 0;
+}
+
+template class BasicValueParser<MdsfDialect>;
+template class BasicValueParser<JsonDialect>;
+
+template bool GetType<MdsfDialect>(const char*, const char*, Type*);
+template bool GetType<JsonDialect>(const char*, const char*, Type*);
+
 namespace internal {
 
 // Returns true if `str` points to a multiline comment ending, false otherwise.
@@ -229,14 +756,33 @@ size_t SkipToCommentEnd(const char* str, const char* end) {
   }
 }
 
+// Returns true if `c` is one of the white space characters allowed in JSON.
+static inline bool IsJsonWhiteSpace(char c) {
+  return GetCharClasses(c) & kJsonWhiteSpace;
+}
+
+template <typename Dialect>
 size_t SkipToNextToken(const char* str, const char* end) {
   size_t pos = 0;
   size_t current_size;
   const size_t size = end - str;
 
+  if (!Dialect::kAllowComments && !Dialect::kAllowUnicodeWhiteSpace) {
+    if (pos < size && IsJsonWhiteSpace(str[pos])) {
+      pos += simd::SkipJsonWhiteSpace(str + pos, end);
+    }
+    return pos;
+  }
+
   while (pos < size) {
-    if (IsWhiteSpaceCharacter(str + pos, &current_size) ||
-        IsLineTerminatorSequence(str + pos, &current_size)) {
+    const uint16_t classes = GetCharClasses(str[pos]);
+    if (classes & kJsonWhiteSpace) {
+      pos += simd::SkipJsonWhiteSpace(str + pos, end);
+    } else if (classes & kWhiteSpace) {
+      pos++;
+    } else if ((classes & kUnicodeSpaceLead) &&
+               (IsWhiteSpaceCharacter(str + pos, &current_size) ||
+                IsLineTerminatorSequence(str + pos, &current_size))) {
       pos += current_size;
     } else if (str[pos] == '/') {
       size_t to_skip = SkipToCommentEnd(str + pos, end);
@@ -252,6 +798,113 @@ size_t SkipToNextToken(const char* str, const char* end) {
   return pos;
 }
 
+template <typename Dialect>
+size_t SkipToNextTokenInChunk(const char* str,
+                              const char* end,
+                              bool        is_last,
+                              bool*       is_incomplete) {
+  *is_incomplete = false;
+  if (is_last) {
+    return SkipToNextToken<Dialect>(str, end);
+  }
+
+  size_t pos = 0;
+  size_t current_size;
+  const size_t size = end - str;
+
+  if (!Dialect::kAllowComments && !Dialect::kAllowUnicodeWhiteSpace) {
+    if (pos < size && IsJsonWhiteSpace(str[pos])) {
+      pos += simd::SkipJsonWhiteSpace(str + pos, end);
+    }
+    return pos;
+  }
+
+  while (pos < size) {
+    if (static_cast<unsigned char>(str[pos]) >= 0x80 && size - pos < 3) {
+      // Might be the beginning of a multibyte white space character.
+      *is_incomplete = true;
+      break;
+    }
+    if (GetCharClasses(str[pos]) & kWhiteSpace) {
+      pos++;
+    } else if (IsWhiteSpaceCharacter(str + pos, &current_size) ||
+               IsLineTerminatorSequence(str + pos, &current_size)) {
+      if (pos + current_size == size && str[pos] == '\x0D') {
+        // Might be the first half of CRLF.
+        *is_incomplete = true;
+        break;
+      }
+      pos += current_size;
+    } else if (str[pos] == '/') {
+      if (pos + 1 == size) {
+        *is_incomplete = true;
+        break;
+      }
+      size_t to_skip = SkipToCommentEnd(str + pos, end);
+      if (str[pos + 1] == '/' && pos + to_skip == size) {
+        // A single-line comment is only complete after a line terminator.
+        *is_incomplete = true;
+        break;
+      } else if (str[pos + 1] == '*' && !to_skip) {
+        *is_incomplete = true;
+        break;
+      } else if (!to_skip) {
+        break;
+      }
+      pos += to_skip;
+    } else {
+      break;
+    }
+  }
+
+  return pos;
+}
+
+bool IsTokenComplete(const char* begin, const char* end) {
+  size_t scanned_length = 0;
+  return IsTokenComplete(begin, end, &scanned_length);
+}
+
+bool IsTokenComplete(const char* begin,
+                     const char* end,
+                     size_t*     scanned_length) {
+  if (*begin == '\'' || *begin == '"') {
+    const char* current = begin + (*scanned_length > 1 ? *scanned_length : 1);
+    while (current < end) {
+      if (*current == '\\') {
+        if (end - current < 2) {
+          // The escaped character hasn't been received yet.
+          break;
+        }
+        current += 2;
+      } else if (*current == *begin) {
+        return true;
+      } else {
+        current++;
+      }
+    }
+    *scanned_length = current - begin;
+    return false;
+  }
+
+  for (const char* current = begin; current < end; current++) {
+    if (current[0] == '\\' && end - current > 2 &&
+        current[1] == 'u' && current[2] == '{') {
+      current = static_cast<const char*>(memchr(current, '}', end - current));
+      if (!current) {
+        return false;
+      }
+      continue;
+    }
+    unsigned char c = static_cast<unsigned char>(*current);
+    if (c < 0x80 && !(GetCharClasses(c) & kIdentifierPart) && c != '\\' &&
+        c != '.' && c != '+' && c != '-') {
+      return true;
+    }
+  }
+  return false;
+}
+
 MaybeLocal<Value> ParseUndefined(Isolate*    isolate,
                                  const char* begin,
                                  const char* end,
@@ -275,6 +928,17 @@ MaybeLocal<Value> ParseNull(Isolate*    isolate,
   return Null(isolate);
 }
 
+// Returns true if the data from `begin` to `end` is a proper prefix of the
+// `length` characters long `literal`, i.e. the literal is cut short by the end
+// of the data.
+static inline bool IsTruncatedLiteral(const char* begin,
+                                      const char* end,
+                                      const char* literal,
+                                      size_t      length) {
+  size_t size = end - begin;
+  return size < length && strncmp(begin, literal, size) == 0;
+}
+
 MaybeLocal<Value> ParseBool(Isolate*    isolate,
                             const char* begin,
                             const char* end,
@@ -286,30 +950,49 @@ MaybeLocal<Value> ParseBool(Isolate*    isolate,
   } else if (begin + 5 <= end && strncmp(begin, "false", 5) == 0) {
     result = False(isolate);
     *size = 5;
+  } else if (IsTruncatedLiteral(begin, end, "true", 4) ||
+             IsTruncatedLiteral(begin, end, "false", 5)) {
+    // The same error as for a truncated null.
+    THROW_EXCEPTION(SyntaxError, "Unexpected end of data");
   } else {
     THROW_EXCEPTION(TypeError, "Invalid format: expected boolean");
   }
   return result;
 }
 
-MaybeLocal<Value> ParseNumber(Isolate*    isolate,
-                              const char* begin,
-                              const char* end,
-                              size_t*     size) {
+template <typename Dialect>
+bool ParseNumberValue(const char*  begin,
+                      const char*  end,
+                      size_t*      size,
+                      double*      result,
+                      const char** error) {
   bool negate_result = false;
   const char* number_start = begin;
 
-  if (*begin == '+' || *begin == '-') {
+  if (*begin == '-' || (Dialect::kAllowExtendedNumbers && *begin == '+')) {
     negate_result = *begin == '-';
     number_start++;
   }
 
+  if (!Dialect::kAllowExtendedNumbers &&
+      (number_start == end || !IsDigit(*number_start))) {
+    *error = "Invalid number format";
+    return false;
+  }
+
   int base = 10;
 
   if (*number_start == '0') {
     number_start++;
 
-    if (*number_start == 'b' || *number_start == 'B') {
+    if (!Dialect::kAllowExtendedNumbers) {
+      if (IsDigit(*number_start)) {
+        *error =
+            "Legacy octal and non-octal integer literals are not supported";
+        return false;
+      }
+      number_start--;
+    } else if (*number_start == 'b' || *number_start == 'B') {
       base = 2;
       number_start++;
     } else if (*number_start == 'o' || *number_start == 'O') {
@@ -318,37 +1001,135 @@ MaybeLocal<Value> ParseNumber(Isolate*    isolate,
     } else if (*number_start == 'x' || *number_start == 'X') {
       base = 16;
       number_start++;
-    } else if (isdigit(*number_start)) {
-      THROW_EXCEPTION(SyntaxError,
-          "Legacy octal and non-octal integer literals are not supported");
-      return MaybeLocal<Value>();
+    } else if (IsDigit(*number_start)) {
+      *error = "Legacy octal and non-octal integer literals are not supported";
+      return false;
     } else {
       number_start--;
     }
   }
 
-  MaybeLocal<Value> result;
-
   if (base == 10) {
-    result = ParseDecimalNumber(isolate, number_start, end, size,
-                                negate_result);
+    if (!ParseDecimalNumber<Dialect>(number_start, end, size,
+                                     negate_result, result, error)) {
+      return false;
+    }
   } else {
-    result = ParseIntegerNumber(isolate, number_start, end, size,
-                                base, negate_result);
+    *result = ParseIntegerNumber(number_start, end, size,
+                                 base, negate_result);
     if (*size == 0) {
-      THROW_EXCEPTION(SyntaxError, "Empty number value");
-      return MaybeLocal<Value>();
+      *error = "Empty number value";
+      return false;
     }
   }
   *size += number_start - begin;
-  return result;
+  return true;
+}
+
+template <typename Dialect>
+bool ParseNumberValue(Isolate*    isolate,
+                      const char* begin,
+                      const char* end,
+                      size_t*     size,
+                      double*     result) {
+  const char* error;
+  if (!ParseNumberValue<Dialect>(begin, end, size, result, &error)) {
+    THROW_EXCEPTION(SyntaxError, error);
+    return false;
+  }
+  return true;
+}
+
+bool IsInt32(double number) {
+  return number >= INT32_MIN && number <= INT32_MAX &&
+         number == static_cast<int32_t>(number) &&
+         !(number == 0 && std::signbit(number));
+}
+
+Local<Value> NewNumber(Isolate* isolate, double number) {
+  // Small integers are created with Integer::New() so that V8 doesn't have
+  // to allocate heap numbers for them.
+  if (IsInt32(number)) {
+    return Integer::New(isolate, static_cast<int32_t>(number));
+  }
+  return Number::New(isolate, number);
 }
 
-MaybeLocal<Value> ParseDecimalNumber(Isolate*    isolate,
-                                     const char* begin,
-                                     const char* end,
-                                     size_t*     size,
-                                     bool        negate_result) {
+template <typename Dialect>
+MaybeLocal<Value> ParseNumber(Isolate*    isolate,
+                              const char* begin,
+                              const char* end,
+                              size_t*     size) {
+  double number;
+  if (!ParseNumberValue<Dialect>(isolate, begin, end, size, &number)) {
+    return MaybeLocal<Value>();
+  }
+  return NewNumber(isolate, number);
+}
+
+// Returns the length of the number at `begin` according to the JSON grammar
+// (without the sign), or 0 if it is malformed.
+static size_t GetJsonNumberLength(const char* begin, const char* end) {
+  const char* current = begin;
+  while (current < end && IsDigit(*current)) {
+    current++;
+  }
+  if (current < end && *current == '.') {
+    const char* fraction = ++current;
+    while (current < end && IsDigit(*current)) {
+      current++;
+    }
+    if (current == fraction) {
+      return 0;
+    }
+  }
+  if (current < end && (*current == 'e' || *current == 'E')) {
+    current++;
+    if (current < end && (*current == '+' || *current == '-')) {
+      current++;
+    }
+    const char* exponent = current;
+    while (current < end && IsDigit(*current)) {
+      current++;
+    }
+    if (current == exponent) {
+      return 0;
+    }
+  }
+  return current - begin;
+}
+
+// Integers with at most this many digits are below 2^53 and can be converted
+// to double exactly.
+static const size_t kMaxExactIntegerDigits = 15;
+
+template <typename Dialect>
+bool ParseDecimalNumber(const char*  begin,
+                        const char*  end,
+                        size_t*      size,
+                        bool         negate_result,
+                        double*      result,
+                        const char** error) {
+  // Fast path for integers that are short enough to be represented exactly
+  // in a double without calling strtod(). -0 has to be a double, so it is
+  // left for the slow path.
+  uint64_t int_value;
+  const size_t digit_count = simd::ParseDigits(begin, end, &int_value);
+  const char* digit = begin + digit_count;
+  if (digit_count != 0 && digit_count <= kMaxExactIntegerDigits &&
+      (int_value != 0 || !negate_result) &&
+      (digit == end || (*digit != '.' && *digit != 'e' && *digit != 'E' &&
+                        !IsDigit(*digit)))) {
+    MDSF_STATS_INC(fast_numbers);
+    *size = digit_count;
+    *result = static_cast<double>(int_value);
+    if (negate_result) {
+      *result = -*result;
+    }
+    return true;
+  }
+
+  MDSF_STATS_INC(slow_numbers);
   char* number_end;
   double number = strtod(begin, &number_end);
 
@@ -356,147 +1137,236 @@ MaybeLocal<Value> ParseDecimalNumber(Isolate*    isolate,
     number = -number;
   }
 
+  if (!Dialect::kAllowExtendedNumbers) {
+    // strtod() accepts more than JSON does (e.g. hexadecimal numbers), so the
+    // length of the number is determined by the JSON grammar.
+    *size = GetJsonNumberLength(begin, end);
+    if (*size == 0) {
+      *error = "Invalid number format";
+      return false;
+    }
+    *result = number;
+    return true;
+  }
+
   // strictly allow only "NaN" and "Infinity"
   if (std::isnan(number)) {
     if (strncmp(begin + 1, "aN", 2) != 0) {
-      THROW_EXCEPTION(SyntaxError, "Invalid format: expected NaN");
-      return MaybeLocal<Value>();
+      *error = "Invalid format: expected NaN";
+      return false;
     }
   } else if (std::isinf(number)) {
     if (strncmp(begin + 1, "nfinity", 7) != 0) {
-      THROW_EXCEPTION(SyntaxError, "Invalid format: expected Infinity");
-      return MaybeLocal<Value>();
+      *error = "Invalid format: expected Infinity";
+      return false;
     }
   }
 
   *size = number_end - begin;
-  return Number::New(isolate, number);
+  *result = number;
+  return true;
 }
 
-Local<Value> ParseIntegerNumber(Isolate*    isolate,
-                                const char* begin,
-                                const char* end,
-                                size_t*     size,
-                                int         base,
-                                bool        negate_result) {
+double ParseIntegerNumber(const char* begin,
+                          const char* end,
+                          size_t*     size,
+                          int         base,
+                          bool        negate_result) {
+  MDSF_STATS_INC(slow_numbers);
   char* number_end;
   long long value = strtoll(begin, &number_end, base);
   if (errno == ERANGE) {
     errno = 0;
-    return ParseBigIntegerNumber(isolate, begin, end, size,
-                                 base, negate_result);
+    return ParseBigIntegerNumber(begin, end, size, base, negate_result);
   }
   if (negate_result) {
     value = -value;
   }
   *size = static_cast<size_t>(number_end - begin);
-  if (value > INT32_MIN && value < INT32_MAX) {
-    return Integer::New(isolate, value);
-  } else {
-    return Number::New(isolate, value);
-  }
+  return static_cast<double>(value);
 }
 
-Local<Value> ParseBigIntegerNumber(Isolate*    isolate,
-                                   const char* begin,
-                                   const char* end,
-                                   size_t*     size,
-                                   int         base,
-                                   bool        negate_result) {
+double ParseBigIntegerNumber(const char* begin,
+                             const char* end,
+                             size_t*     size,
+                             int         base,
+                             bool        negate_result) {
   *size = end - begin;
   double result = 0.0;
-  char current_digit;
-  double current_digit_value;
-  char base_digit_count = base > 10 ? 10 : base;
-  char base_alpha_count = base > 10 ? base - 10 : 0;
+  int current_digit_value;
   for (size_t i = 0; i < *size; i++) {
-    current_digit = toupper(begin[i]);
-    if ((current_digit < '0' || current_digit >= '0' + base_digit_count) &&
-        (current_digit < 'A' || current_digit >= 'A' + base_alpha_count)) {
+    current_digit_value = IsHexDigit(begin[i]) ? HexDigitValue(begin[i]) : base;
+    if (current_digit_value >= base) {
       *size = i;
       break;
     }
-    current_digit_value = current_digit <= '9' ? current_digit - '0' :
-                                                 current_digit - 'A' + 10;
     result *= base;
     result += current_digit_value;
   }
-  return Number::New(isolate, negate_result ? -result : result);
+  return negate_result ? -result : result;
 }
 
-static bool GetControlChar(Isolate*    isolate,
-                           const char* str,
-                           size_t*     res_len,
-                           size_t*     size,
-                           char*       write_to);
+template <typename Dialect>
+static bool GetControlChar(const char** error,
+                           const char*  str,
+                           size_t*      res_len,
+                           size_t*      size,
+                           char*        write_to);
+
+// Returns true if `str` points to a line terminator that is not allowed
+// unescaped in strings of the dialect. JSON allows U+2028 and U+2029.
+template <typename Dialect>
+static inline bool IsLineEndInString(const char* str, size_t* size) {
+  if (Dialect::kAllowUnicodeWhiteSpace) {
+    return IsLineTerminatorSequence(str, size);
+  }
+  *size = 1;
+  return *str == '\r' || *str == '\n';
+}
 
-MaybeLocal<Value> ParseString(Isolate*    isolate,
-                              const char* begin,
-                              const char* end,
-                              size_t*     size) {
+// Returns true if there is a control character among `size` bytes at `str`.
+static inline bool HasControlChar(const char* str, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    if (static_cast<unsigned char>(str[i]) < 0x20) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns the number of bytes from `begin` to the end of the string token
+// it is inside of, or to `end` if the token is not terminated.
+static size_t GetStringTokenLength(const char* begin,
+                                   const char* end,
+                                   char        quote) {
+  const char* current = begin;
+  while (current < end && *current != quote) {
+    current += *current == '\\' ? 2 : 1;
+  }
+  return current < end ? current - begin : end - begin;
+}
+
+template <typename Dialect>
+bool DecodeString(const char*    begin,
+                  const char*    end,
+                  size_t*        size,
+                  DecodedString* result,
+                  const char**   error) {
   *size = end - begin;
-  char* result = nullptr;
+  char* scratch = nullptr;
 
-  enum { kApostrophe = 0, kQMarks} string_mode = (*begin == '\'') ?
-                                                 kApostrophe :
-                                                 kQMarks;
+  const char quote = *begin;
   bool is_ended = false;
+  bool is_ascii = true;
   size_t res_index = 0;
   size_t out_offset, in_offset;
 
   for (size_t i = 1; i < *size; i++) {
-    if ((string_mode == kQMarks     && begin[i] == '\"') ||
-        (string_mode == kApostrophe && begin[i] == '\'')) {
+    size_t plain_size = simd::SkipPlainStringChars(begin + i, end, quote);
+    if (plain_size != 0) {
+      if (!Dialect::kAllowRawControlChars &&
+          HasControlChar(begin + i, plain_size)) {
+        *error = "Unescaped control character in string";
+        return false;
+      }
+      if (scratch) {
+        memcpy(scratch + res_index, begin + i, plain_size);
+      }
+      res_index += plain_size;
+      i += plain_size;
+      if (i >= *size) {
+        break;
+      }
+    }
+
+    if (begin[i] == quote) {
       is_ended = true;
       *size = i + 1;
       break;
     }
 
     if (begin[i] == '\\') {
-      if (!result) {
-        result = new char[*size + 1];
-        memcpy(result, begin + 1, i - 1);
+      if (!scratch) {
+        // Escape sequences are never shorter than the characters they stand
+        // for, so the rest of the token is enough (the few extra bytes are
+        // for an escape sequence truncated by the end of the data).
+        scratch = new char[i + GetStringTokenLength(begin + i, end, quote) + 4];
+        result->scratch = scratch;
+        memcpy(scratch, begin + 1, i - 1);
       }
-      if (IsLineTerminatorSequence(begin + i + 1, &in_offset)) {
+      if (Dialect::kAllowExtendedEscapes &&
+          IsLineTerminatorSequence(begin + i + 1, &in_offset)) {
         i += in_offset;
       } else {
-        bool ok = GetControlChar(isolate, begin + ++i, &out_offset, &in_offset,
-                                 result + res_index);
+        bool ok = GetControlChar<Dialect>(error, begin + ++i, &out_offset,
+                                          &in_offset, scratch + res_index);
         if (!ok) {
-          delete[] result;
-          return MaybeLocal<Value>();
+          return false;
+        }
+        for (size_t j = 0; j < out_offset; j++) {
+          if (static_cast<unsigned char>(scratch[res_index + j]) >= 0x80) {
+            is_ascii = false;
+          }
         }
         i += in_offset - 1;
         res_index += out_offset;
       }
-    } else if (IsLineTerminatorSequence(begin + i, &in_offset)) {
-      delete[] result;
-      THROW_EXCEPTION(SyntaxError, "Unexpected line end in string");
-      return MaybeLocal<Value>();
+    } else if (IsLineEndInString<Dialect>(begin + i, &in_offset)) {
+      *error = "Unexpected line end in string";
+      return false;
     } else {
-      if (result) {
-        result[res_index] = begin[i];
+      is_ascii = false;
+      if (scratch) {
+        scratch[res_index] = begin[i];
       }
       res_index++;
     }
   }
 
   if (!is_ended) {
-    delete[] result;
-    THROW_EXCEPTION(SyntaxError, "Error while parsing string");
+    *error = "Error while parsing string";
+    return false;
+  }
+
+  result->data = scratch ? scratch : begin + 1;
+  result->length = res_index;
+  result->is_ascii = is_ascii;
+  return true;
+}
+
+// Creates a JavaScript string with the contents of `decoded`.
+static Local<String> NewString(Isolate*             isolate,
+                               const DecodedString& decoded,
+                               NewStringType        type) {
+  if (decoded.is_ascii) {
+    // V8 doesn't need to decode and scan ASCII strings once more to find out
+    // that they can be stored using one byte per character.
+    return String::NewFromOneByte(isolate,
+        reinterpret_cast<const uint8_t*>(decoded.data),
+        type, static_cast<int>(decoded.length)).ToLocalChecked();
+  }
+  return String::NewFromUtf8(isolate, decoded.data,
+      type, static_cast<int>(decoded.length)).ToLocalChecked();
+}
+
+template <typename Dialect>
+MaybeLocal<Value> ParseString(Isolate*    isolate,
+                              const char* begin,
+                              const char* end,
+                              size_t*     size) {
+  DecodedString decoded;
+  const char* error;
+  if (!DecodeString<Dialect>(begin, end, size, &decoded, &error)) {
+    THROW_EXCEPTION(SyntaxError, error);
     return MaybeLocal<Value>();
   }
 
-  Local<String> result_str;
-  if (result) {
-    result_str = String::NewFromUtf8(isolate, result,
-        NewStringType::kNormal, static_cast<int>(res_index)).ToLocalChecked();
-    delete[] result;
-  } else {
-    result_str = String::NewFromUtf8(isolate, begin + 1,
-        NewStringType::kNormal, static_cast<int>(*size - 2)).ToLocalChecked();
+  MDSF_STATS_INC(strings);
+  if (decoded.scratch) {
+    MDSF_STATS_INC(escaped_strings);
+    MDSF_STATS_INC(scratch_allocations);
   }
-  return result_str;
+  return NewString(isolate, decoded, NewStringType::kNormal);
 }
 
 static uint32_t ReadHexNumber(const char* str,
@@ -508,16 +1378,16 @@ static uint32_t ReadHexNumber(const char* str,
 // Parses a Unicode escape sequence after the '\u' part and returns it's
 // code point value. Supports surrogate pairs. Total size of escape
 // sequence (excluding first '\u') is written in `size`.
-static uint32_t ReadUnicodeEscapeSequence(Isolate* isolate,
+static uint32_t ReadUnicodeEscapeSequence(const char** error,
                                           const char* str,
                                           size_t* size,
                                           bool* ok) {
   uint32_t result = 0xFFFD;
 
-  if (isxdigit(str[0])) {
+  if (IsHexDigit(str[0])) {
     result = ReadHexNumber(str, 4, true, nullptr, ok);
     if (!*ok) {
-      THROW_EXCEPTION(SyntaxError, "Invalid Unicode escape sequence");
+      *error = "Invalid Unicode escape sequence";
       return 0xFFFD;
     }
     *size = 4;
@@ -525,12 +1395,13 @@ static uint32_t ReadUnicodeEscapeSequence(Isolate* isolate,
     size_t hex_size;
     result = ReadHexNumber(str + 1, 0, false, &hex_size, ok);
     if (!*ok || result > 0x10FFFF) {
-      THROW_EXCEPTION(SyntaxError, "Invalid Unicode escape sequence");
+      *error = "Invalid Unicode escape sequence";
+      *ok = false;
       return 0xFFFD;
     }
     *size = hex_size + 2;
   } else {
-    THROW_EXCEPTION(SyntaxError, "Expected Unicode escape sequence");
+    *error = "Expected Unicode escape sequence";
     *ok = false;
   }
 
@@ -538,7 +1409,7 @@ static uint32_t ReadUnicodeEscapeSequence(Isolate* isolate,
   if (0xD800 <= result && result <= 0xDBFF) {
     size_t low_size;
     if (str[*size] == '\\' && str[*size + 1] == 'u') {
-      uint32_t low_sur = ReadUnicodeEscapeSequence(isolate,
+      uint32_t low_sur = ReadUnicodeEscapeSequence(error,
                                                    str + *size + 2,
                                                    &low_size, ok);
       if (!*ok || !(0xDC00 <= low_sur && low_sur <= 0xDFFF)) {
@@ -556,14 +1427,21 @@ static uint32_t ReadUnicodeEscapeSequence(Isolate* isolate,
 // character (i.e., an escape sequence without \) into an unescaped control
 // character and writes it to `write_to`.
 // Returns true if no error occured, false otherwise.
-static bool GetControlChar(Isolate*    isolate,
-                           const char* str,
-                           size_t*     res_len,
-                           size_t*     size,
-                           char*       write_to) {
+template <typename Dialect>
+static bool GetControlChar(const char** error,
+                           const char*  str,
+                           size_t*      res_len,
+                           size_t*      size,
+                           char*        write_to) {
   *size = 1;
   *res_len = 1;
   bool ok;
+  if (!Dialect::kAllowExtendedEscapes &&
+      (!memchr("\"\\/bfnrtu", str[0], 9) ||
+       (str[0] == 'u' && str[1] == '{'))) {
+    *error = "Invalid escape sequence";
+    return false;
+  }
   switch (str[0]) {
     case 'b': {
       *write_to = '\b';
@@ -591,18 +1469,19 @@ static bool GetControlChar(Isolate*    isolate,
     }
 
     case 'x': {
-      *write_to = static_cast<char>(ReadHexNumber(str + 1, 2, true,
-          nullptr, &ok));
+      uint32_t symb_code = ReadHexNumber(str + 1, 2, true, nullptr, &ok);
       if (!ok) {
-        THROW_EXCEPTION(SyntaxError, "Invalid hexadecimal escape sequence");
+        *error = "Invalid hexadecimal escape sequence";
         return false;
       }
+      // \x80-\xFF stand for U+0080-U+00FF, not for single bytes.
+      CodePointToUtf8(symb_code, res_len, write_to);
       *size = 3;
       break;
     }
 
     case 'u': {
-      uint32_t symb_code = ReadUnicodeEscapeSequence(isolate,
+      uint32_t symb_code = ReadUnicodeEscapeSequence(error,
                                                      str + 1,
                                                      size,
                                                      &ok);
@@ -616,9 +1495,8 @@ static bool GetControlChar(Isolate*    isolate,
     }
 
     case '0': {
-      if (isdigit(str[1])) {
-        THROW_EXCEPTION(SyntaxError,
-            "Decimal digits after \\0 are not allowed in strings");
+      if (IsDigit(str[1])) {
+        *error = "Decimal digits after \\0 are not allowed in strings";
         return false;
       }
       *write_to = 0;
@@ -627,8 +1505,7 @@ static bool GetControlChar(Isolate*    isolate,
 
     default: {
       if ('0' <= str[0] && str[0] <= '7') {
-        THROW_EXCEPTION(SyntaxError,
-            "Octal escape sequences are not allowed in strings");
+        *error = "Octal escape sequences are not allowed in strings";
         return false;
       }
       *write_to = str[0];
@@ -647,17 +1524,6 @@ static uint32_t ReadHexNumber(const char* str,
                               bool is_limited,
                               size_t* len,
                               bool* ok) {
-  static const int8_t xdigit_table[] = {
-    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, // '0' to '9'
-    -1, -1, -1, -1, -1, -1, -1,   // 0x3A to 0x40
-    10, 11, 12, 13, 14, 15,       // 'A' to 'F'
-    // 'G' to 'Z':
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, -1, -1, -1, -1, -1,       // 0x5B to 0x60
-    10, 11, 12, 13, 14, 15,       // 'a' to 'f'
-  };
-
   uint32_t result = 0;
   uint64_t current_value = 0;
   size_t current_length = 0;
@@ -665,11 +1531,11 @@ static uint32_t ReadHexNumber(const char* str,
 
   *ok = true;
 
-  while (isxdigit(str[current_length])) {
+  while (IsHexDigit(str[current_length])) {
     current_digit = str[current_length];
     current_length++;
     current_value *= 16;
-    current_value += xdigit_table[current_digit - '0'];
+    current_value += HexDigitValue(current_digit);
     if (current_value > UINT32_MAX) {
       *ok = false;
       return result;
@@ -694,48 +1560,69 @@ static uint32_t ReadHexNumber(const char* str,
   return result;
 }
 
-MaybeLocal<String> ParseKeyInObject(Isolate*    isolate,
-                                    const char* begin,
-                                    const char* end,
-                                    size_t*     size) {
+template <typename Dialect>
+bool DecodeKey(const char*    begin,
+               const char*    end,
+               size_t*        size,
+               DecodedString* result,
+               const char**   error) {
   *size = end - begin;
-  Local<String> result;
   if (begin[0] == '\'' || begin[0] == '"') {
     Type current_type;
-    bool valid = GetType(begin, end, &current_type);
+    bool valid = GetType<Dialect>(begin, end, &current_type);
     if (valid && current_type == Type::kString) {
-      size_t offset;
-      MaybeLocal<Value> key = ParseString(isolate, begin, end, &offset);
-      if (key.IsEmpty()) {
-        return MaybeLocal<String>();
-      }
-      result = key.ToLocalChecked().As<String>();
-      *size = offset;
-      return result;
+      return DecodeString<Dialect>(begin, end, size, result, error);
     } else {
-      THROW_EXCEPTION(SyntaxError,
-          "Invalid format in object: key is invalid string");
-      return MaybeLocal<String>();
+      *error = "Invalid format in object: key is invalid string";
+      return false;
     }
+  } else if (!Dialect::kAllowUnquotedKeys) {
+    *error = "Invalid format in object: key must be a string";
+    return false;
   } else {
     size_t current_length = 0;
+
+    // Fast path for keys consisting only of ASCII characters: consume the
+    // whole run of identifier characters at once and only fall back to
+    // decoding code points if it ends with a non-ASCII character or an
+    // escape sequence.
+    auto ascii_begin = reinterpret_cast<const unsigned char*>(begin);
+    if (GetCharClasses(begin[0]) & kIdentifierStart) {
+      current_length = 1;
+      while (current_length < *size &&
+             (GetCharClasses(begin[current_length]) & kIdentifierPart)) {
+        current_length++;
+      }
+      if (current_length < *size &&
+          ascii_begin[current_length] < 0x80 &&
+          ascii_begin[current_length] != '\\') {
+        *size = current_length;
+        result->data = begin;
+        result->length = current_length;
+        result->is_ascii = true;
+        return true;
+      }
+    }
+
     size_t cp_size;
     uint32_t cp;
     bool ok;
     char* fallback = nullptr;
     size_t fallback_length;
     bool is_escape = false;
+    bool is_ended = false;
     while (current_length < *size) {
       if (begin[current_length] == '\\' &&
           begin[current_length + 1] == 'u') {
-        cp = ReadUnicodeEscapeSequence(isolate, begin + current_length + 2,
+        cp = ReadUnicodeEscapeSequence(error, begin + current_length + 2,
                                        &cp_size, &ok);
         if (!ok) {
-          return MaybeLocal<String>();
+          return false;
         }
         cp_size += 2;
         if (!fallback) {
           fallback = new char[*size + 1];
+          result->scratch = fallback;
           memcpy(fallback, begin, current_length);
           fallback_length = current_length;
         }
@@ -759,191 +1646,111 @@ MaybeLocal<String> ParseKeyInObject(Isolate*    isolate,
         current_length += cp_size;
       } else {
         if (current_length != 0) {
-          if (!fallback) {
-            result = String::NewFromUtf8(isolate, begin,
-                                         NewStringType::kInternalized,
-                                         static_cast<int>(current_length))
-                                             .ToLocalChecked();
-          } else {
-            result = String::NewFromUtf8(isolate, fallback,
-                                         NewStringType::kInternalized,
-                                         static_cast<int>(fallback_length))
-                                             .ToLocalChecked();
-          }
+          is_ended = true;
           break;
         } else {
-          THROW_EXCEPTION(SyntaxError, "Unexpected identifier");
-          return MaybeLocal<String>();
+          *error = "Unexpected identifier";
+          return false;
         }
       }
     }
+    if (!is_ended) {
+      *error = "Unexpected end of data";
+      return false;
+    }
     *size = current_length;
-    return result;
+    result->data = fallback ? fallback : begin;
+    result->length = fallback ? fallback_length : current_length;
+    result->is_ascii = false;
+    return true;
   }
 }
 
-MaybeLocal<Value> ParseValueInObject(Isolate*    isolate,
-                                     const char* begin,
-                                     const char* end,
-                                     size_t*     size) {
-  Type current_type;
-  bool valid = GetType(begin, end, &current_type);
-  if (valid) {
-    return (kParseFunctions[current_type])(isolate, begin, end, size);
-  } else {
-    THROW_EXCEPTION(TypeError, "Invalid type in object");
-    return MaybeLocal<Value>();
+template <typename Dialect>
+MaybeLocal<String> ParseKeyInObject(Isolate*    isolate,
+                                    const char* begin,
+                                    const char* end,
+                                    size_t*     size) {
+  DecodedString decoded;
+  const char* error;
+  if (!DecodeKey<Dialect>(begin, end, size, &decoded, &error)) {
+    THROW_EXCEPTION(SyntaxError, error);
+    return MaybeLocal<String>();
   }
-}
-
-MaybeLocal<Value> ParseObject(Isolate*    isolate,
-                              const char* begin,
-                              const char* end,
-                              size_t*     size) {
-  bool key_mode = true;
-  *size = end - begin;
-  MaybeLocal<String> current_key;
-  MaybeLocal<Value> current_numeric_key;
-  MaybeLocal<Value> current_value;
-  size_t current_length = 0;
-  auto result = Object::New(isolate);
-  bool has_ended = false;
-
-  for (size_t i = 1; i < *size; i++) {
-    if (key_mode) {
-      i += SkipToNextToken(begin + i, end);
-      if (begin[i] == '}') {
-        *size = i + 1;
-        has_ended = true;
-        break;
-      }
-      if (!isdigit(begin[i])) {
-        current_key = ParseKeyInObject(isolate, begin + i, end,
-            &current_length);
-      } else {
-        current_numeric_key = ParseNumber(isolate, begin + i, end,
-            &current_length);
-        current_key = current_numeric_key.IsEmpty() ? MaybeLocal<String>() :
-            current_numeric_key.ToLocalChecked()->ToString(
-                isolate->GetCurrentContext());
-      }
-      if (current_key.IsEmpty()) {
-        return MaybeLocal<Value>();
-      }
-      i += current_length;
-      i += SkipToNextToken(begin + i, end);
-      if (begin[i] != ':') {
-        THROW_EXCEPTION(SyntaxError, "Unexpected token");
-        return MaybeLocal<Value>();
-      }
-    } else {
-      i += SkipToNextToken(begin + i, end);
-      if (begin[i] == ',') {
-        THROW_EXCEPTION(SyntaxError, "Value is missing in object");
-        return MaybeLocal<Value>();
-      }
-      current_value = ParseValueInObject(isolate,
-                                         begin + i,
-                                         end,
-                                         &current_length);
-      if (current_value.IsEmpty()) {
-        return current_value;
-      }
-      Local<Value> value = current_value.ToLocalChecked();
-      if (!value->IsUndefined()) {
-        Maybe<bool> is_ok = result->Set(isolate->GetCurrentContext(),
-                                        current_key.ToLocalChecked(),
-                                        value);
-        if (is_ok.IsNothing()) {
-          THROW_EXCEPTION(Error, "Cannot add property to object");
-          return MaybeLocal<Value>();
-        }
-      }
-      i += current_length;
-      i += SkipToNextToken(begin + i, end);
-      if (begin[i] != ',' && begin[i] != '}') {
-        THROW_EXCEPTION(SyntaxError, "Invalid format in object");
-        return MaybeLocal<Value>();
-      } else if (begin[i] == '}') {
-        *size = i + 1;
-        has_ended = true;
-        break;
-      }
+  if (decoded.scratch) {
+    MDSF_STATS_INC(scratch_allocations);
+  }
+  if (begin[0] == '\'' || begin[0] == '"') {
+    MDSF_STATS_INC(strings);
+    if (decoded.scratch) {
+      MDSF_STATS_INC(escaped_strings);
     }
-    key_mode = !key_mode;
+    return NewString(isolate, decoded, NewStringType::kNormal);
   }
+  return NewString(isolate, decoded, NewStringType::kInternalized);
+}
 
-  if (!has_ended) {
-    THROW_EXCEPTION(SyntaxError, "Missing closing brace in object");
+// Parses an array or an object, whichever starts at `begin`, with
+// BasicValueParser.
+template <typename Dialect>
+static MaybeLocal<Value> ParseContainer(Isolate*            isolate,
+                                        const char*         begin,
+                                        const char*         end,
+                                        size_t*             size,
+                                        const ParseOptions& options) {
+  BasicValueParser<Dialect> parser(options);
+  if (parser.Parse(isolate, begin, end, true, size) !=
+      BasicValueParser<Dialect>::kComplete) {
     return MaybeLocal<Value>();
   }
-
-  return result;
+  return parser.Result();
 }
 
-MaybeLocal<Value> ParseArray(Isolate*    isolate,
-                             const char* begin,
-                             const char* end,
-                             size_t*     size) {
-  auto array = Array::New(isolate);
-  size_t current_length = 0;
-  *size = end - begin;
-
-  bool is_empty = true;
-  bool has_ended = false;
-
-  size_t current_element = 0;
-  Type current_type;
-
-  for (size_t i = 1; i < *size; i++) {
-    i += SkipToNextToken(begin + i, end);
-    if (is_empty && begin[i] == ']') {  // In case of empty array
-      *size = i + 1;
-      return array;
-    }
-
-    bool valid = GetType(begin + i, end, &current_type);
-    if (valid) {
-      MaybeLocal<Value> t = kParseFunctions[current_type](isolate,
-                                                          begin + i,
-                                                          end,
-                                                          &current_length);
-      if (t.IsEmpty()) {
-        return t;
-      }
-      if (!(current_type == Type::kUndefined && begin[i] == ']')) {
-        array->Set(static_cast<uint32_t>(current_element++),
-                   t.ToLocalChecked());
-        is_empty = false;
-      }
-
-      i += current_length;
-      i += SkipToNextToken(begin + i, end);
-
-      current_length = 0;
-
-      if (begin[i] != ',' && begin[i] != ']') {
-        THROW_EXCEPTION(SyntaxError, "Invalid format in array: missed comma");
-        return MaybeLocal<Value>();
-      } else if (begin[i] == ']') {
-        *size = i + 1;
-        has_ended = true;
-        break;
-      }
-    } else {
-      THROW_EXCEPTION(TypeError, "Invalid type in array");
-      return MaybeLocal<Value>();
-    }
-  }
-
-  if (!has_ended) {
-    THROW_EXCEPTION(SyntaxError, "Missing closing bracket in array");
-    return MaybeLocal<Value>();
-  }
+template <typename Dialect>
+MaybeLocal<Value> ParseObject(Isolate*            isolate,
+                              const char*         begin,
+                              const char*         end,
+                              size_t*             size,
+                              const ParseOptions& options) {
+  return ParseContainer<Dialect>(isolate, begin, end, size, options);
+}
 
-  return array;
+template <typename Dialect>
+MaybeLocal<Value> ParseArray(Isolate*            isolate,
+                             const char*         begin,
+                             const char*         end,
+                             size_t*             size,
+                             const ParseOptions& options) {
+  return ParseContainer<Dialect>(isolate, begin, end, size, options);
 }
 
+// Instantiations of the dialect-specific functions used outside of this file.
+#define MDSF_INSTANTIATE_DIALECT(Dialect)                                      \
+  template size_t SkipToNextToken<Dialect>(const char*, const char*);          \
+  template size_t SkipToNextTokenInChunk<Dialect>(const char*, const char*,    \
+                                                  bool, bool*);                \
+  template MaybeLocal<Value> ParseArray<Dialect>(                              \
+      Isolate*, const char*, const char*, size_t*, const ParseOptions&);       \
+  template MaybeLocal<Value> ParseObject<Dialect>(                             \
+      Isolate*, const char*, const char*, size_t*, const ParseOptions&);       \
+  template MaybeLocal<String> ParseKeyInObject<Dialect>(                       \
+      Isolate*, const char*, const char*, size_t*);                            \
+  template MaybeLocal<Value> ParseString<Dialect>(                             \
+      Isolate*, const char*, const char*, size_t*);                            \
+  template MaybeLocal<Value> ParseNumber<Dialect>(                             \
+      Isolate*, const char*, const char*, size_t*);                            \
+  template bool ParseNumberValue<Dialect>(                                     \
+      const char*, const char*, size_t*, double*, const char**);               \
+  template bool DecodeString<Dialect>(                                         \
+      const char*, const char*, size_t*, DecodedString*, const char**);        \
+  template bool DecodeKey<Dialect>(                                            \
+      const char*, const char*, size_t*, DecodedString*, const char**);
+
+MDSF_INSTANTIATE_DIALECT(MdsfDialect)
+MDSF_INSTANTIATE_DIALECT(JsonDialect)
+
+#undef MDSF_INSTANTIATE_DIALECT
+
 }  // namespace internal
 
 }  // namespace parser
@@ -7,24 +7,288 @@
 #define SRC_PARSER_H_
 
 #include <cstddef>
+#include <cstdint>
+#include <vector>
 
 #include <v8.h>
 
 namespace mdsf {
 
+namespace structural_index {
+class StructuralIndex;
+}  // namespace structural_index
+
 namespace parser {
 
+// Default limit of nesting of arrays and objects.
+const std::size_t kDefaultMaxDepth = 1000;
+
+// Maximum number of keys remembered by a parser with the key dictionary
+// enabled, the keys seen after it is full are not added to it.
+const std::size_t kMaxKeyDictionarySize = 65536;
+
+// Maximum length of string values (in bytes, as written in the data) that
+// are deduplicated when ParseOptions::deduplicate_strings is set.
+const std::size_t kMaxDeduplicatedStringLength = 32;
+
+// Policies describing the grammar dialects the parser can be specialized
+// for. Each flag enables an extension of the JSON grammar, the code handling
+// the disabled ones is compiled out of the parser instantiation entirely.
+struct MdsfDialect {
+  // Single-line and multi-line comments.
+  static constexpr bool kAllowComments = true;
+  // Unicode white space and line terminators besides space, tab, CR and LF.
+  static constexpr bool kAllowUnicodeWhiteSpace = true;
+  // Strings in single quotes.
+  static constexpr bool kAllowSingleQuotes = true;
+  // \v, \0, \x and \u{...} escape sequences, escaped line terminators and
+  // escaped characters that don't need escaping.
+  static constexpr bool kAllowExtendedEscapes = true;
+  // Control characters other than line terminators written in strings as
+  // is.
+  static constexpr bool kAllowRawControlChars = true;
+  // Hexadecimal, octal and binary integers, NaN, Infinity, explicit plus sign
+  // and numbers starting with a decimal point.
+  static constexpr bool kAllowExtendedNumbers = true;
+  // undefined values and elided array elements.
+  static constexpr bool kAllowUndefined = true;
+  // Trailing commas in arrays and objects.
+  static constexpr bool kAllowTrailingCommas = true;
+  // Identifiers and numbers as object keys.
+  static constexpr bool kAllowUnquotedKeys = true;
+};
+
+// Strict JSON as defined by RFC 8259.
+struct JsonDialect {
+  static constexpr bool kAllowComments = false;
+  static constexpr bool kAllowUnicodeWhiteSpace = false;
+  static constexpr bool kAllowSingleQuotes = false;
+  static constexpr bool kAllowExtendedEscapes = false;
+  static constexpr bool kAllowRawControlChars = false;
+  static constexpr bool kAllowExtendedNumbers = false;
+  static constexpr bool kAllowUndefined = false;
+  static constexpr bool kAllowTrailingCommas = false;
+  static constexpr bool kAllowUnquotedKeys = false;
+};
+
+// Runtime selector of the dialect policy.
+enum class Dialect { kMdsf = 0, kJson };
+
+struct ParseOptions {
+  ParseOptions() : max_depth(kDefaultMaxDepth),
+                   dialect(Dialect::kMdsf),
+                   typed_arrays(false),
+                   deduplicate_strings(false),
+                   key_dictionary(false) {}
+
+  // Maximum nesting depth of arrays and objects.
+  std::size_t max_depth;
+  Dialect dialect;
+  // Return non-empty arrays containing only numbers as Int32Array if all of
+  // them fit into int32, or as Float64Array otherwise.
+  bool typed_arrays;
+  // Return the same string for string values up to
+  // kMaxDeduplicatedStringLength bytes long which are spelled the same way
+  // within the data parsed by a single call.
+  bool deduplicate_strings;
+  // Remember every object key spelled out in full, so that it can be
+  // referred to as `#<index>` (in the order the keys have been seen) in the
+  // rest of the parsed data. The dictionary survives Reset(), so it is
+  // shared by all the values parsed by the same parser.
+  bool key_dictionary;
+};
+
+// Enumeration of supported JavaScript types used for deserialization
+// function selection.
+enum Type {
+  kUndefined = 0, kNull, kBool, kNumber, kString, kArray, kObject, kDate
+};
+
+// Parses the type of the serialized JavaScript value at the position `begin`
+// and before `end`. Returns true if it was able to detect the type, false
+// otherwise.
+template <typename Dialect>
+bool GetType(const char* begin, const char* end, Type* type);
+
 // Deserializes a UTF-8 encoded string into a JavaScript value
 // and returns a handle to it.
 v8::Local<v8::Value> Parse(v8::Isolate* isolate,
                            const char* str,
-                           std::size_t length);
+                           std::size_t length,
+                           const ParseOptions& options = ParseOptions());
+
+// Iterative parser of a single value. Arrays and objects which are being
+// parsed are kept on an explicit heap-allocated stack instead of the native
+// one, so the nesting depth is limited only by `max_depth`. The input may be
+// fed in chunks: when the end of a chunk is reached in the middle of a value,
+// the parsing is suspended and then resumed from the same point once the next
+// chunk arrives, so the data received earlier is never parsed twice.
+// The grammar is selected by the `Dialect` policy.
+template <typename Dialect>
+class BasicValueParser {
+ public:
+  enum Status { kError = 0, kIncomplete, kComplete };
+
+  // The dialect of `options` is ignored, it is selected by the template
+  // parameter.
+  explicit BasicValueParser(const ParseOptions& options = ParseOptions());
+
+  // Parses a value (or continues parsing it) from `begin` but never past
+  // `end`. `is_last` must be true if no more data is going to follow. The
+  // `size` receives the number of bytes consumed. When kIncomplete is
+  // returned, the bytes that have not been consumed (an incomplete token)
+  // must be passed again at the beginning of the next chunk. When an error
+  // occurs, a JavaScript exception is thrown, kError is returned and the
+  // parser is reset.
+  Status Parse(v8::Isolate* isolate,
+               const char*  begin,
+               const char*  end,
+               bool         is_last,
+               std::size_t* size);
+
+  // Returns the parsed value after kComplete has been returned.
+  v8::Local<v8::Value> Result() const { return result_; }
+
+  // Makes Parse() skip white space and comments using `index` instead of
+  // scanning them. The index must cover all of the data passed to Parse(),
+  // which must be passed at once, and outlive the parsing.
+  void SetStructuralIndex(const structural_index::StructuralIndex* index) {
+    structural_index_ = index;
+  }
+
+  // Moves the partially parsed values into persistent handles so that they
+  // outlive the current HandleScope. Must be called before returning to
+  // JavaScript if the parsing is going to be resumed later.
+  void Suspend(v8::Isolate* isolate);
+
+  // Restores the values moved by Suspend() in the current HandleScope. It is
+  // called by Parse() automatically and does nothing if the parser is not
+  // suspended.
+  void Resume(v8::Isolate* isolate);
+
+  // Discards the parsed data so that a new value can be parsed.
+  void Reset();
+
+ private:
+  enum State {
+    kArrayElement = 0,  // after '[' or ','
+    kArrayDelimiter,    // after an element of array
+    kObjectKey,         // after '{' or ','
+    kObjectColon,       // after a key in object
+    kObjectValue,       // after ':'
+    kObjectDelimiter    // after a value in object
+  };
+
+  struct Frame {
+    State                 state;
+    std::uint32_t         index;
+    v8::Local<v8::Object> container;
+    v8::Local<v8::String> key;
+    // True for an array which has contained only numbers so far when typed
+    // arrays are enabled. Its elements are kept in `numbers_` and the
+    // container is only created once the array is finished or turns out
+    // to contain something else.
+    bool                  is_numeric;
+    bool                  is_int32;
+  };
+
+  // Adds a parsed value to the innermost array or object, or makes it the
+  // result if there is none.
+  bool AddValue(v8::Isolate* isolate, v8::Local<v8::Value> value);
+
+  // Moves the numbers of a numeric array into a JavaScript array, so that
+  // values of other types can be added to it.
+  bool MaterializeNumbers(v8::Isolate* isolate, Frame* frame);
+
+  // Returns the container of an array frame which has been closed.
+  v8::Local<v8::Object> FinishArray(v8::Isolate* isolate, Frame* frame);
+
+  // Returns true if the token at `current` is complete before `end`. A
+  // string token which has been found incomplete in the previous chunk
+  // starts at `begin` and is only scanned from where that check has
+  // stopped, so that a long string received in many chunks is scanned once.
+  bool IsTokenCompleteInChunk(const char* begin,
+                              const char* current,
+                              const char* end);
+
+  // Parses a string value like ParseString() does, but returns the string
+  // created earlier in the same call to Parse() if the same short token has
+  // already been seen.
+  v8::MaybeLocal<v8::Value> ParseDeduplicatedString(v8::Isolate* isolate,
+                                                    const char* begin,
+                                                    const char* end,
+                                                    std::size_t* size);
+
+  // Open addressing hash table of the string tokens seen in the current call
+  // to Parse(). Entries of earlier calls are told apart by the generation,
+  // so the table doesn't have to be cleared between calls.
+  struct StringTableEntry {
+    std::uint32_t generation;
+    std::uint32_t hash;
+    const char* token;
+    std::size_t length;
+    v8::Local<v8::String> value;
+  };
+  static const std::size_t kStringTableSize = 4096;
+
+  std::size_t max_depth_;
+  bool typed_arrays_;
+  bool deduplicate_strings_;
+  bool use_key_dictionary_;
+  bool is_complete_;
+  bool is_suspended_;
+  std::vector<Frame> stack_;
+  v8::Local<v8::Value> result_;
+  std::vector<v8::Global<v8::Value>> suspended_handles_;
+  // Elements of the numeric array. Only the innermost array may be numeric,
+  // since an array containing another array is not numeric.
+  std::vector<double> numbers_;
+  std::vector<StringTableEntry> string_table_;
+  std::uint32_t string_table_generation_;
+  std::size_t string_table_count_;
+  // Number of bytes of the incomplete string token at the end of the last
+  // chunk that have already been scanned by IsTokenComplete(). The token is
+  // passed again at the beginning of the next chunk.
+  std::size_t token_scanned_length_;
+  // Keys that can be referred to by index, see ParseOptions::key_dictionary.
+  std::vector<v8::Global<v8::String>> key_dictionary_;
+  const structural_index::StructuralIndex* structural_index_;
+};
+
+typedef BasicValueParser<MdsfDialect> ValueParser;
+typedef BasicValueParser<JsonDialect> JsonValueParser;
 
 namespace internal {
 
 // Returns count of bytes needed to skip to next token.
+template <typename Dialect = MdsfDialect>
 size_t SkipToNextToken(const char* str, const char* end);
 
+// Returns count of bytes needed to skip to next token just like
+// SkipToNextToken does, unless `is_last` is false and the data ends with an
+// incomplete comment or multibyte character. In that case `is_incomplete` is
+// set to true and the count of bytes before that comment or character is
+// returned.
+template <typename Dialect = MdsfDialect>
+size_t SkipToNextTokenInChunk(const char* str,
+                              const char* end,
+                              bool        is_last,
+                              bool*       is_incomplete);
+
+// Returns true if the token (a string, a number, an identifier or a key)
+// starting at `begin` is followed by some data before `end`, i.e. more data
+// cannot change the result of parsing it.
+bool IsTokenComplete(const char* begin, const char* end);
+
+// Same as IsTokenComplete(), but the first `*scanned_length` bytes of a
+// string token are known not to end it and are not scanned again. When
+// false is returned for a string, `*scanned_length` receives the number of
+// bytes that have been scanned, so that the check can be resumed once more
+// data arrives.
+bool IsTokenComplete(const char* begin,
+                     const char* end,
+                     std::size_t* scanned_length);
+
 // Parses an undefined value from `begin` but never past `end` and returns the
 // parsed JavaScript value. The `size` is incremented by the number of
 // characters the function has used in the string so that the calling side
@@ -56,6 +320,7 @@ v8::MaybeLocal<v8::Value> ParseBool(v8::Isolate* isolate,
 // parsed JavaScript value. The `size` is incremented by the number of
 // characters the function has used in the string so that the calling side
 // knows where to continue from.
+template <typename Dialect = MdsfDialect>
 v8::MaybeLocal<v8::Value> ParseNumber(v8::Isolate* isolate,
                                       const char*  begin,
                                       const char*  end,
@@ -65,70 +330,129 @@ v8::MaybeLocal<v8::Value> ParseNumber(v8::Isolate* isolate,
 // parsed JavaScript value. The `size` is incremented by the number of
 // characters the function has used in the string so that the calling side
 // knows where to continue from.
+template <typename Dialect = MdsfDialect>
 v8::MaybeLocal<v8::Value> ParseString(v8::Isolate* isolate,
                                       const char*  begin,
                                       const char*  end,
                                       std::size_t* size);
 
-// Parses an array from `begin` but never past `end` and returns the parsed
-// JavaScript value. The `size` is incremented by the number of characters the
-// function has used in the string so that the calling side knows where to
-// continue from.
-v8::MaybeLocal<v8::Value> ParseArray(v8::Isolate* isolate,
-                                     const char*  begin,
-                                     const char*  end,
-                                     std::size_t* size);
+// Parses an array from `begin` but never past `end` with the limits and
+// flags of `options` and returns the parsed JavaScript value. The `size` is
+// incremented by the number of characters the function has used in the
+// string so that the calling side knows where to continue from.
+template <typename Dialect = MdsfDialect>
+v8::MaybeLocal<v8::Value> ParseArray(v8::Isolate*        isolate,
+                                     const char*         begin,
+                                     const char*         end,
+                                     std::size_t*        size,
+                                     const ParseOptions& options);
 
 // Parses an object key from `begin` but never past `end` and returns
 // the parsed JavaScript value. The `size` is incremented by the number
 // of characters the function has used in the string so that the calling side
 // knows where to continue from.
+template <typename Dialect = MdsfDialect>
 v8::MaybeLocal<v8::String> ParseKeyInObject(v8::Isolate* isolate,
                                             const char*  begin,
                                             const char*  end,
                                             std::size_t* size);
 
-// Parses a value corresponding to key inside object from `begin`
-// but never past `end` and returns the parsed JavaScript value.
-// The `size` is incremented by the number of characters the function has used
-// in the string so that the calling side knows where to continue from.
-v8::MaybeLocal<v8::Value> ParseValueInObject(v8::Isolate* isolate,
-                                             const char*  begin,
-                                             const char*  end,
-                                             std::size_t* size);
+// Parses an object from `begin` but never past `end` with the limits and
+// flags of `options` and returns the parsed JavaScript value. The `size` is
+// incremented by the number of characters the function has used in the
+// string so that the calling side knows where to continue from.
+template <typename Dialect = MdsfDialect>
+v8::MaybeLocal<v8::Value> ParseObject(v8::Isolate*        isolate,
+                                      const char*         begin,
+                                      const char*         end,
+                                      std::size_t*        size,
+                                      const ParseOptions& options);
 
-// Parses an object from `begin` but never past `end` and returns the parsed
-// JavaScript value. The `size` is incremented by the number of characters the
-// function has used in the string so that the calling side knows where to
-// continue from.
-v8::MaybeLocal<v8::Value> ParseObject(v8::Isolate* isolate,
-                                      const char*  begin,
-                                      const char*  end,
-                                      std::size_t* size);
+// Parses a numeric value from `begin` but never past `end` into `result`
+// without creating any JavaScript values. Returns false and throws an
+// exception if the number is malformed.
+template <typename Dialect = MdsfDialect>
+bool ParseNumberValue(v8::Isolate* isolate,
+                      const char*  begin,
+                      const char*  end,
+                      std::size_t* size,
+                      double*      result);
+
+// Returns true if `number` can be represented as an int32_t (which -0 can't).
+bool IsInt32(double number);
+
+// Creates a JavaScript number, using a small integer if possible.
+v8::Local<v8::Value> NewNumber(v8::Isolate* isolate, double number);
+
+// Contents of a string or an object key decoded without creating a
+// JavaScript string. `data` points into the parsed data if the token has no
+// escape sequences, and into `scratch` otherwise.
+struct DecodedString {
+  DecodedString()
+      : data(nullptr), length(0), is_ascii(true), scratch(nullptr) {}
+  ~DecodedString() { delete[] scratch; }
+  DecodedString(const DecodedString&) = delete;
+  DecodedString& operator=(const DecodedString&) = delete;
+
+  const char* data;
+  std::size_t length;
+  // True if `data` is known to contain only ASCII characters.
+  bool is_ascii;
+  char* scratch;
+};
+
+// The functions below parse tokens the same way as the ones above, but
+// without creating any JavaScript values. Instead of throwing a SyntaxError
+// they return false and set `error` to its message.
+
+// Parses a numeric value like ParseNumberValue() above.
+template <typename Dialect = MdsfDialect>
+bool ParseNumberValue(const char*  begin,
+                      const char*  end,
+                      std::size_t* size,
+                      double*      result,
+                      const char** error);
+
+// Decodes a string value into `result` like ParseString() does.
+template <typename Dialect = MdsfDialect>
+bool DecodeString(const char*    begin,
+                  const char*    end,
+                  std::size_t*   size,
+                  DecodedString* result,
+                  const char**   error);
+
+// Decodes an object key, either a string or an identifier, into `result`
+// like ParseKeyInObject() does.
+template <typename Dialect = MdsfDialect>
+bool DecodeKey(const char*    begin,
+               const char*    end,
+               std::size_t*   size,
+               DecodedString* result,
+               const char**   error);
 
 // Parses a decimal number, either integer or float.
-v8::MaybeLocal<v8::Value> ParseDecimalNumber(v8::Isolate* isolate,
-                                             const char*  begin,
-                                             const char*  end,
-                                             std::size_t* size,
-                                             bool         negate_result);
+template <typename Dialect = MdsfDialect>
+bool ParseDecimalNumber(const char*  begin,
+                        const char*  end,
+                        std::size_t* size,
+                        bool         negate_result,
+                        double*      result,
+                        const char** error);
 
 // Parses an integer number in arbitrary base without prefixes.
-v8::Local<v8::Value> ParseIntegerNumber(v8::Isolate* isolate,
-                                        const char*  begin,
-                                        const char*  end,
-                                        std::size_t* size,
-                                        int          base,
-                                        bool         negate_result);
+double ParseIntegerNumber(const char*  begin,
+                          const char*  end,
+                          std::size_t* size,
+                          int          base,
+                          bool         negate_result);
 
 // Parses an integer number, which is too big to be parsed using
 // ParseIntegerNumber, in arbitrary base without prefixes.
-v8::Local<v8::Value> ParseBigIntegerNumber(v8::Isolate* isolate,
-                                           const char*  begin,
-                                           const char*  end,
-                                           std::size_t* size,
-                                           int          base,
-                                           bool         negate_result);
+double ParseBigIntegerNumber(const char*  begin,
+                             const char*  end,
+                             std::size_t* size,
+                             int          base,
+                             bool         negate_result);
 
 }  // namespace internal
 
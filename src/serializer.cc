@@ -0,0 +1,381 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#include "serializer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <node_version.h>
+#include <v8.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "common.h"
+#include "number_format.h"
+
+using std::size_t;
+
+using v8::Array;
+using v8::Int32;
+using v8::Isolate;
+using v8::Local;
+using v8::NewStringType;
+using v8::Number;
+using v8::String;
+using v8::TypedArray;
+using v8::Value;
+
+using mdsf::number_format::WriteDouble;
+using mdsf::number_format::WriteInt32;
+using mdsf::number_format::WriteUint32;
+
+namespace mdsf {
+
+namespace serializer {
+
+static inline char* WriteElement(std::int8_t value, char* out) {
+  return WriteInt32(value, out);
+}
+
+static inline char* WriteElement(std::uint8_t value, char* out) {
+  return WriteUint32(value, out);
+}
+
+static inline char* WriteElement(std::int16_t value, char* out) {
+  return WriteInt32(value, out);
+}
+
+static inline char* WriteElement(std::uint16_t value, char* out) {
+  return WriteUint32(value, out);
+}
+
+static inline char* WriteElement(std::int32_t value, char* out) {
+  return WriteInt32(value, out);
+}
+
+static inline char* WriteElement(std::uint32_t value, char* out) {
+  return WriteUint32(value, out);
+}
+
+static inline char* WriteElement(float value, char* out) {
+  return WriteDouble(value, out);
+}
+
+static inline char* WriteElement(double value, char* out) {
+  return WriteDouble(value, out);
+}
+
+// Creates a string from the ASCII characters between `begin` and `end`.
+// Returns an empty handle and throws if the string is too long.
+static Local<Value> NewString(Isolate* isolate,
+                              const char* begin,
+                              const char* end) {
+  Local<String> result;
+  if (!String::NewFromOneByte(isolate,
+                              reinterpret_cast<const std::uint8_t*>(begin),
+                              NewStringType::kNormal,
+                              static_cast<int>(end - begin))
+           .ToLocal(&result)) {
+    THROW_EXCEPTION(RangeError, "Invalid string length");
+    return Local<Value>();
+  }
+  return result;
+}
+
+template <typename T>
+static Local<Value> StringifyTypedArray(Isolate* isolate,
+                                        Local<TypedArray> array,
+                                        size_t max_element_length) {
+  size_t length = array->Length();
+  void* data = array->Buffer()->GetContents().Data();
+  const T* elements = reinterpret_cast<const T*>(
+      static_cast<const char*>(data) + array->ByteOffset());
+
+  std::unique_ptr<char[]> buffer(
+      new char[length * (max_element_length + 1) + 2]);
+  char* out = buffer.get();
+  *out++ = '[';
+  for (size_t i = 0; i < length; i++) {
+    if (i != 0) {
+      *out++ = ',';
+    }
+    out = WriteElement(elements[i], out);
+  }
+  *out++ = ']';
+  return NewString(isolate, buffer.get(), out);
+}
+
+static Local<Value> StringifyArray(Isolate* isolate, Local<Array> array) {
+  const size_t kMaxElementLength = number_format::kMaxDoubleLength + 1;
+  // The length of an array doesn't tell anything about its elements, so the
+  // buffer is grown as they turn out to be numbers.
+  const uint32_t kInitialCapacity = 1024;
+
+  auto context = isolate->GetCurrentContext();
+  uint32_t length = array->Length();
+
+  std::vector<char> buffer(
+      (length < kInitialCapacity ? length : kInitialCapacity) *
+          kMaxElementLength + 2);
+  size_t size = 0;
+  buffer[size++] = '[';
+  for (uint32_t i = 0; i < length; i++) {
+    Local<Value> element;
+    if (!array->Get(context, i).ToLocal(&element)) {
+      return Local<Value>();
+    }
+    if (buffer.size() - size < kMaxElementLength + 1) {
+      buffer.resize(buffer.size() * 2);
+    }
+    char* out = buffer.data() + size;
+    if (i != 0) {
+      *out++ = ',';
+    }
+    if (element->IsInt32()) {
+      out = WriteInt32(element.As<Int32>()->Value(), out);
+    } else if (element->IsNumber()) {
+      out = WriteDouble(element.As<Number>()->Value(), out);
+    } else {
+      return v8::Undefined(isolate);
+    }
+    size = out - buffer.data();
+  }
+  buffer[size++] = ']';
+  return NewString(isolate, buffer.data(), buffer.data() + size);
+}
+
+// Since V8 7.2 JSON.stringify() escapes lone surrogates instead of emitting
+// them as is.
+#if NODE_MODULE_VERSION >= 72
+static const bool kEscapeLoneSurrogates = true;
+#else
+static const bool kEscapeLoneSurrogates = false;
+#endif
+
+static inline bool IsSurrogate(uint16_t c) {
+  return (c & 0xF800) == 0xD800;
+}
+
+// Returns the number of characters from the beginning of `str` that can be
+// written to a string literal as is, i.e. everything except control
+// characters, quotes, backslashes and (for two-byte strings) surrogates.
+static inline size_t SkipPlainChars(const uint8_t* str, size_t length) {
+  size_t i = 0;
+#ifdef __SSE2__
+  const __m128i controls = _mm_set1_epi8(0x1F);
+  const __m128i double_quotes = _mm_set1_epi8('"');
+  const __m128i single_quotes = _mm_set1_epi8('\'');
+  const __m128i backslashes = _mm_set1_epi8('\\');
+  for (; length - i >= 16; i += 16) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+    // Unsigned c <= 0x1F is the same as max(c, 0x1F) == 0x1F.
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(_mm_max_epu8(chunk, controls), controls),
+                     _mm_cmpeq_epi8(chunk, double_quotes)),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, single_quotes),
+                     _mm_cmpeq_epi8(chunk, backslashes)));
+    int mask = _mm_movemask_epi8(special);
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+#endif
+  for (; i < length; i++) {
+    uint8_t c = str[i];
+    if (c < 0x20 || c == '"' || c == '\'' || c == '\\') {
+      break;
+    }
+  }
+  return i;
+}
+
+static inline size_t SkipPlainChars(const uint16_t* str, size_t length) {
+  size_t i = 0;
+#ifdef __SSE2__
+  const __m128i controls = _mm_set1_epi16(0x1F);
+  const __m128i double_quotes = _mm_set1_epi16('"');
+  const __m128i single_quotes = _mm_set1_epi16('\'');
+  const __m128i backslashes = _mm_set1_epi16('\\');
+  const __m128i surrogate_mask = _mm_set1_epi16(static_cast<short>(0xF800));
+  const __m128i surrogates = _mm_set1_epi16(static_cast<short>(0xD800));
+  const __m128i zero = _mm_setzero_si128();
+  for (; length - i >= 8; i += 8) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+    // Unsigned c <= 0x1F is the same as saturated c - 0x1F == 0.
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi16(_mm_subs_epu16(chunk, controls), zero),
+                     _mm_cmpeq_epi16(chunk, double_quotes)),
+        _mm_or_si128(_mm_cmpeq_epi16(chunk, single_quotes),
+                     _mm_cmpeq_epi16(chunk, backslashes)));
+    if (kEscapeLoneSurrogates) {
+      special = _mm_or_si128(
+          special,
+          _mm_cmpeq_epi16(_mm_and_si128(chunk, surrogate_mask), surrogates));
+    }
+    int mask = _mm_movemask_epi8(special);
+    if (mask != 0) {
+      return i + __builtin_ctz(mask) / 2;
+    }
+  }
+#endif
+  for (; i < length; i++) {
+    uint16_t c = str[i];
+    if (c < 0x20 || c == '"' || c == '\'' || c == '\\' ||
+        (kEscapeLoneSurrogates && IsSurrogate(c))) {
+      break;
+    }
+  }
+  return i;
+}
+
+// Writes the escape sequence JSON.stringify() uses for `c`, or \' for the
+// single quote.
+template <typename Char>
+static inline Char* WriteEscapeSequence(uint16_t c, Char* out) {
+  static const char kHexDigits[] = "0123456789abcdef";
+  *out++ = '\\';
+  switch (c) {
+    case '\b': *out++ = 'b'; return out;
+    case '\f': *out++ = 'f'; return out;
+    case '\n': *out++ = 'n'; return out;
+    case '\r': *out++ = 'r'; return out;
+    case '\t': *out++ = 't'; return out;
+    case '"':
+    case '\'':
+    case '\\':
+      *out++ = static_cast<Char>(c);
+      return out;
+  }
+  *out++ = 'u';
+  *out++ = kHexDigits[c >> 12];
+  *out++ = kHexDigits[(c >> 8) & 0xF];
+  *out++ = kHexDigits[(c >> 4) & 0xF];
+  *out++ = kHexDigits[c & 0xF];
+  return out;
+}
+
+// Escapes `length` characters of `str` and appends them to `out` surrounded
+// by single quotes.
+template <typename Char>
+static void EscapeString(const Char* str, size_t length,
+                         std::vector<Char>* out) {
+  // Longest escape sequence and the closing quote.
+  const size_t kMaxEscapeLength = 7;
+  // Most strings have few characters to escape, so the buffer is only grown
+  // when they are found.
+  out->resize(length + length / 8 + kMaxEscapeLength + 1);
+  Char* current = out->data();
+  *current++ = '\'';
+  size_t i = 0;
+  for (;;) {
+    size_t plain_length = SkipPlainChars(str + i, length - i);
+    std::memcpy(current, str + i, plain_length * sizeof(Char));
+    current += plain_length;
+    i += plain_length;
+    if (i == length) {
+      break;
+    }
+    size_t size = current - out->data();
+    if (out->size() - size < length - i + kMaxEscapeLength) {
+      out->resize(out->size() * 2 + kMaxEscapeLength);
+      current = out->data() + size;
+    }
+    uint16_t c = str[i++];
+    // Only properly paired surrogates are written as is.
+    if (IsSurrogate(c) && c <= 0xDBFF && i < length &&
+        (str[i] & 0xFC00) == 0xDC00) {
+      *current++ = static_cast<Char>(c);
+      *current++ = str[i++];
+      continue;
+    }
+    current = WriteEscapeSequence(c, current);
+  }
+  *current++ = '\'';
+  out->resize(current - out->data());
+}
+
+Local<Value> StringifyString(Isolate* isolate, Local<String> value) {
+  size_t length = value->Length();
+  Local<String> result;
+  bool is_created;
+
+  if (value->IsOneByte()) {
+    std::unique_ptr<uint8_t[]> str(new uint8_t[length]);
+    value->WriteOneByte(
+#if NODE_MODULE_VERSION >= 67
+        isolate,
+#endif
+        str.get(), 0, static_cast<int>(length), String::NO_NULL_TERMINATION);
+    std::vector<uint8_t> escaped;
+    EscapeString(str.get(), length, &escaped);
+    is_created = String::NewFromOneByte(isolate, escaped.data(),
+                                        NewStringType::kNormal,
+                                        static_cast<int>(escaped.size()))
+                     .ToLocal(&result);
+  } else {
+    std::unique_ptr<uint16_t[]> str(new uint16_t[length]);
+    value->Write(
+#if NODE_MODULE_VERSION >= 67
+        isolate,
+#endif
+        str.get(), 0, static_cast<int>(length), String::NO_NULL_TERMINATION);
+    std::vector<uint16_t> escaped;
+    EscapeString(str.get(), length, &escaped);
+    is_created = String::NewFromTwoByte(isolate, escaped.data(),
+                                        NewStringType::kNormal,
+                                        static_cast<int>(escaped.size()))
+                     .ToLocal(&result);
+  }
+
+  if (!is_created) {
+    THROW_EXCEPTION(RangeError, "Invalid string length");
+    return Local<Value>();
+  }
+  return result;
+}
+
+Local<Value> StringifyNumbers(Isolate* isolate, Local<Value> value) {
+  const size_t kMaxInt32Length = number_format::kMaxInt32Length;
+  const size_t kMaxDoubleLength = number_format::kMaxDoubleLength;
+
+  if (value->IsArray()) {
+    return StringifyArray(isolate, value.As<Array>());
+  }
+  if (!value->IsTypedArray()) {
+    return v8::Undefined(isolate);
+  }
+
+  auto array = value.As<TypedArray>();
+  if (value->IsInt8Array()) {
+    return StringifyTypedArray<std::int8_t>(isolate, array, kMaxInt32Length);
+  } else if (value->IsUint8Array() || value->IsUint8ClampedArray()) {
+    return StringifyTypedArray<std::uint8_t>(isolate, array, kMaxInt32Length);
+  } else if (value->IsInt16Array()) {
+    return StringifyTypedArray<std::int16_t>(isolate, array, kMaxInt32Length);
+  } else if (value->IsUint16Array()) {
+    return StringifyTypedArray<std::uint16_t>(isolate, array,
+                                              kMaxInt32Length);
+  } else if (value->IsInt32Array()) {
+    return StringifyTypedArray<std::int32_t>(isolate, array, kMaxInt32Length);
+  } else if (value->IsUint32Array()) {
+    return StringifyTypedArray<std::uint32_t>(isolate, array,
+                                              kMaxInt32Length);
+  } else if (value->IsFloat32Array()) {
+    return StringifyTypedArray<float>(isolate, array, kMaxDoubleLength);
+  } else if (value->IsFloat64Array()) {
+    return StringifyTypedArray<double>(isolate, array, kMaxDoubleLength);
+  }
+  return v8::Undefined(isolate);
+}
+
+}  // namespace serializer
+
+}  // namespace mdsf
@@ -0,0 +1,30 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef SRC_SERIALIZER_H_
+#define SRC_SERIALIZER_H_
+
+#include <v8.h>
+
+namespace mdsf {
+
+namespace serializer {
+
+// Serializes a TypedArray (except BigInt ones) or an Array which contains
+// only numbers into an MDSF array literal without whitespace, producing the
+// same output as stringify(). Returns undefined if `value` is anything else,
+// or an empty handle if an exception has been thrown.
+v8::Local<v8::Value> StringifyNumbers(v8::Isolate* isolate,
+                                      v8::Local<v8::Value> value);
+
+// Serializes a string into a single-quoted MDSF string literal, producing the
+// same output as stringify(). Returns an empty handle if an exception has
+// been thrown.
+v8::Local<v8::Value> StringifyString(v8::Isolate* isolate,
+                                     v8::Local<v8::String> value);
+
+}  // namespace serializer
+
+}  // namespace mdsf
+
+#endif  // SRC_SERIALIZER_H_
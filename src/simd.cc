@@ -0,0 +1,519 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#include "simd.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+// The addon is compiled without target ISA flags, so the kernels of every
+// level are compiled for their instruction sets with the target attribute
+// and are only called if the CPU supports them. This needs the intrinsics
+// to be declared regardless of the flags, which GCC does since 4.9 and clang
+// since 3.8. AVX-512BW and its detection need GCC 7 and clang 5. Apple clang
+// has its own version numbers.
+#if defined(__apple_build_version__)
+#define MDSF_TARGET_AVX2 (__clang_major__ >= 8)
+#define MDSF_TARGET_AVX512 (__clang_major__ >= 10)
+#elif defined(__clang__)
+#define MDSF_TARGET_AVX2 \
+  (__clang_major__ > 3 || (__clang_major__ == 3 && __clang_minor__ >= 8))
+#define MDSF_TARGET_AVX512 (__clang_major__ >= 5)
+#else
+#define MDSF_TARGET_AVX2 \
+  (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define MDSF_TARGET_AVX512 (__GNUC__ >= 7)
+#endif
+
+#if MDSF_TARGET_AVX2
+#define MDSF_SIMD_X86 1
+#define MDSF_SIMD_AVX2 1
+#if MDSF_TARGET_AVX512
+#define MDSF_SIMD_AVX512 1
+#endif
+#define MDSF_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#elif defined(__SSE2__)
+// Older compilers only declare the intrinsics of the instruction sets
+// enabled by the flags, and SSE2 is the only one enabled by default.
+#define MDSF_SIMD_X86 1
+#define MDSF_TARGET(isa)
+#include <emmintrin.h>
+#endif
+
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+// MSVC has no target attribute, the intrinsics are available anyway. Only
+// the SSE2 kernels are used since it compiles the rest of the code without
+// VEX encoding, and mixing the two is slow on some CPUs.
+#define MDSF_SIMD_X86 1
+#define MDSF_TARGET(isa)
+#include <intrin.h>
+#endif
+
+#include "char_class.h"
+
+using std::size_t;
+using std::uint32_t;
+using std::uint64_t;
+
+using mdsf::char_class::GetCharClasses;
+using mdsf::char_class::IsDigit;
+using mdsf::char_class::kJsonWhiteSpace;
+
+namespace mdsf {
+
+namespace simd {
+
+static size_t SkipJsonWhiteSpaceScalar(const char* begin, const char* end) {
+  const char* current = begin;
+  while (current < end && (GetCharClasses(*current) & kJsonWhiteSpace)) {
+    current++;
+  }
+  return current - begin;
+}
+
+static size_t SkipPlainStringCharsScalar(const char* begin,
+                                         const char* end,
+                                         char        quote) {
+  const char* current = begin;
+  while (current < end) {
+    unsigned char c = static_cast<unsigned char>(*current);
+    if (c >= 0x80 || c == quote || c == '\\' || c == '\r' || c == '\n') {
+      break;
+    }
+    current++;
+  }
+  return current - begin;
+}
+
+static size_t SkipAsciiScalar(const char* begin, const char* end) {
+  const char* current = begin;
+  while (current < end && static_cast<unsigned char>(*current) < 0x80) {
+    current++;
+  }
+  return current - begin;
+}
+
+static size_t ParseDigitsScalar(const char* begin,
+                                const char* end,
+                                uint64_t*   value) {
+  const char* current = begin;
+  uint64_t result = 0;
+  while (current < end && static_cast<size_t>(current - begin) <
+                              kMaxParsedDigits && IsDigit(*current)) {
+    result = result * 10 + (*current - '0');
+    current++;
+  }
+  *value = result;
+  return current - begin;
+}
+
+#ifdef MDSF_SIMD_X86
+
+// Returns the number of the trailing zero bits of `mask`, which must not be
+// 0.
+static inline unsigned CountTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<unsigned>(index);
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+// Returns true if all of the 8 bytes of `chunk` are decimal digits.
+static inline bool IsEightDigits(uint64_t chunk) {
+  return ((chunk & 0xF0F0F0F0F0F0F0F0) |
+          (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+         0x3333333333333333;
+}
+
+// Returns the value of 8 decimal digits loaded into `chunk` in the little
+// endian byte order, combining pairs of digits with every multiplication.
+static inline uint32_t ParseEightDigits(uint64_t chunk) {
+  const uint64_t kMask = 0x000000FF000000FF;
+  const uint64_t kMultiplier1 = 100 + (1000000ULL << 32);
+  const uint64_t kMultiplier2 = 1 + (10000ULL << 32);
+  chunk -= 0x3030303030303030;
+  chunk = (chunk * 10) + (chunk >> 8);
+  chunk = (((chunk & kMask) * kMultiplier1) +
+           (((chunk >> 16) & kMask) * kMultiplier2)) >> 32;
+  return static_cast<uint32_t>(chunk);
+}
+
+// SSE2 has no instructions that would speed up the conversion of digits, so
+// they are parsed 8 at a time in a general purpose register.
+static size_t ParseDigitsSwar(const char* begin,
+                              const char* end,
+                              uint64_t*   value) {
+  const char* current = begin;
+  uint64_t result = 0;
+  while (end - current >= 8 &&
+         static_cast<size_t>(current - begin) + 8 <= kMaxParsedDigits) {
+    uint64_t chunk;
+    std::memcpy(&chunk, current, sizeof(chunk));
+    if (!IsEightDigits(chunk)) {
+      break;
+    }
+    result = result * 100000000 + ParseEightDigits(chunk);
+    current += 8;
+  }
+  while (current < end && static_cast<size_t>(current - begin) <
+                              kMaxParsedDigits && IsDigit(*current)) {
+    result = result * 10 + (*current - '0');
+    current++;
+  }
+  *value = result;
+  return current - begin;
+}
+
+MDSF_TARGET("sse2")
+static size_t SkipJsonWhiteSpaceSse2(const char* begin, const char* end) {
+  const char* current = begin;
+  const __m128i spaces = _mm_set1_epi8(' ');
+  const __m128i tabs = _mm_set1_epi8('\t');
+  const __m128i line_feeds = _mm_set1_epi8('\n');
+  const __m128i carriage_returns = _mm_set1_epi8('\r');
+  while (end - current >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+    __m128i white_space = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, spaces),
+                     _mm_cmpeq_epi8(chunk, tabs)),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, line_feeds),
+                     _mm_cmpeq_epi8(chunk, carriage_returns)));
+    int mask = ~_mm_movemask_epi8(white_space) & 0xFFFF;
+    if (mask != 0) {
+      return current - begin + CountTrailingZeros(mask);
+    }
+    current += 16;
+  }
+  return current - begin + SkipJsonWhiteSpaceScalar(current, end);
+}
+
+MDSF_TARGET("sse2")
+static size_t SkipPlainStringCharsSse2(const char* begin,
+                                       const char* end,
+                                       char        quote) {
+  const char* current = begin;
+  const __m128i quotes = _mm_set1_epi8(quote);
+  const __m128i backslashes = _mm_set1_epi8('\\');
+  const __m128i carriage_returns = _mm_set1_epi8('\r');
+  const __m128i line_feeds = _mm_set1_epi8('\n');
+  while (end - current >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quotes),
+                     _mm_cmpeq_epi8(chunk, backslashes)),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, carriage_returns),
+                     _mm_cmpeq_epi8(chunk, line_feeds)));
+    // Bytes with the high bit set (non-ASCII) are included by movemask.
+    int mask = _mm_movemask_epi8(_mm_or_si128(special, chunk));
+    if (mask != 0) {
+      return current - begin + CountTrailingZeros(mask);
+    }
+    current += 16;
+  }
+  return current - begin + SkipPlainStringCharsScalar(current, end, quote);
+}
+
+MDSF_TARGET("sse2")
+static size_t SkipAsciiSse2(const char* begin, const char* end) {
+  const char* current = begin;
+  while (end - current >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+    int mask = _mm_movemask_epi8(chunk);
+    if (mask != 0) {
+      return current - begin + CountTrailingZeros(mask);
+    }
+    current += 16;
+  }
+  return current - begin + SkipAsciiScalar(current, end);
+}
+
+#ifdef MDSF_SIMD_AVX2
+
+MDSF_TARGET("avx2")
+static size_t SkipJsonWhiteSpaceAvx2(const char* begin, const char* end) {
+  const char* current = begin;
+  const __m256i spaces = _mm256_set1_epi8(' ');
+  const __m256i tabs = _mm256_set1_epi8('\t');
+  const __m256i line_feeds = _mm256_set1_epi8('\n');
+  const __m256i carriage_returns = _mm256_set1_epi8('\r');
+  while (end - current >= 32) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current));
+    __m256i white_space = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, spaces),
+                        _mm256_cmpeq_epi8(chunk, tabs)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, line_feeds),
+                        _mm256_cmpeq_epi8(chunk, carriage_returns)));
+    uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(white_space));
+    if (mask != 0) {
+      return current - begin + __builtin_ctz(mask);
+    }
+    current += 32;
+  }
+  return current - begin + SkipJsonWhiteSpaceSse2(current, end);
+}
+
+MDSF_TARGET("avx2")
+static size_t SkipPlainStringCharsAvx2(const char* begin,
+                                       const char* end,
+                                       char        quote) {
+  const char* current = begin;
+  const __m256i quotes = _mm256_set1_epi8(quote);
+  const __m256i backslashes = _mm256_set1_epi8('\\');
+  const __m256i carriage_returns = _mm256_set1_epi8('\r');
+  const __m256i line_feeds = _mm256_set1_epi8('\n');
+  while (end - current >= 32) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current));
+    __m256i special = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quotes),
+                        _mm256_cmpeq_epi8(chunk, backslashes)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, carriage_returns),
+                        _mm256_cmpeq_epi8(chunk, line_feeds)));
+    uint32_t mask = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_or_si256(special, chunk)));
+    if (mask != 0) {
+      return current - begin + __builtin_ctz(mask);
+    }
+    current += 32;
+  }
+  return current - begin + SkipPlainStringCharsSse2(current, end, quote);
+}
+
+MDSF_TARGET("avx2")
+static size_t SkipAsciiAvx2(const char* begin, const char* end) {
+  const char* current = begin;
+  while (end - current >= 32) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current));
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(chunk));
+    if (mask != 0) {
+      return current - begin + __builtin_ctz(mask);
+    }
+    current += 32;
+  }
+  return current - begin + SkipAsciiSse2(current, end);
+}
+
+// Parses up to 16 digits with SSSE3 instructions, which every CPU with AVX2
+// supports: the digits are moved to the end of a register and combined into
+// pairs, groups of 4 and groups of 8 by multiply-add instructions.
+MDSF_TARGET("avx2")
+static size_t ParseDigitsAvx2(const char* begin,
+                              const char* end,
+                              uint64_t*   value) {
+  if (end - begin < 16) {
+    return ParseDigitsSwar(begin, end, value);
+  }
+  const __m128i chunk = _mm_sub_epi8(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)),
+      _mm_set1_epi8('0'));
+  const __m128i is_digit =
+      _mm_cmpeq_epi8(_mm_min_epu8(chunk, _mm_set1_epi8(9)), chunk);
+  const size_t count = __builtin_ctz(
+      ~static_cast<uint32_t>(_mm_movemask_epi8(is_digit)));
+  // Indices of the bytes before the digits are negative, such bytes are
+  // zeroed by the shuffle.
+  const __m128i indices = _mm_add_epi8(
+      _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+      _mm_set1_epi8(static_cast<char>(count - 16)));
+  const __m128i digits = _mm_shuffle_epi8(chunk, indices);
+  const __m128i pairs = _mm_maddubs_epi16(
+      digits,
+      _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1));
+  const __m128i quads = _mm_madd_epi16(
+      pairs, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+  const __m128i octets = _mm_madd_epi16(
+      _mm_packs_epi32(quads, quads),
+      _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+  const uint64_t high = static_cast<uint32_t>(_mm_cvtsi128_si32(octets));
+  const uint64_t low =
+      static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(octets, 4)));
+  *value = high * 100000000 + low;
+  return count;
+}
+
+#ifdef MDSF_SIMD_AVX512
+
+MDSF_TARGET("avx512f,avx512bw")
+static size_t SkipJsonWhiteSpaceAvx512(const char* begin, const char* end) {
+  const char* current = begin;
+  const __m512i spaces = _mm512_set1_epi8(' ');
+  const __m512i tabs = _mm512_set1_epi8('\t');
+  const __m512i line_feeds = _mm512_set1_epi8('\n');
+  const __m512i carriage_returns = _mm512_set1_epi8('\r');
+  while (end - current >= 64) {
+    __m512i chunk = _mm512_loadu_si512(current);
+    uint64_t mask = ~(_mm512_cmpeq_epi8_mask(chunk, spaces) |
+                      _mm512_cmpeq_epi8_mask(chunk, tabs) |
+                      _mm512_cmpeq_epi8_mask(chunk, line_feeds) |
+                      _mm512_cmpeq_epi8_mask(chunk, carriage_returns));
+    if (mask != 0) {
+      return current - begin + __builtin_ctzll(mask);
+    }
+    current += 64;
+  }
+  return current - begin + SkipJsonWhiteSpaceAvx2(current, end);
+}
+
+MDSF_TARGET("avx512f,avx512bw")
+static size_t SkipPlainStringCharsAvx512(const char* begin,
+                                         const char* end,
+                                         char        quote) {
+  const char* current = begin;
+  const __m512i quotes = _mm512_set1_epi8(quote);
+  const __m512i backslashes = _mm512_set1_epi8('\\');
+  const __m512i carriage_returns = _mm512_set1_epi8('\r');
+  const __m512i line_feeds = _mm512_set1_epi8('\n');
+  while (end - current >= 64) {
+    __m512i chunk = _mm512_loadu_si512(current);
+    uint64_t mask = _mm512_cmpeq_epi8_mask(chunk, quotes) |
+                    _mm512_cmpeq_epi8_mask(chunk, backslashes) |
+                    _mm512_cmpeq_epi8_mask(chunk, carriage_returns) |
+                    _mm512_cmpeq_epi8_mask(chunk, line_feeds) |
+                    _mm512_movepi8_mask(chunk);
+    if (mask != 0) {
+      return current - begin + __builtin_ctzll(mask);
+    }
+    current += 64;
+  }
+  return current - begin + SkipPlainStringCharsAvx2(current, end, quote);
+}
+
+MDSF_TARGET("avx512f,avx512bw")
+static size_t SkipAsciiAvx512(const char* begin, const char* end) {
+  const char* current = begin;
+  while (end - current >= 64) {
+    uint64_t mask = _mm512_movepi8_mask(_mm512_loadu_si512(current));
+    if (mask != 0) {
+      return current - begin + __builtin_ctzll(mask);
+    }
+    current += 64;
+  }
+  return current - begin + SkipAsciiAvx2(current, end);
+}
+
+#endif  // MDSF_SIMD_AVX512
+
+#endif  // MDSF_SIMD_AVX2
+
+#endif  // MDSF_SIMD_X86
+
+// Kernels of every level, indexed with the values of Level. Numbers are
+// never longer than a 128-bit register, so ParseDigits() has no AVX-512
+// implementation.
+static const Kernels kLevelKernels[kLevelCount] = {
+  {
+    &SkipJsonWhiteSpaceScalar,
+    &SkipPlainStringCharsScalar,
+    &SkipAsciiScalar,
+    &ParseDigitsScalar
+  },
+#ifdef MDSF_SIMD_X86
+  {
+    &SkipJsonWhiteSpaceSse2,
+    &SkipPlainStringCharsSse2,
+    &SkipAsciiSse2,
+    &ParseDigitsSwar
+  },
+#endif
+#ifdef MDSF_SIMD_AVX2
+  {
+    &SkipJsonWhiteSpaceAvx2,
+    &SkipPlainStringCharsAvx2,
+    &SkipAsciiAvx2,
+    &ParseDigitsAvx2
+  },
+#endif
+#ifdef MDSF_SIMD_AVX512
+  {
+    &SkipJsonWhiteSpaceAvx512,
+    &SkipPlainStringCharsAvx512,
+    &SkipAsciiAvx512,
+    &ParseDigitsAvx2
+  },
+#endif
+};
+
+static const char* const kLevelNames[kLevelCount] = {
+  "scalar", "sse2", "avx2", "avx512"
+};
+
+Kernels kernels = kLevelKernels[kScalar];
+
+static Level selected_level = kScalar;
+static std::once_flag initialize_flag;
+
+// Only the levels the kernels are compiled for are detected.
+static Level DetectLevel() {
+#ifdef MDSF_SIMD_AVX2
+  __builtin_cpu_init();
+#ifdef MDSF_SIMD_AVX512
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+    return kAvx512;
+  }
+#endif
+  if (__builtin_cpu_supports("avx2")) {
+    return kAvx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return kSse2;
+  }
+#elif defined(MDSF_SIMD_X86) && defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  // SSE2 is reported by bit 26 of EDX.
+  if (info[3] & (1 << 26)) {
+    return kSse2;
+  }
+#elif defined(MDSF_SIMD_X86)
+  // The compiler has been told that the CPU supports SSE2.
+  return kSse2;
+#endif
+  return kScalar;
+}
+
+static void SelectKernels() {
+  Level level = GetSupportedLevel();
+  const char* name = std::getenv("MDSF_SIMD_LEVEL");
+  if (name != nullptr && *name != '\0') {
+    for (int i = 0; i < kLevelCount; i++) {
+      if (std::strcmp(name, kLevelNames[i]) == 0) {
+        level = std::min(level, static_cast<Level>(i));
+        break;
+      }
+    }
+  }
+  selected_level = level;
+  kernels = kLevelKernels[level];
+}
+
+void Initialize() {
+  std::call_once(initialize_flag, SelectKernels);
+}
+
+Level GetSupportedLevel() {
+  static const Level level = DetectLevel();
+  return level;
+}
+
+Level GetLevel() {
+  return selected_level;
+}
+
+const char* GetLevelName(Level level) {
+  return kLevelNames[level];
+}
+
+}  // namespace simd
+
+}  // namespace mdsf
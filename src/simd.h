@@ -0,0 +1,90 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef SRC_SIMD_H_
+#define SRC_SIMD_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mdsf {
+
+namespace simd {
+
+// Instruction set levels the kernels are implemented for, from the slowest
+// to the fastest. Every level also supports the ones before it.
+enum Level {
+  kScalar = 0,
+  kSse2,
+  kAvx2,
+  kAvx512,
+  kLevelCount
+};
+
+// The maximal number of digits ParseDigits() parses at once.
+const std::size_t kMaxParsedDigits = 16;
+
+// The set of kernel implementations of a level.
+struct Kernels {
+  std::size_t (*skip_json_white_space)(const char* begin, const char* end);
+  std::size_t (*skip_plain_string_chars)(const char* begin,
+                                         const char* end,
+                                         char        quote);
+  std::size_t (*skip_ascii)(const char* begin, const char* end);
+  std::size_t (*parse_digits)(const char*    begin,
+                              const char*    end,
+                              std::uint64_t* value);
+};
+
+// Kernels of the selected level. Scalar until Initialize() is called.
+extern Kernels kernels;
+
+// Detects the features of the CPU and selects the kernels. The level can be
+// forced with the MDSF_SIMD_LEVEL environment variable set to the name of a
+// level, it is lowered to the best one supported by the CPU. Only the first
+// call has an effect, so it is safe to call once per addon instance.
+void Initialize();
+
+// Returns the best level supported by the CPU and the compiler.
+Level GetSupportedLevel();
+
+// Returns the level of the selected kernels.
+Level GetLevel();
+
+// Returns the name of the level as accepted by MDSF_SIMD_LEVEL: "scalar",
+// "sse2", "avx2" or "avx512".
+const char* GetLevelName(Level level);
+
+// Returns the number of bytes from `begin` but not past `end` that are white
+// space allowed in JSON (space, \t, \n and \r).
+inline std::size_t SkipJsonWhiteSpace(const char* begin, const char* end) {
+  return kernels.skip_json_white_space(begin, end);
+}
+
+// Returns the number of bytes from `begin` but not past `end` that can be
+// copied to a string as is, i.e. ASCII characters other than `quote`,
+// backslash and line terminators.
+inline std::size_t SkipPlainStringChars(const char* begin,
+                                        const char* end,
+                                        char        quote) {
+  return kernels.skip_plain_string_chars(begin, end, quote);
+}
+
+// Returns the number of ASCII bytes from `begin` but not past `end`.
+inline std::size_t SkipAscii(const char* begin, const char* end) {
+  return kernels.skip_ascii(begin, end);
+}
+
+// Parses at most kMaxParsedDigits decimal digits from `begin` but not past
+// `end`. Returns the number of digits, their value is written to `value`.
+inline std::size_t ParseDigits(const char*    begin,
+                               const char*    end,
+                               std::uint64_t* value) {
+  return kernels.parse_digits(begin, end, value);
+}
+
+}  // namespace simd
+
+}  // namespace mdsf
+
+#endif  // SRC_SIMD_H_
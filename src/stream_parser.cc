@@ -0,0 +1,214 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#include "stream_parser.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include <v8.h>
+
+#include "common.h"
+#include "parser.h"
+#include "unicode_utils.h"
+
+using std::size_t;
+
+using v8::Array;
+using v8::Isolate;
+using v8::Local;
+
+using mdsf::parser::ValueParser;
+using mdsf::parser::internal::SkipToNextTokenInChunk;
+
+namespace mdsf {
+
+namespace stream_parser {
+
+ArrayStreamParser::ArrayStreamParser(const parser::ParseOptions& options)
+    : state_(kBeforeArray),
+      parser_(options),
+      incomplete_utf8_length_(0),
+      received_length_(0) {}
+
+bool ArrayStreamParser::Parse(Isolate* isolate,
+                              const char* chunk,
+                              size_t length,
+                              bool is_utf8,
+                              Local<Array> out) {
+  return ParseData(isolate, chunk, length, is_utf8, false, out);
+}
+
+bool ArrayStreamParser::Finish(Isolate* isolate, Local<Array> out) {
+  if (incomplete_utf8_length_ != 0) {
+    char message[64];
+    std::snprintf(message, sizeof(message),
+                  "Invalid UTF-8 sequence at position %zu",
+                  received_length_ - incomplete_utf8_length_);
+    THROW_EXCEPTION(SyntaxError, message);
+    Reset();
+    return false;
+  }
+  if (!ParseData(isolate, nullptr, 0, true, true, out)) {
+    return false;
+  }
+  if (state_ != kAfterArray) {
+    THROW_EXCEPTION(SyntaxError, "Unexpected end of data");
+    Reset();
+    return false;
+  }
+  Reset();
+  return true;
+}
+
+bool ArrayStreamParser::ParseData(Isolate* isolate,
+                                  const char* chunk,
+                                  size_t length,
+                                  bool is_utf8,
+                                  bool is_last,
+                                  Local<Array> out) {
+  auto context = isolate->GetCurrentContext();
+  uint32_t out_index = out->Length();
+
+  const char* begin = chunk;
+  const char* end = chunk + length;
+  if (!pending_.empty()) {
+    pending_.append(chunk, length);
+    begin = pending_.data();
+    end = begin + pending_.size();
+  }
+
+  // The truncated sequence at the end of the previous chunk is validated
+  // along with this one.
+  size_t incomplete_length = 0;
+  if (!is_utf8) {
+    const char* unchecked = end - length - incomplete_utf8_length_;
+    size_t error_offset;
+    if (!unicode_utils::ValidateUtf8(unchecked, end - unchecked, true,
+                                     &error_offset)) {
+      char message[64];
+      std::snprintf(message, sizeof(message),
+                    "Invalid UTF-8 sequence at position %zu",
+                    received_length_ - incomplete_utf8_length_ +
+                        error_offset);
+      THROW_EXCEPTION(SyntaxError, message);
+      Reset();
+      return false;
+    }
+    incomplete_length = unicode_utils::GetIncompleteUtf8Length(unchecked,
+                                                               end);
+  }
+  received_length_ += length;
+  incomplete_utf8_length_ = incomplete_length;
+  end -= incomplete_length;
+
+  const char* current = begin;
+  bool is_incomplete = false;
+
+  while (true) {
+    if (state_ == kInElement) {
+      size_t parsed_size = 0;
+      auto status = parser_.Parse(isolate, current, end, is_last,
+                                  &parsed_size);
+      current += parsed_size;
+      if (status == ValueParser::kError) {
+        Reset();
+        return false;
+      } else if (status == ValueParser::kIncomplete) {
+        break;
+      }
+      auto mb = out->Set(context, out_index++, parser_.Result());
+      if (!mb.FromMaybe(false)) {
+        Reset();
+        return false;
+      }
+      parser_.Reset();
+      state_ = kAfterElement;
+      continue;
+    }
+
+    current += SkipToNextTokenInChunk(current, end, is_last, &is_incomplete);
+    if (is_incomplete || current == end) {
+      break;
+    }
+
+    const char* error = nullptr;
+    switch (state_) {
+      case kBeforeArray: {
+        if (*current == '[') {
+          current++;
+          state_ = kBeforeElement;
+        } else {
+          error = "Top-level value is not an array";
+        }
+        break;
+      }
+      case kBeforeElement: {
+        if (*current == ']') {
+          // Either an empty array or a trailing comma, just as in ParseArray.
+          current++;
+          state_ = kAfterArray;
+        } else if (*current == ',') {
+          // An elided element.
+          auto mb = out->Set(context, out_index++, v8::Undefined(isolate));
+          if (!mb.FromMaybe(false)) {
+            Reset();
+            return false;
+          }
+          current++;
+        } else {
+          state_ = kInElement;
+        }
+        break;
+      }
+      case kAfterElement: {
+        if (*current == ',') {
+          current++;
+          state_ = kBeforeElement;
+        } else if (*current == ']') {
+          current++;
+          state_ = kAfterArray;
+        } else {
+          error = "Invalid format in array: missed comma";
+        }
+        break;
+      }
+      case kAfterArray: {
+        error = "Unexpected data after the array";
+        break;
+      }
+      case kInElement: {
+        break;
+      }
+    }
+    if (error != nullptr) {
+      THROW_EXCEPTION(SyntaxError, error);
+      Reset();
+      return false;
+    }
+  }
+
+  if (pending_.empty()) {
+    pending_.assign(current, end + incomplete_length - current);
+  } else {
+    pending_.erase(0, current - begin);
+  }
+  if (state_ == kInElement) {
+    parser_.Suspend(isolate);
+  }
+  return true;
+}
+
+void ArrayStreamParser::Reset() {
+  state_ = kBeforeArray;
+  parser_.Reset();
+  pending_.clear();
+  incomplete_utf8_length_ = 0;
+  received_length_ = 0;
+}
+
+}  // namespace stream_parser
+
+}  // namespace mdsf
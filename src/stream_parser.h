@@ -0,0 +1,80 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef SRC_STREAM_PARSER_H_
+#define SRC_STREAM_PARSER_H_
+
+#include <cstddef>
+#include <string>
+
+#include <v8.h>
+
+#include "parser.h"
+
+namespace mdsf {
+
+namespace stream_parser {
+
+// Parses a top-level array which is received in chunks and emits each of its
+// elements as soon as it has been received completely. An element is parsed
+// as its data arrives and suspended between the chunks, so every byte is
+// parsed once no matter how many chunks the element is split into.
+class ArrayStreamParser {
+ public:
+  explicit ArrayStreamParser(
+      const parser::ParseOptions& options = parser::ParseOptions());
+
+  // Parses the next chunk and appends the elements completed by it to
+  // `out`. Unless `is_utf8` tells that the chunk is known to be valid UTF-8
+  // (it comes from a JavaScript string), it is validated first, a sequence
+  // split between chunks is checked once the rest of it arrives. Returns
+  // false if an error has occurred, in which case a JavaScript exception is
+  // thrown and the state of the parser is reset.
+  bool Parse(v8::Isolate* isolate,
+             const char* chunk,
+             std::size_t length,
+             bool is_utf8,
+             v8::Local<v8::Array> out);
+
+  // Parses what is left of the data once all of it has been received and
+  // appends the last elements to `out`. Returns false and throws a
+  // JavaScript exception if the array is incomplete or is followed by
+  // anything but white space and comments.
+  bool Finish(v8::Isolate* isolate, v8::Local<v8::Array> out);
+
+ private:
+  enum State {
+    kBeforeArray = 0,  // before '['
+    kBeforeElement,    // after '[' or ','
+    kInElement,        // inside an element
+    kAfterElement,     // after an element
+    kAfterArray        // after ']'
+  };
+
+  bool ParseData(v8::Isolate* isolate,
+                 const char* chunk,
+                 std::size_t length,
+                 bool is_utf8,
+                 bool is_last,
+                 v8::Local<v8::Array> out);
+
+  void Reset();
+
+  State state_;
+  parser::ValueParser parser_;
+  // Data that has been received but not consumed yet (an incomplete token).
+  std::string pending_;
+  // Number of bytes at the end of `pending_` that begin a UTF-8 sequence
+  // truncated by the end of the chunk, they are not parsed until the rest
+  // of the sequence arrives.
+  std::size_t incomplete_utf8_length_;
+  // Number of bytes received so far, used to report the positions of
+  // invalid UTF-8 sequences.
+  std::size_t received_length_;
+};
+
+}  // namespace stream_parser
+
+}  // namespace mdsf
+
+#endif  // SRC_STREAM_PARSER_H_
@@ -0,0 +1,452 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#include "structural_index.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <uv.h>
+
+#include "char_class.h"
+#include "parser.h"
+#include "unicode_utils.h"
+
+using std::size_t;
+using std::uint16_t;
+using std::uint64_t;
+
+using mdsf::char_class::GetCharClasses;
+using mdsf::char_class::kJsonWhiteSpace;
+using mdsf::char_class::kLineTerminator;
+using mdsf::char_class::kUnicodeSpaceLead;
+using mdsf::char_class::kWhiteSpace;
+
+using mdsf::unicode_utils::IsLineTerminatorSequence;
+using mdsf::unicode_utils::IsWhiteSpaceCharacter;
+
+namespace mdsf {
+
+namespace structural_index {
+
+// Lexical states a block can start in.
+enum State {
+  kCode = 0,
+  kDoubleQuoted,
+  kSingleQuoted,
+  kLineComment,
+  kMultilineComment,
+  kStateCount
+};
+
+struct Block {
+  std::size_t begin;
+  std::size_t end;
+  // The state the block ends in for every state it may start in.
+  State end_states[kStateCount];
+  State start_state;
+  // The first and the last words of the block in the bitmap, they may be
+  // shared with the neighbouring blocks and are merged after the scan.
+  uint64_t first_word;
+  uint64_t last_word;
+};
+
+// Sets the bits of the bytes of a block without touching the words that
+// may be written by other threads at the same time.
+class BitmapWriter {
+ public:
+  BitmapWriter(uint64_t* words, Block* block)
+      : words_(words),
+        block_(block),
+        first_index_(block->begin / 64),
+        last_index_((block->end - 1) / 64) {}
+
+  // Marks the bytes from `begin` to `end`, but not past the block.
+  void Mark(size_t begin, size_t end) {
+    end = std::min(end, block_->end);
+    while (begin < end) {
+      size_t shift = begin % 64;
+      size_t count = std::min<size_t>(64 - shift, end - begin);
+      uint64_t bits = count == 64 ? ~static_cast<uint64_t>(0) :
+                                    (static_cast<uint64_t>(1) << count) - 1;
+      Word(begin / 64) |= bits << shift;
+      begin += count;
+    }
+  }
+
+  // Unmarks all of the bytes of the block.
+  void Clear() {
+    block_->first_word = 0;
+    block_->last_word = 0;
+    for (size_t i = first_index_ + 1; i < last_index_; i++) {
+      words_[i] = 0;
+    }
+  }
+
+ private:
+  uint64_t& Word(size_t index) {
+    if (index == first_index_) {
+      return block_->first_word;
+    } else if (index == last_index_) {
+      return block_->last_word;
+    }
+    return words_[index];
+  }
+
+  uint64_t* words_;
+  Block* block_;
+  size_t first_index_;
+  size_t last_index_;
+};
+
+// Bytes that may change the state or be skipped when outside of strings and
+// comments: white space, quotes, slash and the leading bytes of multibyte
+// characters.
+static const bool kCodeSpecialChars[256] = {
+// 0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0,  // 0x00: \t \n \v \f \r
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // 0x10
+   1, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1,  // 0x20: space " ' /
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // 0x30
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // 0x40
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // 0x50
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // 0x60
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // 0x70
+   1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  // 0x80
+   1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  // 0x90
+   1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  // 0xA0
+   1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  // 0xB0
+   1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  // 0xC0
+   1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  // 0xD0
+   1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  // 0xE0
+   1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  // 0xF0
+};
+
+static inline bool IsCodeSpecialChar(char c) {
+  return kCodeSpecialChars[static_cast<unsigned char>(c)];
+}
+
+static inline bool IsContinuationByte(char c) {
+  return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+// Returns true if a block may start at `position`. The state at such
+// positions only depends on whether they are inside a string or a comment:
+// they don't follow a backslash, the first character of a comment delimiter
+// or CR (which may start CRLF), and are not inside a multibyte character.
+static bool IsBlockBoundary(const char* str, size_t position) {
+  char previous = str[position - 1];
+  return !IsContinuationByte(str[position]) && previous != '\\' &&
+         previous != '/' && previous != '*' && previous != '\x0D';
+}
+
+static inline void Mark(BitmapWriter* writer, size_t begin, size_t end) {
+  if (writer != nullptr) {
+    writer->Mark(begin, end);
+  }
+}
+
+// Returns the size of the white space character or line terminator at
+// `str`, or 0 if there is none. Never reads past `end`.
+template <typename Dialect>
+static size_t GetWhiteSpaceSize(const char* str, const char* end) {
+  const uint16_t classes = GetCharClasses(*str);
+  if (classes & kJsonWhiteSpace) {
+    return 1;
+  }
+  if (!Dialect::kAllowUnicodeWhiteSpace) {
+    return 0;
+  }
+  if (classes & (kWhiteSpace | kLineTerminator)) {
+    return 1;
+  }
+  if (!(classes & kUnicodeSpaceLead)) {
+    return 0;
+  }
+  char buffer[3] = { 0, 0, 0 };
+  std::memcpy(buffer, str, std::min<size_t>(end - str, sizeof(buffer)));
+  size_t size;
+  if (IsWhiteSpaceCharacter(buffer, &size) ||
+      IsLineTerminatorSequence(buffer, &size)) {
+    return size;
+  }
+  return 0;
+}
+
+// Returns the size of the line terminator at `str`, or 0 if there is none.
+// Never reads past `end`.
+static size_t GetLineTerminatorSize(const char* str, const char* end) {
+  if (*str == '\x0A' || *str == '\x0D') {
+    return 1;
+  }
+  if (end - str >= 3 && str[0] == '\xE2' && str[1] == '\x80' &&
+      (str[2] == '\xA8' || str[2] == '\xA9')) {
+    return 3;
+  }
+  return 0;
+}
+
+// Scans a block starting in `state` and returns the state it ends in. Marks
+// the skipped bytes if `writer` is not null.
+template <typename Dialect>
+static State ScanBlock(const char* str,
+                       size_t length,
+                       const Block& block,
+                       State state,
+                       BitmapWriter* writer) {
+  const char* data_end = str + length;
+  size_t pos = block.begin;
+  while (pos < block.end) {
+    switch (state) {
+      case kCode: {
+        while (pos < block.end && !IsCodeSpecialChar(str[pos])) {
+          pos++;
+        }
+        if (pos == block.end) {
+          break;
+        }
+        char c = str[pos];
+        if (c == '"' || (Dialect::kAllowSingleQuotes && c == '\'')) {
+          state = c == '"' ? kDoubleQuoted : kSingleQuoted;
+          pos++;
+        } else if (Dialect::kAllowComments && c == '/' && pos + 1 < length &&
+                   (str[pos + 1] == '/' || str[pos + 1] == '*')) {
+          state = str[pos + 1] == '/' ? kLineComment : kMultilineComment;
+          Mark(writer, pos, pos + 2);
+          pos += 2;
+        } else {
+          size_t begin = pos;
+          size_t size;
+          while (pos < block.end &&
+                 (size = GetWhiteSpaceSize<Dialect>(str + pos, data_end))) {
+            pos += size;
+          }
+          if (pos == begin) {
+            pos++;
+          } else {
+            Mark(writer, begin, pos);
+          }
+        }
+        break;
+      }
+      case kDoubleQuoted:
+      case kSingleQuoted: {
+        char quote = state == kDoubleQuoted ? '"' : '\'';
+        while (pos < block.end && str[pos] != quote && str[pos] != '\\') {
+          pos++;
+        }
+        if (pos < block.end) {
+          if (str[pos] == quote) {
+            state = kCode;
+            pos++;
+          } else {
+            pos += 2;
+          }
+        }
+        break;
+      }
+      case kLineComment: {
+        size_t begin = pos;
+        size_t size = 0;
+        for (; pos < block.end; pos++) {
+          char c = str[pos];
+          if ((c == '\x0A' || c == '\x0D' || c == '\xE2') &&
+              (size = GetLineTerminatorSize(str + pos, data_end))) {
+            break;
+          }
+        }
+        if (pos < block.end) {
+          pos += size;
+          state = kCode;
+        }
+        Mark(writer, begin, pos);
+        break;
+      }
+      case kMultilineComment: {
+        size_t begin = pos;
+        for (; pos < block.end; pos++) {
+          if (str[pos] == '*' && pos + 1 < length && str[pos + 1] == '/') {
+            pos += 2;
+            state = kCode;
+            break;
+          }
+        }
+        Mark(writer, begin, pos);
+        break;
+      }
+      default: {
+        break;
+      }
+    }
+  }
+  return state;
+}
+
+// Calls function(i) for every i below `count` on its own thread. Threads are
+// created with libuv, which reports failures instead of throwing, and the
+// calls the threads could not be created for are made on the calling thread.
+template <typename Function>
+static void RunInParallel(size_t count, Function function) {
+  struct Task {
+    Function* function;
+    size_t index;
+    uv_thread_t thread;
+    bool started;
+  };
+  auto run = [](void* arg) {
+    Task* task = static_cast<Task*>(arg);
+    (*task->function)(task->index);
+  };
+
+  std::vector<Task> tasks(count);
+  for (size_t i = 1; i < count; i++) {
+    tasks[i].function = &function;
+    tasks[i].index = i;
+    tasks[i].started = uv_thread_create(&tasks[i].thread, run, &tasks[i]) == 0;
+  }
+  function(0);
+  for (size_t i = 1; i < count; i++) {
+    if (tasks[i].started) {
+      uv_thread_join(&tasks[i].thread);
+    } else {
+      function(i);
+    }
+  }
+}
+
+static inline unsigned CountTrailingZeros(uint64_t value) {
+#if defined(__GNUC__)
+  return __builtin_ctzll(value);
+#else
+  unsigned count = 0;
+  while (!(value & 1)) {
+    value >>= 1;
+    count++;
+  }
+  return count;
+#endif
+}
+
+unsigned GetThreadCount() {
+  const char* value = std::getenv("MDSF_PARSE_THREADS");
+  if (value == nullptr) {
+    return 1;
+  }
+  long count = std::strtol(value, nullptr, 10);
+  if (count <= 1) {
+    return 1;
+  }
+  return static_cast<unsigned>(
+      std::min<long>(count, static_cast<long>(kMaxThreadCount)));
+}
+
+StructuralIndex::StructuralIndex() : begin_(nullptr), end_(nullptr) {}
+
+template <typename Dialect>
+bool StructuralIndex::Build(const char* str,
+                            size_t length,
+                            unsigned thread_count) {
+  begin_ = str;
+  end_ = str + length;
+  skipped_.assign((length + 63) / 64, 0);
+
+  size_t block_count = std::max<size_t>(
+      1, std::min<size_t>(thread_count, length / kMinBlockSize));
+  std::vector<Block> blocks(block_count);
+  size_t begin = 0;
+  for (size_t i = 0; i < block_count; i++) {
+    size_t end = length;
+    if (i + 1 < block_count) {
+      end = std::max(begin, length / block_count * (i + 1));
+      while (end < length && !IsBlockBoundary(str, end)) {
+        end++;
+      }
+    }
+    blocks[i].begin = begin;
+    blocks[i].end = end;
+    blocks[i].first_word = 0;
+    blocks[i].last_word = 0;
+    begin = end;
+  }
+
+  const State kStates[] = {
+    kCode, kDoubleQuoted, kSingleQuoted, kLineComment, kMultilineComment
+  };
+  const size_t state_count = Dialect::kAllowComments ? kStateCount :
+                                                       kDoubleQuoted + 1;
+  // The blocks are marked as if they start outside of strings and comments
+  // right away, since most of them do.
+  uint64_t* words = skipped_.data();
+  RunInParallel(block_count, [&](size_t i) {
+    Block& block = blocks[i];
+    if (block.begin == block.end) {
+      for (size_t j = 0; j < state_count; j++) {
+        block.end_states[j] = kStates[j];
+      }
+      return;
+    }
+    BitmapWriter writer(words, &block);
+    block.end_states[kCode] =
+        ScanBlock<Dialect>(str, length, block, kCode, &writer);
+    for (size_t j = 1; j < state_count; j++) {
+      block.end_states[j] =
+          ScanBlock<Dialect>(str, length, block, kStates[j], nullptr);
+    }
+  });
+
+  State state = kCode;
+  for (Block& block : blocks) {
+    block.start_state = state;
+    state = block.end_states[state];
+  }
+  if (state != kCode && state != kLineComment) {
+    return false;
+  }
+
+  RunInParallel(block_count, [&](size_t i) {
+    Block& block = blocks[i];
+    if (block.begin == block.end || block.start_state == kCode) {
+      return;
+    }
+    BitmapWriter writer(words, &block);
+    writer.Clear();
+    ScanBlock<Dialect>(str, length, block, block.start_state, &writer);
+  });
+
+  for (const Block& block : blocks) {
+    if (block.begin != block.end) {
+      skipped_[block.begin / 64] |= block.first_word;
+      skipped_[(block.end - 1) / 64] |= block.last_word;
+    }
+  }
+  return true;
+}
+
+const char* StructuralIndex::SkipToNextToken(const char* position) const {
+  size_t offset = position - begin_;
+  size_t length = end_ - begin_;
+  while (offset < length) {
+    uint64_t not_skipped = ~skipped_[offset / 64] >> (offset % 64);
+    if (not_skipped != 0) {
+      offset += CountTrailingZeros(not_skipped);
+      break;
+    }
+    offset = (offset / 64 + 1) * 64;
+  }
+  return offset < length ? begin_ + offset : end_;
+}
+
+template bool StructuralIndex::Build<parser::MdsfDialect>(const char*,
+                                                          size_t,
+                                                          unsigned);
+template bool StructuralIndex::Build<parser::JsonDialect>(const char*,
+                                                          size_t,
+                                                          unsigned);
+
+}  // namespace structural_index
+
+}  // namespace mdsf
@@ -0,0 +1,65 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef SRC_STRUCTURAL_INDEX_H_
+#define SRC_STRUCTURAL_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mdsf {
+
+namespace structural_index {
+
+// Inputs of parser::Parse() at least this long are indexed in parallel.
+const std::size_t kMinParallelSize = 8 * 1024 * 1024;
+
+// Minimum size of a block scanned by a single thread.
+const std::size_t kMinBlockSize = 1024 * 1024;
+
+// Maximum number of threads a single input is indexed with.
+const unsigned kMaxThreadCount = 32;
+
+// Returns the number of threads to index large inputs with: the value of the
+// MDSF_PARSE_THREADS environment variable limited to kMaxThreadCount, or 1 if
+// it is not set. Indexing is disabled if it is 1, since starting the threads
+// for every parse() call costs more than it saves unless it is tuned for the
+// workload.
+unsigned GetThreadCount();
+
+// Bitmap of the bytes the tokenizer skips between tokens: white space, line
+// terminators and comments outside of strings. The data is split into
+// blocks which are scanned in parallel. Since the state a block starts in
+// (inside a string, a comment, or neither) depends on everything before it,
+// every block is first scanned from each of the possible states. A
+// sequential pass over the blocks then finds the state each one actually
+// starts in, and the bitmap is filled by a second parallel scan.
+class StructuralIndex {
+ public:
+  StructuralIndex();
+
+  // Indexes `length` bytes at `str` using at most `thread_count` threads.
+  // The blocks of the threads that could not be started are scanned by the
+  // calling thread.
+  // Returns false if the data ends inside a string or a multi-line comment.
+  // The index can't be used then, and the error is left to the tokenizer.
+  template <typename Dialect>
+  bool Build(const char* str, std::size_t length, unsigned thread_count);
+
+  // Returns the first byte at or after `position` that is not skipped
+  // between tokens, or the end of the data. Same as SkipToNextToken() for
+  // the positions where the tokenizer expects a token.
+  const char* SkipToNextToken(const char* position) const;
+
+ private:
+  const char* begin_;
+  const char* end_;
+  std::vector<std::uint64_t> skipped_;
+};
+
+}  // namespace structural_index
+
+}  // namespace mdsf
+
+#endif  // SRC_STRUCTURAL_INDEX_H_
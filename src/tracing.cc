@@ -0,0 +1,74 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#include "tracing.h"
+
+#include <cstdint>
+
+#include <node.h>
+#include <v8.h>
+
+using std::uint64_t;
+using std::uint8_t;
+
+namespace mdsf {
+
+namespace tracing {
+
+#ifdef MDSF_HAVE_TRACING
+
+// Trace event constants from V8's trace_event_common.h, which is not a part
+// of the public headers.
+const char kPhaseBegin = 'B';
+const char kPhaseEnd = 'E';
+const uint8_t kValueTypeUint = 2;
+const unsigned int kFlagNone = 0;
+
+static v8::TracingController* GetController() {
+  return node::GetTracingController();
+}
+
+// Returns the pointer to the enabled flag of the category, which is updated
+// by the tracing controller when tracing is started and stopped.
+static const uint8_t* GetCategoryEnabled() {
+  static const uint8_t* category_enabled =
+      GetController() ? GetController()->GetCategoryGroupEnabled(kCategory) :
+                        nullptr;
+  return category_enabled;
+}
+
+ScopedSpan::ScopedSpan(const char* name)
+    : category_enabled_(nullptr), name_(name), arg_count_(0) {
+  const uint8_t* category_enabled = GetCategoryEnabled();
+  if (category_enabled == nullptr || *category_enabled == 0) {
+    return;
+  }
+  category_enabled_ = category_enabled;
+  GetController()->AddTraceEvent(kPhaseBegin, category_enabled_, name_,
+                                 nullptr, 0, 0, 0, nullptr, nullptr, nullptr,
+                                 nullptr, kFlagNone);
+}
+
+void ScopedSpan::End() {
+  if (category_enabled_ == nullptr) {
+    return;
+  }
+  uint8_t arg_types[kMaxArgs] = { kValueTypeUint, kValueTypeUint };
+  GetController()->AddTraceEvent(kPhaseEnd, category_enabled_, name_,
+                                 nullptr, 0, 0, arg_count_, arg_names_,
+                                 arg_types, arg_values_, nullptr, kFlagNone);
+  category_enabled_ = nullptr;
+}
+
+#else
+
+ScopedSpan::ScopedSpan(const char* name)
+    : category_enabled_(nullptr), name_(name), arg_count_(0) {}
+
+void ScopedSpan::End() {}
+
+#endif  // MDSF_HAVE_TRACING
+
+}  // namespace tracing
+
+}  // namespace mdsf
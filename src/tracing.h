@@ -0,0 +1,67 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef SRC_TRACING_H_
+#define SRC_TRACING_H_
+
+#include <cstdint>
+
+#include <node.h>
+#include <node_version.h>
+#include <v8.h>
+
+// node::GetTracingController() is available since Node.js 14.6.0, spans are
+// not emitted on older versions.
+#if !defined(V8_USE_PERFETTO) &&                                               \
+    (NODE_MAJOR_VERSION > 14 ||                                                \
+     (NODE_MAJOR_VERSION == 14 && NODE_MINOR_VERSION >= 6))
+#define MDSF_HAVE_TRACING 1
+#endif
+
+namespace mdsf {
+
+namespace tracing {
+
+// Category of all the trace events emitted by the addon, enable it using
+// `node --trace-event-categories mdsf`.
+const char kCategory[] = "mdsf";
+
+// Emits a pair of begin and end trace events around its lifetime, so that
+// the span shows up in the timeline along with GC and libuv events. Does
+// nothing but a single check when the category is disabled.
+class ScopedSpan {
+ public:
+  explicit ScopedSpan(const char* name);
+  ~ScopedSpan() { End(); }
+
+  bool IsEnabled() const { return category_enabled_ != nullptr; }
+
+  // Adds an argument to be recorded with the end event, so that values only
+  // known after the work is done, like the number of parsed messages, can be
+  // recorded too. Arguments above kMaxArgs are ignored.
+  void AddArg(const char* name, std::uint64_t value) {
+    if (arg_count_ < kMaxArgs) {
+      arg_names_[arg_count_] = name;
+      arg_values_[arg_count_] = value;
+      arg_count_++;
+    }
+  }
+
+  // Emits the end event before the span goes out of scope.
+  void End();
+
+ private:
+  static const int kMaxArgs = 2;
+
+  const std::uint8_t* category_enabled_;
+  const char* name_;
+  int arg_count_;
+  const char* arg_names_[kMaxArgs];
+  std::uint64_t arg_values_[kMaxArgs];
+};
+
+}  // namespace tracing
+
+}  // namespace mdsf
+
+#endif  // SRC_TRACING_H_
@@ -8,16 +8,26 @@
 #include <cstddef>
 #include <cstdint>
 
+#include "char_class.h"
+#include "simd.h"
 #include "unicode_tables.h"
 
 using std::size_t;
 using std::uint32_t;
 
+using mdsf::char_class::GetCharClasses;
+using mdsf::char_class::kLineTerminator;
+using mdsf::char_class::kUnicodeSpaceLead;
+using mdsf::char_class::kWhiteSpace;
+
 namespace mdsf {
 
 namespace unicode_utils {
 
 bool IsLineTerminatorSequence(const char* str, size_t* size) {
+  if (!(GetCharClasses(str[0]) & (kLineTerminator | kUnicodeSpaceLead))) {
+    return false;
+  }
   if (str[0] == '\x0D' && str[1] == '\x0A') {
     *size = 2;
     return true;
@@ -35,13 +45,12 @@ bool IsLineTerminatorSequence(const char* str, size_t* size) {
 }
 
 bool IsWhiteSpaceCharacter(const char* str, size_t* size) {
-  if (str[0] == '\x09' ||
-      str[0] == '\x0B' ||
-      str[0] == '\x0C' ||
-      str[0] == '\x20' ||
-      str[0] == '\xA0') {
+  const uint16_t classes = GetCharClasses(str[0]);
+  if (classes & kWhiteSpace) {
     *size = 1;
     return true;
+  } else if (!(classes & kUnicodeSpaceLead)) {
+    return false;
   } else if (str[0] == '\xC2' && str[1] == '\xA0') {
     *size = 2;
     return true;
@@ -142,18 +151,95 @@ uint32_t Utf8ToCodePoint(const char* begin, size_t* size) {
   return result;
 }
 
-#ifdef _PARSER_USE_FULL_TABLES_
+bool ValidateUtf8(const char* str,
+                  size_t      length,
+                  bool        allow_incomplete,
+                  size_t*     error_offset) {
+  auto begin = reinterpret_cast<const unsigned char*>(str);
+  const unsigned char* current = begin;
+  const unsigned char* end = begin + length;
+  while (current < end) {
+    // Skip runs of ASCII characters at once, only bytes with the high bit set
+    // need to be checked one by one.
+    current += simd::SkipAscii(reinterpret_cast<const char*>(current),
+                               reinterpret_cast<const char*>(end));
+    if (current == end) {
+      break;
+    }
+    const unsigned char lead = *current;
+
+    size_t seq_size;
+    // Bounds of the second byte, they are narrower than 0x80..0xBF for some
+    // lead bytes to reject overlong encodings, surrogates and code points
+    // above U+10FFFF.
+    unsigned char lower = 0x80, upper = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+      seq_size = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+      seq_size = 3;
+      if (lead == 0xE0) {
+        lower = 0xA0;
+      } else if (lead == 0xED) {
+        upper = 0x9F;
+      }
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+      seq_size = 4;
+      if (lead == 0xF0) {
+        lower = 0x90;
+      } else if (lead == 0xF4) {
+        upper = 0x8F;
+      }
+    } else {
+      *error_offset = current - begin;
+      return false;
+    }
+
+    size_t available = end - current;
+    for (size_t i = 1; i < seq_size; i++) {
+      if (i >= available) {
+        if (allow_incomplete) {
+          return true;
+        }
+        *error_offset = current - begin;
+        return false;
+      }
+      const unsigned char byte = current[i];
+      if (i == 1 ? (byte < lower || byte > upper) : (byte & 0xC0) != 0x80) {
+        *error_offset = current - begin;
+        return false;
+      }
+    }
+    current += seq_size;
+  }
+  return true;
+}
+
+size_t GetIncompleteUtf8Length(const char* begin, const char* end) {
+  for (size_t i = 1; i <= 3 && i <= static_cast<size_t>(end - begin); i++) {
+    unsigned char c = static_cast<unsigned char>(end[-i]);
+    if (c < 0x80) {
+      return 0;
+    }
+    if (c >= 0xC0) {
+      size_t seq_size = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : 2;
+      return seq_size > i ? i : 0;
+    }
+  }
+  return 0;
+}
+
+#if defined(_PARSER_USE_FULL_TABLES_)
 
 bool IsIdStartCodePoint(uint32_t cp) {
-  return ID_START_FULL[cp];
+  return cp <= 0x10FFFF && ID_START_FULL[cp];
 }
 
 bool IsIdPartCodePoint(uint32_t cp) {
-  return ID_CONTINUE_FULL[cp];
+  return cp <= 0x10FFFF && ID_CONTINUE_FULL[cp];
 }
 
 #undef _PARSER_USE_FULL_TABLES_
-#else
+#elif defined(_PARSER_USE_SHORT_TABLES_)
 
 bool search_cp(uint32_t cp, const unicode_range* ranges, size_t size) {
   size_t low = 0;
@@ -195,6 +281,30 @@ bool IsIdPartCodePoint(uint32_t cp) {
                    cp == 0x200C || cp == 0x200D; // ZWNJ, ZWJ
 }
 
+#undef _PARSER_USE_SHORT_TABLES_
+#else
+
+// Looks up the bit of the code point in the two-level trie: the index table
+// selects a block of 2^ID_TRIE_BLOCK_BITS code points and the bit in that
+// block tells whether the code point belongs to the set.
+template <typename IndexType>
+static inline bool LookupTrie(const IndexType* index, uint32_t cp) {
+  if (cp > 0x10FFFF) {
+    return false;
+  }
+  const uint32_t* block = ID_TRIE_BLOCKS[index[cp >> ID_TRIE_BLOCK_BITS]];
+  const uint32_t offset = cp & ((1 << ID_TRIE_BLOCK_BITS) - 1);
+  return (block[offset >> 5] >> (offset & 31)) & 1;
+}
+
+bool IsIdStartCodePoint(uint32_t cp) {
+  return LookupTrie(ID_START_TRIE_INDEX, cp);
+}
+
+bool IsIdPartCodePoint(uint32_t cp) {
+  return LookupTrie(ID_CONTINUE_TRIE_INDEX, cp);
+}
+
 #endif
 
 
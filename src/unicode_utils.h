@@ -31,6 +31,20 @@ void CodePointToUtf8(unsigned int c, std::size_t* size, char* write_to);
 // `size` will receive the number of bytes the code point occupies.
 std::uint32_t Utf8ToCodePoint(const char* begin, std::size_t* size);
 
+// Checks whether `length` bytes starting at `str` are well-formed UTF-8
+// (no overlong encodings, surrogates or code points above U+10FFFF).
+// If `allow_incomplete` is true, a sequence truncated by the end of the data
+// is not considered an error. On failure `error_offset` will receive the
+// offset of the first invalid sequence.
+bool ValidateUtf8(const char*  str,
+                  std::size_t  length,
+                  bool         allow_incomplete,
+                  std::size_t* error_offset);
+
+// Returns the number of bytes at the end of valid UTF-8 data between `begin`
+// and `end` that begin a sequence truncated by `end`.
+std::size_t GetIncompleteUtf8Length(const char* begin, const char* end);
+
 // Checks whether the given Unicode code point is a valid IdentifierStart.
 bool IsIdStartCodePoint(std::uint32_t cp);
 
@@ -0,0 +1,138 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#include "validator.h"
+
+#include <cstddef>
+
+#include "parser.h"
+#include "unicode_utils.h"
+#include "value_scanner.h"
+
+using std::size_t;
+
+using mdsf::parser::internal::DecodedString;
+using mdsf::value_scanner::Error;
+using mdsf::value_scanner::ErrorType;
+
+namespace mdsf {
+
+namespace validator {
+
+// Handler of value_scanner::Scan() counting the tokens.
+class StatsCollector {
+ public:
+  explicit StatsCollector(ValidateStats* stats) : stats_(stats), depth_(0) {}
+
+  bool StartArray() {
+    stats_->arrays++;
+    return StartContainer();
+  }
+
+  bool EndArray() {
+    depth_--;
+    return true;
+  }
+
+  bool StartObject() {
+    stats_->objects++;
+    return StartContainer();
+  }
+
+  bool EndObject() {
+    depth_--;
+    return true;
+  }
+
+  bool Key(const DecodedString& key) {
+    stats_->keys++;
+    return true;
+  }
+
+  bool NumericKey(double key) {
+    stats_->keys++;
+    return true;
+  }
+
+  bool Undefined() {
+    stats_->values++;
+    return true;
+  }
+
+  bool Null() {
+    stats_->values++;
+    return true;
+  }
+
+  bool Bool(bool value) {
+    stats_->values++;
+    return true;
+  }
+
+  bool Number(double value) {
+    stats_->values++;
+    stats_->numbers++;
+    return true;
+  }
+
+  bool String(const DecodedString& value) {
+    stats_->values++;
+    stats_->strings++;
+    return true;
+  }
+
+  // Never called since no token is rejected.
+  Error GetError() const {
+    Error error;
+    error.type = ErrorType::kSyntaxError;
+    error.message = "Invalid format";
+    error.offset = 0;
+    return error;
+  }
+
+ private:
+  bool StartContainer() {
+    stats_->values++;
+    depth_++;
+    if (depth_ > stats_->depth) {
+      stats_->depth = depth_;
+    }
+    return true;
+  }
+
+  ValidateStats* stats_;
+  size_t depth_;
+};
+
+bool Validate(const char*           str,
+              size_t                length,
+              bool                  is_utf8,
+              const ValidateLimits& limits,
+              ValidateStats*        stats,
+              Error*                error) {
+  *stats = ValidateStats();
+  if (length > limits.max_size) {
+    error->type = ErrorType::kRangeError;
+    error->message = "Maximum size exceeded";
+    error->offset = limits.max_size;
+    return false;
+  }
+  if (!is_utf8 &&
+      !unicode_utils::ValidateUtf8(str, length, false, &error->offset)) {
+    error->type = ErrorType::kSyntaxError;
+    error->message = "Invalid UTF-8 sequence";
+    return false;
+  }
+
+  StatsCollector collector(stats);
+  if (limits.dialect == parser::Dialect::kJson) {
+    return value_scanner::Scan<parser::JsonDialect>(
+        str, str + length, limits.max_depth, &collector, error);
+  }
+  return value_scanner::Scan<parser::MdsfDialect>(
+      str, str + length, limits.max_depth, &collector, error);
+}
+
+}  // namespace validator
+
+}  // namespace mdsf
@@ -0,0 +1,65 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef SRC_VALIDATOR_H_
+#define SRC_VALIDATOR_H_
+
+#include <cstddef>
+#include <limits>
+
+#include "parser.h"
+#include "value_scanner.h"
+
+namespace mdsf {
+
+namespace validator {
+
+struct ValidateLimits {
+  ValidateLimits() : max_size(std::numeric_limits<std::size_t>::max()),
+                     max_depth(parser::kDefaultMaxDepth),
+                     dialect(parser::Dialect::kMdsf) {}
+
+  // Maximum size of the data in bytes.
+  std::size_t max_size;
+  // Maximum nesting depth of arrays and objects.
+  std::size_t max_depth;
+  // Grammar the data is checked against.
+  parser::Dialect dialect;
+};
+
+// What has been found in valid data.
+struct ValidateStats {
+  ValidateStats() : depth(0), values(0), arrays(0), objects(0), keys(0),
+                    strings(0), numbers(0) {}
+
+  // Maximum nesting depth of arrays and objects, 0 for a scalar value.
+  std::size_t depth;
+  // All values including arrays, objects and elided array elements, but
+  // not keys.
+  std::size_t values;
+  std::size_t arrays;
+  std::size_t objects;
+  std::size_t keys;
+  std::size_t strings;
+  std::size_t numbers;
+};
+
+// Checks that `length` bytes at `str` are a single well-formed value with
+// the grammar of parser::Parse() within `limits`, without creating any
+// JavaScript values. The bytes are checked to be valid UTF-8 as well unless
+// `is_utf8` tells that they are known to be. Returns true and fills `stats`,
+// or returns false and fills `error` with the exception parse() would throw
+// and the offset of the offending token (of the first byte past the limit
+// if the data is too large).
+bool Validate(const char*           str,
+              std::size_t           length,
+              bool                  is_utf8,
+              const ValidateLimits& limits,
+              ValidateStats*        stats,
+              value_scanner::Error* error);
+
+}  // namespace validator
+
+}  // namespace mdsf
+
+#endif  // SRC_VALIDATOR_H_
@@ -0,0 +1,334 @@
+// Copyright (c) 2018 mdsf project authors. Use of this source code is
+// governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef SRC_VALUE_SCANNER_H_
+#define SRC_VALUE_SCANNER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "char_class.h"
+#include "parser.h"
+
+namespace mdsf {
+
+namespace value_scanner {
+
+// Kinds of errors, named after the exceptions parser::Parse() throws.
+enum class ErrorType { kSyntaxError = 0, kTypeError, kRangeError };
+
+struct Error {
+  ErrorType type;
+  const char* message;
+  // Offset of the token the error has been detected at.
+  std::size_t offset;
+};
+
+namespace internal {
+
+enum State {
+  kArrayElement = 0,  // after '[' or ','
+  kArrayDelimiter,    // after an element of array
+  kObjectKey,         // after '{' or ','
+  kObjectColon,       // after a key in object
+  kObjectValue,       // after ':'
+  kObjectDelimiter    // after a value in object
+};
+
+struct Frame {
+  State state;
+  std::uint32_t index;
+};
+
+}  // namespace internal
+
+// Scans a single value from `begin` to `end` with the grammar of
+// parser::Parse() and reports the same errors, but passes the tokens to
+// `handler` instead of creating any JavaScript values. The value must take
+// all of the data except for the white space and comments around it.
+// Returns false and fills `error` if the data is malformed or the handler
+// has rejected a token. The handler must provide the following methods:
+//   bool StartArray();
+//   bool EndArray();
+//   bool StartObject();
+//   bool EndObject();
+//   bool Key(const parser::internal::DecodedString& key);
+//   bool NumericKey(double key);
+//   bool Undefined();
+//   bool Null();
+//   bool Bool(bool value);
+//   bool Number(double value);
+//   bool String(const parser::internal::DecodedString& value);
+//   Error GetError() const;
+// A method returns false to stop scanning, GetError() then returns the
+// error to report, its offset is set by the scanner.
+template <typename Dialect, typename Handler>
+bool Scan(const char* begin,
+          const char* end,
+          std::size_t max_depth,
+          Handler*    handler,
+          Error*      error) {
+  using internal::Frame;
+  using parser::internal::DecodedString;
+
+  std::vector<Frame> stack;
+  const char* current = begin;
+  std::size_t current_length = 0;
+  parser::Type current_type;
+  const char* message;
+  bool is_complete = false;
+
+  auto fail = [&](ErrorType type, const char* text) {
+    error->type = type;
+    error->message = text;
+    error->offset = current - begin;
+    return false;
+  };
+  auto reject = [&]() {
+    *error = handler->GetError();
+    error->offset = current - begin;
+    return false;
+  };
+  // Counts a finished value in the innermost array or object.
+  auto add_value = [&]() {
+    if (stack.empty()) {
+      is_complete = true;
+      return;
+    }
+    Frame& frame = stack.back();
+    frame.index++;
+    frame.state = frame.state == internal::kArrayElement ?
+                  internal::kArrayDelimiter : internal::kObjectDelimiter;
+  };
+
+  while (!is_complete) {
+    current += parser::internal::SkipToNextToken<Dialect>(current, end);
+
+    if (current == end) {
+      if (stack.empty()) {
+        return fail(ErrorType::kTypeError, "Invalid type");
+      } else if (stack.back().state == internal::kArrayElement ||
+                 stack.back().state == internal::kArrayDelimiter) {
+        return fail(ErrorType::kSyntaxError,
+                    "Missing closing bracket in array");
+      }
+      return fail(ErrorType::kSyntaxError, "Missing closing brace in object");
+    }
+
+    const char* invalid_type_message = "Invalid type";
+
+    if (!stack.empty()) {
+      Frame& frame = stack.back();
+      switch (frame.state) {
+        case internal::kArrayElement: {
+          if (*current == ']' &&
+              (Dialect::kAllowTrailingCommas || frame.index == 0)) {
+            if (!handler->EndArray()) {
+              return reject();
+            }
+            current++;
+            stack.pop_back();
+            add_value();
+            continue;
+          }
+          invalid_type_message = "Invalid type in array";
+          break;
+        }
+        case internal::kArrayDelimiter: {
+          if (*current == ',') {
+            current++;
+            frame.state = internal::kArrayElement;
+          } else if (*current == ']') {
+            if (!handler->EndArray()) {
+              return reject();
+            }
+            current++;
+            stack.pop_back();
+            add_value();
+          } else {
+            return fail(ErrorType::kSyntaxError,
+                        "Invalid format in array: missed comma");
+          }
+          continue;
+        }
+        case internal::kObjectKey: {
+          if (*current == '}' &&
+              (Dialect::kAllowTrailingCommas || frame.index == 0)) {
+            if (!handler->EndObject()) {
+              return reject();
+            }
+            current++;
+            stack.pop_back();
+            add_value();
+            continue;
+          }
+          if (!Dialect::kAllowUnquotedKeys ||
+              !char_class::IsDigit(*current)) {
+            DecodedString key;
+            if (!parser::internal::DecodeKey<Dialect>(
+                    current, end, &current_length, &key, &message)) {
+              return fail(ErrorType::kSyntaxError, message);
+            }
+            if (!handler->Key(key)) {
+              return reject();
+            }
+          } else {
+            double key;
+            if (!parser::internal::ParseNumberValue<Dialect>(
+                    current, end, &current_length, &key, &message)) {
+              return fail(ErrorType::kSyntaxError, message);
+            }
+            if (!handler->NumericKey(key)) {
+              return reject();
+            }
+          }
+          frame.state = internal::kObjectColon;
+          current += current_length;
+          continue;
+        }
+        case internal::kObjectColon: {
+          if (*current != ':') {
+            return fail(ErrorType::kSyntaxError, "Unexpected token");
+          }
+          current++;
+          frame.state = internal::kObjectValue;
+          continue;
+        }
+        case internal::kObjectValue: {
+          if (*current == ',') {
+            return fail(ErrorType::kSyntaxError, "Value is missing in object");
+          }
+          invalid_type_message = "Invalid type in object";
+          break;
+        }
+        case internal::kObjectDelimiter: {
+          if (*current == ',') {
+            current++;
+            frame.state = internal::kObjectKey;
+          } else if (*current == '}') {
+            if (!handler->EndObject()) {
+              return reject();
+            }
+            current++;
+            stack.pop_back();
+            add_value();
+          } else {
+            return fail(ErrorType::kSyntaxError, "Invalid format in object");
+          }
+          continue;
+        }
+      }
+    }
+
+    // A value is expected at this point.
+    if (!parser::GetType<Dialect>(current, end, &current_type)) {
+      return fail(ErrorType::kTypeError, invalid_type_message);
+    }
+
+    if (current_type == parser::kArray || current_type == parser::kObject) {
+      if (stack.size() >= max_depth) {
+        return fail(ErrorType::kRangeError, "Maximum nesting depth exceeded");
+      }
+      Frame frame;
+      frame.index = 0;
+      if (current_type == parser::kArray) {
+        frame.state = internal::kArrayElement;
+        if (!handler->StartArray()) {
+          return reject();
+        }
+      } else {
+        frame.state = internal::kObjectKey;
+        if (!handler->StartObject()) {
+          return reject();
+        }
+      }
+      stack.push_back(frame);
+      current++;
+      continue;
+    }
+
+    bool is_accepted;
+    switch (current_type) {
+      case parser::kUndefined: {
+        if (*current == ',' || *current == ']') {
+          current_length = 0;
+        } else if (*current == 'u') {
+          current_length = 9;
+        } else {
+          return fail(ErrorType::kTypeError,
+                      "Invalid format of undefined value");
+        }
+        if (current + current_length > end) {
+          return fail(ErrorType::kSyntaxError, "Unexpected end of data");
+        }
+        is_accepted = handler->Undefined();
+        break;
+      }
+      case parser::kNull: {
+        current_length = 4;
+        if (current + current_length > end) {
+          return fail(ErrorType::kSyntaxError, "Unexpected end of data");
+        }
+        is_accepted = handler->Null();
+        break;
+      }
+      case parser::kBool: {
+        if (current + 4 <= end && std::strncmp(current, "true", 4) == 0) {
+          current_length = 4;
+          is_accepted = handler->Bool(true);
+        } else if (current + 5 <= end &&
+                   std::strncmp(current, "false", 5) == 0) {
+          current_length = 5;
+          is_accepted = handler->Bool(false);
+        } else {
+          return fail(ErrorType::kTypeError,
+                      "Invalid format: expected boolean");
+        }
+        break;
+      }
+      case parser::kNumber: {
+        double number;
+        if (!parser::internal::ParseNumberValue<Dialect>(
+                current, end, &current_length, &number, &message)) {
+          return fail(ErrorType::kSyntaxError, message);
+        }
+        if (current + current_length > end) {
+          return fail(ErrorType::kSyntaxError, "Unexpected end of data");
+        }
+        is_accepted = handler->Number(number);
+        break;
+      }
+      case parser::kString: {
+        DecodedString string;
+        if (!parser::internal::DecodeString<Dialect>(
+                current, end, &current_length, &string, &message)) {
+          return fail(ErrorType::kSyntaxError, message);
+        }
+        is_accepted = handler->String(string);
+        break;
+      }
+      default: {
+        return fail(ErrorType::kTypeError, invalid_type_message);
+      }
+    }
+    if (!is_accepted) {
+      return reject();
+    }
+    current += current_length;
+    add_value();
+  }
+
+  current += parser::internal::SkipToNextToken<Dialect>(current, end);
+  if (current != end) {
+    return fail(ErrorType::kSyntaxError, "Invalid format");
+  }
+  return true;
+}
+
+}  // namespace value_scanner
+
+}  // namespace mdsf
+
+#endif  // SRC_VALUE_SCANNER_H_
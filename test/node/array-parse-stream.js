@@ -0,0 +1,151 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const jsParser = require('../../lib/serde-fallback');
+const ArrayParseStream = require('../../lib/array-parse-stream');
+
+const validArrays = [
+  '[]',
+  '  [ ]  ',
+  '[1,2,3]',
+  "[1,'a,b]',{a:[1,{b:'}'}]},[[]],null,undefined,true]",
+  '[1,,2,]',
+  '[,]',
+  '/* comment */ [1, // comment\n 2 /* ] */] // trailing comment',
+  "['\\'',\"\\\"\",'\\u{1F600}','тест']",
+];
+
+const invalidArrays = [
+  '{a:1}',
+  '[1 2]',
+  '[1,2',
+  '[1}',
+  '[1] 2',
+  '[{a:}]',
+  '[nul,1]',
+  '[tru]',
+];
+
+// Literals and numbers split between chunks.
+const splitChunks = [
+  '[tr',
+  'ue, nu',
+  'll, 12',
+  '34, 1.',
+  '5e',
+  '3, fal',
+  'se]',
+];
+
+// Data ending inside a literal or a number.
+const truncatedArrays = [
+  '[1, nul',
+  '[1, tru',
+  '[fals',
+  '[1, undefin',
+  '[1, 12',
+];
+
+const collectChunks = (stream, chunks, callback) => {
+  const elements = [];
+  stream.on('data', element => elements.push(element));
+  stream.on('error', error => callback(error, elements));
+  stream.on('end', () => callback(null, elements));
+
+  chunks.forEach(chunk => stream.write(chunk));
+  stream.end();
+};
+
+const collect = (stream, data, chunkSize, callback) => {
+  const buffer = Buffer.from(data);
+  const chunks = [];
+  for (let i = 0; i < buffer.length; i += chunkSize) {
+    chunks.push(buffer.slice(i, i + chunkSize));
+  }
+  collectChunks(stream, chunks, callback);
+};
+
+const runTests = (parserName, createStream) => {
+  validArrays.forEach(data => {
+    [1, 3, data.length].forEach(chunkSize => {
+      const name =
+        `must emit elements of ${data} in chunks of ${chunkSize} ` +
+        `using ${parserName} parser`;
+      test(name, test => {
+        collect(createStream(), data, chunkSize, (error, elements) => {
+          test.error(error);
+          const expected = mdsf
+            .parse(data)
+            .map((value, index) => ({ index, value }));
+          test.strictSame(elements, expected);
+          test.end();
+        });
+      });
+    });
+  });
+
+  test(`must parse split elements using ${parserName} parser`, test => {
+    const long = 'x'.repeat(1000) + "\\'" + 'ї'.repeat(1000);
+    const data = `[{a:'${long}',b:[1,2,3]}, 'y', 42 /* ] */]`;
+    collect(createStream(), data, 7, (error, elements) => {
+      test.error(error);
+      test.strictSame(elements, [
+        { index: 0, value: { a: long.replace('\\', ''), b: [1, 2, 3] } },
+        { index: 1, value: 'y' },
+        { index: 2, value: 42 },
+      ]);
+      test.end();
+    });
+  });
+
+  test(`must reject invalid UTF-8 using ${parserName} parser`, test => {
+    const stream = createStream();
+    stream.on('data', () => {});
+    stream.on('error', error => {
+      test.type(error, SyntaxError);
+      test.end();
+    });
+    stream.write(Buffer.from([0x5b, 0x27, 0xd1]));
+    stream.end(Buffer.from([0x27, 0x5d]));
+  });
+
+  invalidArrays.forEach(data => {
+    test(`must not allow ${data} using ${parserName} parser`, test => {
+      collect(createStream(), data, 1, error => {
+        test.type(error, Error);
+        test.end();
+      });
+    });
+  });
+
+  test(`must parse split literals using ${parserName} parser`, test => {
+    collectChunks(createStream(), splitChunks, (error, elements) => {
+      test.error(error);
+      test.strictSame(
+        elements.map(element => element.value),
+        [true, null, 1234, 1500, false]
+      );
+      test.end();
+    });
+  });
+
+  truncatedArrays.forEach(data => {
+    [1, data.length].forEach(chunkSize => {
+      const name =
+        `must reject ${data} in chunks of ${chunkSize} ` +
+        `using ${parserName} parser`;
+      test(name, test => {
+        collect(createStream(), data, chunkSize, error => {
+          test.type(error, SyntaxError);
+          test.match(error && error.message, /^Unexpected end of data/);
+          test.end();
+        });
+      });
+    });
+  });
+};
+
+runTests('native', () => mdsf.createArrayParseStream());
+runTests('js', () => new ArrayParseStream(jsParser.ArrayStreamParser));
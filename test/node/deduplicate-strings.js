@@ -0,0 +1,63 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const jsParser = require('../../lib/serde-fallback');
+
+const options = { deduplicateStrings: true };
+
+const STATUSES = ['active', 'blocked', "it's", 'café', 'tab\t', ''];
+
+const records = [];
+for (let i = 0; i < 5000; i++) {
+  records.push({
+    id: i,
+    status: STATUSES[i % STATUSES.length],
+    country: i % 2 ? 'UA' : 'US',
+    note: 'a long note that is not going to be deduplicated ' + (i % 3),
+  });
+}
+
+const runTests = (parserName, parser) => {
+  test(`must deduplicate string values using ${parserName} parser`, test => {
+    const data = parser.stringify(records);
+    parser.resetStats();
+    test.strictSame(parser.parse(data, options), records);
+    test.strictSame(parser.parse(Buffer.from(data), options), records);
+    test.strictSame(parser.parse('["a", \'a\', "a"]', options), [
+      'a',
+      'a',
+      'a',
+    ]);
+
+    const stats = parser.getStats();
+    if (stats !== null) {
+      // Only the notes, which are too long, and the first occurrences of
+      // the other values are created from scratch.
+      test.ok(stats.deduplicatedStrings > stats.strings);
+    }
+    test.end();
+  });
+
+  test(`must deduplicate in message streams using ${parserName} parser`, t => {
+    const stream = new parser.MessageStream(options);
+    const messages = [];
+    const data = parser.stringifyJSTPMessages(records.slice(0, 100));
+    for (let i = 0; i < data.length; i += 100) {
+      stream.parse(data.slice(i, i + 100), messages);
+    }
+    t.strictSame(messages, records.slice(0, 100));
+    t.end();
+  });
+
+  test(`must report errors when deduplicating using ${parserName}`, t => {
+    const json = { dialect: 'json', deduplicateStrings: true };
+    t.throws(() => parser.parse('["\\x", "\\x"]', json));
+    t.throws(() => parser.parse('["a", "a"', options));
+    t.end();
+  });
+};
+
+runTests('native', mdsf);
+runTests('js', jsParser);
@@ -0,0 +1,89 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const jsParser = require('../../lib/serde-fallback');
+
+const json = { dialect: 'json' };
+
+const validJson = [
+  '{"a":1,"b":[true,false,null],"c":"str\\n\\u00e9\\/"}',
+  ' [ -0.5e10 , 0 , 123456789012 , 1E-3 ] ',
+  '" "',
+  '[]',
+  '{}',
+  '-0',
+  '1e999',
+];
+
+const invalidJson = [
+  "'single quotes'",
+  '{a:1}',
+  '{1:1}',
+  '[1,]',
+  '{"a":1,}',
+  '[,1]',
+  '[undefined]',
+  'NaN',
+  '-Infinity',
+  '0x10',
+  '+1',
+  '.5',
+  '1.',
+  '01',
+  '"\\x41"',
+  '"\\u{41}"',
+  '"\\v"',
+  '[1 /* comment */]',
+  '\u00a01',
+  '"a\tb"',
+  '"\u0001"',
+  '["\u001f"]',
+  '{"a\u0000":1}',
+];
+
+const runTests = (parserName, parser) => {
+  test(`must parse strict JSON using ${parserName} parser`, test => {
+    validJson.forEach(str => {
+      test.strictSame(parser.parse(str, json), JSON.parse(str), str);
+      test.strictSame(parser.parse(Buffer.from(str), json), JSON.parse(str));
+    });
+    test.end();
+  });
+
+  test(`must reject non-JSON syntax using ${parserName} parser`, test => {
+    invalidJson.forEach(str => {
+      test.throws(() => parser.parse(str, json), Error, str);
+    });
+    test.end();
+  });
+
+  test(`must use MDSF dialect by default using ${parserName} parser`, test => {
+    test.strictSame(parser.parse("{a:'b',}"), { a: 'b' });
+    test.strictSame(parser.parse("{a:'b',}", { dialect: 'mdsf' }), { a: 'b' });
+    test.strictSame(parser.parse("'a\tb\u0001'"), 'a\tb\u0001');
+    test.end();
+  });
+
+  test(`must not allow unknown dialects using ${parserName} parser`, test => {
+    test.throws(() => parser.parse('1', { dialect: 'json5' }), TypeError);
+    test.throws(() => parser.parse('1', { dialect: 1 }), TypeError);
+    test.end();
+  });
+
+  test(`must parse streams as MDSF only using ${parserName} parser`, test => {
+    const json = { dialect: 'json' };
+    test.throws(
+      () => parser.parseJSTPMessages('{}\0', [], undefined, undefined, json),
+      TypeError
+    );
+    test.throws(() => new parser.MessageStream(json), TypeError);
+    test.throws(() => new parser.ArrayStreamParser(json), TypeError);
+    test.doesNotThrow(() => new parser.MessageStream({ dialect: 'mdsf' }));
+    test.end();
+  });
+};
+
+runTests('native', mdsf);
+runTests('js', jsParser);
@@ -0,0 +1,63 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const jsParser = require('../../lib/serde-fallback');
+
+const messages = [
+  { call: [1, 'auth'], newSession: ['user', 'password'] },
+  { callback: [1], ok: ['session'] },
+  { call: [2, 'chat'], send: [{ to: 'all', text: 'hi' }] },
+  { call: [3, 'chat'], send: [{ to: 'user', skipped: undefined }] },
+  { 'not-identifier': { call: { call: 1 } }, '': 'empty' },
+];
+
+const runTests = (parserName, parser) => {
+  test(`must compress keys using ${parserName} parser`, test => {
+    const dictionary = new parser.KeyDictionary();
+    const stringify = batch => parser.stringifyJSTPMessages(batch, dictionary);
+    const first = stringify(messages.slice(0, 2));
+    const second = stringify(messages.slice(2));
+    test.equal(
+      first.toString(),
+      "{call:[1,'auth'],newSession:['user','password']}\0" +
+        "{callback:[1],ok:['session']}\0"
+    );
+    const uncompressed = parser.stringifyJSTPMessages(messages.slice(2));
+    test.ok(second.length < uncompressed.length);
+
+    const stream = new parser.MessageStream({ keyDictionary: true });
+    const result = [];
+    stream.parse(first, result);
+    stream.parse(second, result);
+    test.strictSame(result, JSON.parse(JSON.stringify(messages)));
+    test.end();
+  });
+
+  test(`must resolve split references using ${parserName} parser`, test => {
+    const dictionary = new parser.KeyDictionary();
+    const data = Buffer.concat([
+      parser.stringifyJSTPMessages(messages, dictionary),
+      parser.stringifyJSTPMessages(messages, dictionary),
+    ]);
+    const stream = new parser.MessageStream({ keyDictionary: true });
+    const result = [];
+    for (let i = 0; i < data.length; i += 3) {
+      stream.parse(data.slice(i, i + 3), result);
+    }
+    const expected = JSON.parse(JSON.stringify(messages));
+    test.strictSame(result, expected.concat(expected));
+    test.end();
+  });
+
+  test(`must reject unknown references using ${parserName} parser`, test => {
+    const stream = new parser.MessageStream({ keyDictionary: true });
+    test.throws(() => stream.parse('{a:1}\0{#1:2}\0', []));
+    test.throws(() => new parser.MessageStream().parse('{#0:1}\0', []));
+    test.end();
+  });
+};
+
+runTests('native', mdsf);
+runTests('js', jsParser);
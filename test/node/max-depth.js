@@ -0,0 +1,85 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const jsParser = require('../../lib/serde-fallback');
+const ArrayParseStream = require('../../lib/array-parse-stream');
+
+const nestedArray = depth => '['.repeat(depth) + ']'.repeat(depth);
+const nestedObject = depth => '{a:'.repeat(depth) + '1' + '}'.repeat(depth);
+
+const runTests = (parserName, parser, createArrayParseStream) => {
+  test(`must not overflow the stack using ${parserName} parser`, test => {
+    test.throws(() => parser.parse(nestedArray(1e6)), RangeError);
+    test.throws(() => parser.parse(nestedObject(1e5)), RangeError);
+    test.end();
+  });
+
+  test(`must allow nesting up to maxDepth using ${parserName} parser`, test => {
+    test.strictSame(parser.parse('[[1]]', { maxDepth: 2 }), [[1]]);
+    test.strictSame(parser.parse('{a:[]}', { maxDepth: 2 }), { a: [] });
+    test.strictSame(parser.parse('1', { maxDepth: 1 }), 1);
+    test.end();
+  });
+
+  test(`must not allow exceeding maxDepth using ${parserName} parser`, test => {
+    test.throws(() => parser.parse('[[[1]]]', { maxDepth: 2 }), RangeError);
+    test.throws(() => parser.parse('{a:{b:{}}}', { maxDepth: 2 }), RangeError);
+    test.end();
+  });
+
+  test(`must limit depth of JSTP messages using ${parserName} parser`, test => {
+    const options = { maxDepth: 2 };
+    const parse = (data, messages, errors) =>
+      parser.parseJSTPMessages(data, messages, undefined, errors, options);
+
+    const messages = [];
+    parse('{a:[1]}\0', messages);
+    test.strictSame(messages, [{ a: [1] }]);
+    test.throws(() => parse('{a:[[1]]}\0', []), RangeError);
+
+    const errors = [];
+    const valid = [];
+    parse('{a:[[1]]}\0{b:1}\0', valid, errors);
+    test.strictSame(valid, [{ b: 1 }]);
+    test.equal(errors.length, 1);
+    test.equal(errors[0].index, 0);
+
+    const stream = new parser.MessageStream(options);
+    const streamed = [];
+    stream.parse('{a:[1]}\0', streamed);
+    test.strictSame(streamed, [{ a: [1] }]);
+    test.throws(() => stream.parse('{a:[[1]]}\0', []), RangeError);
+    test.end();
+  });
+
+  test(`must limit depth of array streams using ${parserName} parser`, test => {
+    const elements = [];
+    const valid = createArrayParseStream({ maxDepth: 2 });
+    valid.on('data', element => elements.push(element.value));
+    valid.on('end', () => {
+      test.strictSame(elements, [[1], { a: 1 }]);
+
+      const invalid = createArrayParseStream({ maxDepth: 2 });
+      invalid.on('data', () => {});
+      invalid.once('error', error => {
+        test.type(error, RangeError);
+        test.end();
+      });
+      invalid.end('[[1], [[[1]]]]');
+    });
+    valid.end('[[1], {a:1}]');
+  });
+
+  test(`must not allow invalid maxDepth using ${parserName} parser`, test => {
+    test.throws(() => parser.parse('[]', { maxDepth: 0 }), TypeError);
+    test.throws(() => parser.parse('[]', { maxDepth: 1.5 }), TypeError);
+    test.end();
+  });
+};
+
+runTests('native', mdsf, mdsf.createArrayParseStream);
+runTests('js', jsParser, options =>
+  new ArrayParseStream(jsParser.ArrayStreamParser, options)
+);
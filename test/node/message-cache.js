@@ -0,0 +1,133 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const jsParser = require('../../lib/serde-fallback');
+
+const heartbeat = "{heartbeat:[0],payload:{list:[1,'a']}}";
+const call = "{call:[1,'auth'],newSession:['user','password']}";
+
+const runTests = (parserName, parser) => {
+  test(`must return cached messages using ${parserName} parser`, test => {
+    const cache = new parser.MessageCache();
+    const messages = [];
+    const data = `${heartbeat}\0${call}\0${heartbeat}\0{hea`;
+    const remainder = parser.parseJSTPMessages(data, messages, cache);
+    test.equal(remainder, '{hea');
+    test.strictSame(messages, [
+      { heartbeat: [0], payload: { list: [1, 'a'] } },
+      { call: [1, 'auth'], newSession: ['user', 'password'] },
+      { heartbeat: [0], payload: { list: [1, 'a'] } },
+    ]);
+    test.equal(messages[0], messages[2]);
+    test.ok(Object.isFrozen(messages[0]));
+    test.ok(Object.isFrozen(messages[0].payload.list));
+
+    const more = [];
+    parser.parseJSTPMessages(`${call}\0`, more, cache);
+    test.equal(more[0], messages[1]);
+    test.strictSame(cache.getStats(), {
+      hits: 2,
+      misses: 2,
+      evictions: 0,
+      updates: 0,
+      entries: 2,
+      // Both messages consist of seven values.
+      size: heartbeat.length + call.length + 2 * 64 + 14 * 32,
+      maxSize: 1024 * 1024,
+    });
+
+    cache.clear();
+    const parsedAgain = [];
+    parser.parseJSTPMessages(`${call}\0`, parsedAgain, cache);
+    test.notEqual(parsedAgain[0], messages[1]);
+    test.equal(cache.getStats().misses, 3);
+    test.end();
+  });
+
+  test(`must evict least recently used using ${parserName} parser`, t => {
+    const cache = new parser.MessageCache({ maxSize: 4096 });
+    const message = i => `{index:${100 + i}}`;
+    for (let i = 0; i < 30; i++) {
+      parser.parseJSTPMessages(`${message(i)}\0${message(0)}\0`, [], cache);
+    }
+    const stats = cache.getStats();
+    t.ok(stats.size <= 4096);
+    t.equal(stats.evictions, 30 - stats.entries);
+
+    // The first message has been used recently and must not be evicted
+    // unlike the second one.
+    parser.parseJSTPMessages(`${message(0)}\0${message(1)}\0`, [], cache);
+    t.equal(cache.getStats().hits, stats.hits + 1);
+    t.equal(cache.getStats().misses, stats.misses + 1);
+    t.end();
+  });
+
+  test(`must not cache large messages using ${parserName} parser`, t => {
+    const cache = new parser.MessageCache({ maxSize: 1024 });
+    const messages = [];
+    parser.parseJSTPMessages(`${call}\0${call}\0`, messages, cache);
+    t.notOk(Object.isFrozen(messages[0]));
+    t.equal(cache.getStats().entries, 0);
+    t.end();
+  });
+
+  test(`must account for parsed values using ${parserName} parser`, t => {
+    const cache = new parser.MessageCache({ maxSize: 4096 });
+    const short = '{a:[0,0]}';
+    const long = '{a:[0,0,0,0,0,0,0,0,0,0]}';
+    const messages = [];
+    parser.parseJSTPMessages(`${short}\0${long}\0`, messages, cache);
+    t.ok(Object.isFrozen(messages[0]));
+    t.notOk(Object.isFrozen(messages[1]));
+    t.strictSame(cache.getStats(), {
+      hits: 0,
+      misses: 2,
+      evictions: 0,
+      updates: 0,
+      entries: 1,
+      size: short.length + 64 + 4 * 32,
+      maxSize: 4096,
+    });
+    t.end();
+  });
+
+  test(`must not cache typed arrays using ${parserName} parser`, t => {
+    const cache = new parser.MessageCache();
+    const messages = [];
+    parser.parseJSTPMessages('{a:[1,2]}\0', messages, cache, [], {
+      typedArrays: true,
+    });
+    t.ok(messages[0].a instanceof Int32Array);
+    t.equal(cache.getStats().entries, 0);
+    t.end();
+  });
+
+  test(`must validate cache arguments using ${parserName} parser`, t => {
+    t.throws(() => new parser.MessageCache({ maxSize: -1 }));
+    t.throws(() => new parser.MessageCache(10));
+    t.throws(() => parser.parseJSTPMessages('{}\0', [], {}));
+    t.end();
+  });
+};
+
+test('must count replaced entries as updates using js parser', t => {
+  const cache = new jsParser.MessageCache({ maxSize: 4096 });
+  cache.insert(heartbeat, { heartbeat: [0] });
+  cache.insert(heartbeat, { heartbeat: [0], payload: {} });
+  t.strictSame(cache.getStats(), {
+    hits: 0,
+    misses: 0,
+    evictions: 0,
+    updates: 1,
+    entries: 1,
+    size: heartbeat.length + 64 + 4 * 32,
+    maxSize: 4096,
+  });
+  t.strictSame(cache.lookup(heartbeat), { heartbeat: [0], payload: {} });
+  t.end();
+});
+
+runTests('native', mdsf);
+runTests('js', jsParser);
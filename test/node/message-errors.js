@@ -0,0 +1,54 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const jsParser = require('../../lib/serde-fallback');
+
+const runTests = (parserName, parser) => {
+  test(`must skip invalid messages using ${parserName} parser`, test => {
+    const messages = [];
+    const errors = [];
+    const data = "{a:1}\0{b:'значення',}\0[1]\0{c:}\0 {d:[2]} \0{e:1} x\0{f:";
+    const remainder = parser.parseJSTPMessages(
+      data,
+      messages,
+      undefined,
+      errors
+    );
+    test.equal(remainder, '{f:');
+    test.strictSame(messages, [{ a: 1 }, { b: 'значення' }, { d: [2] }]);
+    test.equal(errors.length, 3);
+    test.strictSame(
+      errors.map(error => [error.index, error.begin, error.end]),
+      [[2, 30, 33], [3, 34, 38], [5, 49, 56]]
+    );
+    for (const error of errors) {
+      test.type(error.reason, 'string');
+      test.ok(error.reason.length > 0);
+    }
+    test.end();
+  });
+
+  test(`must keep cached messages using ${parserName} parser`, test => {
+    const cache = new parser.MessageCache();
+    const messages = [];
+    const errors = [];
+    parser.parseJSTPMessages('{a:1}\0{a:\0{a:1}\0', messages, cache, errors);
+    test.strictSame(messages, [{ a: 1 }, { a: 1 }]);
+    test.strictSame(errors.map(error => error.index), [1]);
+    test.equal(cache.getStats().hits, 1);
+    test.end();
+  });
+
+  test(`must throw without errors array using ${parserName} parser`, test => {
+    test.throws(() => parser.parseJSTPMessages('{a:1}\0{a:\0', []));
+    test.throws(() =>
+      parser.parseJSTPMessages('{a:1}\0', [], undefined, 'errors')
+    );
+    test.end();
+  });
+};
+
+runTests('native', mdsf);
+runTests('js', jsParser);
@@ -0,0 +1,54 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const jsParser = require('../../lib/serde-fallback');
+
+const messages = [
+  "{call:[1,'auth'],newSession:['user','password']}",
+  " /* comment */ {a:{b:[1,2,{c:'\\u{1F600} тест'}]},d:undefined} " +
+    '// comment\n',
+  "{'quoted key':-1.5e3,x:0x1f,y:true,nested:[[[]]],'':''}",
+  '{}',
+];
+
+const expected = messages.map(message => mdsf.parse(message));
+const data = Buffer.from(messages.join('\0') + '\0');
+
+const runTests = (parserName, parser) => {
+  [1, 2, 7, data.length].forEach(chunkSize => {
+    const name =
+      `must parse messages received in chunks of ${chunkSize} ` +
+      `using ${parserName} parser`;
+    test(name, test => {
+      const stream = new parser.MessageStream();
+      const result = [];
+      for (let i = 0; i < data.length; i += chunkSize) {
+        stream.parse(data.slice(i, i + chunkSize), result);
+      }
+      test.strictSame(result, expected);
+      test.end();
+    });
+  });
+
+  test(`must not allow invalid messages using ${parserName} parser`, test => {
+    const stream = new parser.MessageStream();
+    test.throws(() => stream.parse('[1]\0', []));
+    test.throws(() => stream.parse('{a:1} 2\0', []));
+    test.throws(() => stream.parse('{a:\0', []));
+    test.end();
+  });
+
+  test(`must respect maxDepth option using ${parserName} parser`, test => {
+    const stream = new parser.MessageStream({ maxDepth: 2 });
+    const result = [];
+    stream.parse('{a:{}}\0', result);
+    test.strictSame(result, [{ a: {} }]);
+    test.throws(() => stream.parse('{a:{b:{}}}\0', result), RangeError);
+    test.end();
+  });
+};
+
+runTests('native', mdsf);
+runTests('js', jsParser);
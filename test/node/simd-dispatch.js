@@ -0,0 +1,104 @@
+'use strict';
+
+const test = require('tap').test;
+
+const childProcess = require('child_process');
+const path = require('path');
+
+const [error] = require('../../lib/common').safeRequire(
+  '../build/Release/mdsf'
+);
+
+const LEVELS = ['scalar', 'sse2', 'avx2', 'avx512'];
+
+// The kernels are selected once when the addon is loaded, so every level is
+// tested in a child process. The inputs are long enough for the widest
+// registers and have the interesting bytes at every offset within them.
+const script = `
+  const mdsf = require(${JSON.stringify(path.join(__dirname, '../..'))});
+  const results = [];
+  const sequences = [
+    [0xd1, 0x91],
+    [0xe2, 0x82, 0xac],
+    [0xf0, 0x9f, 0x98, 0x80],
+    [0xc0, 0xaf],
+    [0xed, 0xa0, 0x80],
+    [0xf4, 0x90, 0x80, 0x80],
+    [0xe2, 0x82],
+    [0x80],
+  ];
+  const run = fn => {
+    try {
+      results.push(fn());
+    } catch (error) {
+      results.push(error.name + ': ' + error.message);
+    }
+  };
+  for (let i = 0; i < 70; i++) {
+    const padding = ' \\t\\r\\n'.repeat(i).slice(0, i * 3);
+    const text = 'a'.repeat(i);
+    run(() => mdsf.parse(padding + '[' + padding + '1' + padding + ']'));
+    run(() => mdsf.parse(JSON.stringify([text + '"' + text, text + 'ё'])));
+    run(() => mdsf.parse('"' + text + '\\n"'));
+    run(() => mdsf.parse('[' + '1234567890'.repeat(3).slice(0, i % 25 + 1) +
+                         ', -' + '9'.repeat(i % 20 + 1) + '.5e3]'));
+    // Raw bytes are validated as UTF-8 with the ASCII runs skipped by the
+    // kernels, the sequences end up at every offset within the registers.
+    for (const sequence of sequences) {
+      run(() =>
+        mdsf.parse(
+          Buffer.concat([
+            Buffer.from('"' + 'a'.repeat(64 + i)),
+            Buffer.from(sequence),
+            Buffer.from('b'.repeat(100) + '"'),
+          ])
+        )
+      );
+    }
+  }
+  console.log(JSON.stringify({ level: mdsf.getSimdLevel(), results }));
+`;
+
+const runWithLevel = level => {
+  const env = Object.assign({}, process.env, { MDSF_SIMD_LEVEL: level });
+  const child = childProcess.spawnSync(process.execPath, ['-e', script], {
+    env,
+    encoding: 'utf8',
+  });
+  return JSON.parse(child.stdout);
+};
+
+test('must produce the same results with the kernels of every level', test => {
+  if (error) {
+    test.pass('native addon is not built');
+    test.end();
+    return;
+  }
+  const scalar = runWithLevel('scalar');
+  test.equal(scalar.level, 'scalar');
+  test.strictSame(scalar.results[0], [1]);
+  test.ok(scalar.results.includes('a'.repeat(64) + '\u20ac' + 'b'.repeat(100)));
+  test.ok(
+    scalar.results.includes(
+      'SyntaxError: Invalid UTF-8 sequence at position 66'
+    )
+  );
+  for (const level of LEVELS.slice(1)) {
+    const result = runWithLevel(level);
+    // Levels the CPU doesn't support are lowered to the supported ones.
+    test.ok(LEVELS.indexOf(result.level) <= LEVELS.indexOf(level));
+    test.strictSame(result.results, scalar.results, level);
+  }
+  test.end();
+});
+
+test('must select a supported level by default', test => {
+  if (error) {
+    test.pass('native addon is not built');
+    test.end();
+    return;
+  }
+  test.ok(LEVELS.includes(require('../..').getSimdLevel()));
+  test.ok(LEVELS.includes(runWithLevel('unknown').level));
+  test.end();
+});
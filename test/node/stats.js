@@ -0,0 +1,48 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const jsParser = require('../../lib/serde-fallback');
+
+// The CI job building the addon with MDSF_ENABLE_STATS must not skip the
+// native tests.
+const statsEnabled = !!process.env.MDSF_ENABLE_STATS;
+
+const runTests = (parserName, parser, statsRequired) => {
+  test(`must provide parser stats using ${parserName} parser`, test => {
+    parser.resetStats();
+    const stats = parser.getStats();
+    if (stats === null) {
+      if (statsRequired) {
+        test.fail('stats must be enabled by MDSF_ENABLE_STATS');
+      } else {
+        test.pass('stats are not enabled in this build');
+      }
+      test.end();
+      return;
+    }
+    test.equal(stats.bytesParsed, 0);
+    test.equal(stats.messagesParsed, 0);
+
+    const messages = [];
+    parser.parseJSTPMessages("{a:[1,2.5,'x\\n']}\0{b:'y'}\0", messages);
+    const updated = parser.getStats();
+    test.equal(updated.messagesParsed, 2);
+    test.equal(updated.objects, 2);
+    test.equal(updated.arrays, 1);
+    test.equal(updated.strings, 2);
+    test.equal(updated.escapedStrings, 1);
+    test.equal(updated.fastNumbers + updated.slowNumbers, 2);
+    test.ok(updated.bytesParsed > 0);
+    const timings = updated.parseTime.reduce((sum, b) => sum + b.count, 0);
+    test.equal(timings, 1);
+
+    parser.resetStats();
+    test.equal(parser.getStats().messagesParsed, 0);
+    test.end();
+  });
+};
+
+runTests('native', mdsf, statsEnabled);
+runTests('js', jsParser, false);
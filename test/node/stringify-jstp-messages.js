@@ -0,0 +1,42 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const jsParser = require('../../lib/serde-fallback');
+
+const messages = [
+  { call: [1, 'auth'], newSession: ['user', 'password'] },
+  { callback: [1], ok: [Float64Array.of(0.5, 1)] },
+  { event: [-1, 'chat'], message: ["it's \u0000 here"] },
+];
+
+const runTests = (parserName, parser) => {
+  test(`must stringify JSTP messages using ${parserName} parser`, test => {
+    const buffer = parser.stringifyJSTPMessages(messages);
+    test.ok(Buffer.isBuffer(buffer));
+    test.equal(
+      buffer.toString(),
+      messages.map(message => parser.stringify(message) + '\0').join('')
+    );
+
+    const result = [];
+    const remainder = parser.parseJSTPMessages(buffer.toString(), result);
+    test.equal(remainder, '');
+    test.strictSame(result, [
+      messages[0],
+      { callback: [1], ok: [[0.5, 1]] },
+      messages[2],
+    ]);
+    test.end();
+  });
+
+  test(`must stringify an empty batch using ${parserName} parser`, test => {
+    test.equal(parser.stringifyJSTPMessages([]).length, 0);
+    test.throws(() => parser.stringifyJSTPMessages('message'), TypeError);
+    test.end();
+  });
+};
+
+runTests('native', mdsf);
+runTests('js', jsParser);
@@ -0,0 +1,98 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const jsParser = require('../../lib/serde-fallback');
+
+const DOUBLES = [
+  0,
+  -0,
+  1,
+  -1,
+  0.1,
+  0.3,
+  1 / 3,
+  -2.5,
+  123456.789,
+  1e21,
+  1e-6,
+  1e-7,
+  1.5e300,
+  -2.2250738585072014e-308,
+  5e-324,
+  Number.MAX_VALUE,
+  Number.MAX_SAFE_INTEGER,
+  Number.MAX_SAFE_INTEGER + 3,
+  2147483647,
+  -2147483648,
+  4294967296,
+  123456789012345680000,
+  NaN,
+  Infinity,
+  -Infinity,
+];
+
+const toLiteral = array => '[' + Array.from(array, x => x + '').join(',') + ']';
+
+const runTests = (parserName, parser) => {
+  test(`must stringify arrays of numbers using ${parserName} parser`, test => {
+    test.equal(parser.stringify(DOUBLES), toLiteral(DOUBLES));
+    test.equal(parser.stringifyNumbers(DOUBLES), toLiteral(DOUBLES));
+    test.equal(parser.stringify([1, 'a']), "[1,'a']");
+    test.equal(parser.stringify([1, , 2]), '[1,,2]');
+    test.equal(parser.stringifyNumbers([1, 'a']), undefined);
+    test.equal(parser.stringifyNumbers([1, , 2]), undefined);
+    test.equal(parser.stringify({ a: [1.5, 2] }), '{a:[1.5,2]}');
+    test.end();
+  });
+
+  test(`must stringify typed arrays using ${parserName} parser`, test => {
+    const types = [
+      Int8Array,
+      Uint8Array,
+      Uint8ClampedArray,
+      Int16Array,
+      Uint16Array,
+      Int32Array,
+      Uint32Array,
+      Float32Array,
+      Float64Array,
+    ];
+    types.forEach(Type => {
+      const array = Type.from([0, 1, 127, -128, 255, -1, 65535, 1e9, 0.1]);
+      test.equal(parser.stringify(array), toLiteral(array), Type.name);
+    });
+    test.equal(
+      parser.stringify(Float64Array.from(DOUBLES)),
+      toLiteral(DOUBLES)
+    );
+    test.equal(parser.stringify(new Int32Array(0)), '[]');
+    test.equal(
+      parser.stringify(new Int16Array(new ArrayBuffer(8), 2, 2).fill(-7)),
+      '[-7,-7]'
+    );
+    test.end();
+  });
+
+  test(`must roundtrip random doubles using ${parserName} parser`, test => {
+    const array = new Float64Array(10000);
+    const bytes = new Uint8Array(array.buffer);
+    for (let i = 0; i < bytes.length; i++) {
+      bytes[i] = Math.floor(Math.random() * 256);
+    }
+    for (let i = 0; i < array.length; i += 2) {
+      array[i] = (Math.random() - 0.5) * Math.pow(10, (i % 40) - 20);
+    }
+    test.equal(parser.stringify(array), toLiteral(array));
+    test.end();
+  });
+
+  test(`must format typed arrays with space using ${parserName} parser`, t => {
+    t.equal(parser.stringify(Int8Array.of(1, 2), null, 1), '[\n 1,\n 2\n]');
+    t.end();
+  });
+};
+
+runTests('native', mdsf);
+runTests('js', jsParser);
@@ -0,0 +1,107 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const stringify = require('../../lib/stringify');
+const StringifyStream = require('../../lib/stringify-stream');
+
+const numbers = [];
+for (let i = 0; i < 10000; i++) numbers.push(i * 1.5 - 100);
+
+const values = [
+  null,
+  undefined,
+  () => {},
+  42,
+  'строка',
+  [],
+  {},
+  [1, , undefined, null, () => {}, 'a'],
+  { a: 1, 'b-c': [{ d: undefined }, [[]]], e: undefined, f: () => {} },
+  { toJSON: () => [1, 2] },
+  [new Date(0), new Number(1), new String('s'), Buffer.from('buf')],
+  numbers,
+  numbers.concat(['mixed'], numbers),
+  new Float64Array(numbers),
+  new Int8Array([1, -2, 3]),
+  'x'.repeat(100000),
+  { text: 'ё'.repeat(50000), list: numbers.map(n => ({ n })) },
+];
+
+const collect = (stream, callback) => {
+  const chunks = [];
+  stream.on('data', chunk => chunks.push(chunk));
+  stream.on('error', callback);
+  stream.on('end', () => callback(null, chunks));
+};
+
+const runTests = (implName, stringifyStream, stringify) => {
+  values.forEach((value, index) => {
+    const args = [
+      [value],
+      [value, null, 2],
+      [value, ['a', 'b-c', 'text'], '\t'],
+      [value, (key, value) => (key === 'a' ? undefined : value)],
+    ];
+    args.forEach(args => {
+      test(`must stringify value ${index} with ${args.length} arguments ` +
+           `as a stream using ${implName} implementation`, test => {
+        const stream = stringifyStream(args[0], args[1], args[2], {
+          highWaterMark: 1000,
+        });
+        collect(stream, (error, chunks) => {
+          test.error(error);
+          for (const chunk of chunks) {
+            test.ok(Buffer.isBuffer(chunk));
+            test.ok(chunk.length <= 1000);
+          }
+          test.equal(
+            Buffer.concat(chunks).toString(),
+            stringify(...args)
+          );
+          test.end();
+        });
+      });
+    });
+  });
+
+  test(`must yield between chunks using ${implName} implementation`, test => {
+    let ticks = 0;
+    let timer = null;
+    const tick = () => {
+      ticks++;
+      timer = setImmediate(tick);
+    };
+    tick();
+    const stream = stringifyStream(numbers, null, null, { highWaterMark: 100 });
+    collect(stream, (error, chunks) => {
+      clearImmediate(timer);
+      test.error(error);
+      test.ok(chunks.length > 100);
+      test.ok(ticks >= chunks.length / 2);
+      test.end();
+    });
+  });
+
+  test(`must emit replacer errors using ${implName} implementation`, test => {
+    const stream = stringifyStream([1, 2], () => {
+      throw new Error('replacer');
+    });
+    collect(stream, error => {
+      test.equal(error && error.message, 'replacer');
+      test.end();
+    });
+  });
+};
+
+runTests('native', mdsf.stringifyStream, mdsf.stringify);
+runTests(
+  'js',
+  (value, replacer, space, options) =>
+    new StringifyStream(
+      stringify.stringifyParts(value, replacer, space),
+      options
+    ),
+  stringify
+);
@@ -0,0 +1,71 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const jsParser = require('../../lib/serde-fallback');
+
+const toLiteral = string => {
+  const content = JSON.stringify(string).slice(1, -1);
+  return `'${content.replace(/'/g, "\\'")}'`;
+};
+
+const PIECES = [
+  'abc',
+  "'",
+  '"',
+  '\\',
+  '\b\f\n\r\t',
+  '\x00',
+  '\x1f',
+  '\x7f',
+  '\xe9',
+  '\u2028',
+  'текст',
+  '😀',
+  '\ud800',
+  '\udc00',
+  'x'.repeat(40),
+];
+
+const randomString = () => {
+  let result = '';
+  const count = Math.floor(Math.random() * 12);
+  for (let i = 0; i < count; i++) {
+    result += PIECES[Math.floor(Math.random() * PIECES.length)];
+  }
+  return result;
+};
+
+const runTests = (parserName, parser) => {
+  test(`must escape strings using ${parserName} parser`, test => {
+    PIECES.forEach(piece => {
+      test.equal(parser.stringifyString(piece), toLiteral(piece));
+    });
+    test.equal(parser.stringifyString(''), "''");
+    test.equal(parser.stringify("it's"), "'it\\'s'");
+    test.equal(parser.stringify({ 'a-b': '"' }), "{'a-b':'\\\"'}");
+    test.end();
+  });
+
+  test(`must escape random strings using ${parserName} parser`, test => {
+    for (let i = 0; i < 1000; i++) {
+      const string = randomString();
+      test.equal(parser.stringify(string), toLiteral(string));
+    }
+    test.end();
+  });
+
+  test(`must roundtrip escaped strings using ${parserName} parser`, test => {
+    // Line terminators are not escaped, the same as by JSON.stringify(),
+    // but aren't allowed unescaped in MDSF strings.
+    const string = PIECES.filter(piece => piece !== '\u2028')
+      .join('')
+      .repeat(100);
+    test.equal(parser.parse(parser.stringify(string)), string);
+    test.end();
+  });
+};
+
+runTests('native', mdsf);
+runTests('js', jsParser);
@@ -0,0 +1,81 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+
+const [error] = require('../../lib/common').safeRequire(
+  '../build/Release/mdsf'
+);
+
+// Large inputs are indexed in parallel, so the elements below end up on the
+// boundaries of the blocks in every possible state.
+const elements = [
+  "{key: 'value', /* comment */ 'quoted key': \"it's\" }",
+  "['/* not a comment */', '// nor this', \"\\\"\", '\\\\']",
+  '// line comment with "quotes\' and */\n[1, 2.5, -3]',
+  "/* multi-line\r\n * comment */ { 'ключ': 'значення'　}",
+  "['\\\\\\'', \"*/\", '//', 'line\\\ncontinuation']// ",
+  '\r\n\t ﻿  { nested: [[{}, []], { a: null, b: undefined }] }',
+];
+
+const createDocument = size => {
+  const parts = [];
+  let length = 0;
+  for (let i = 0; length < size; i++) {
+    const element = elements[i % elements.length];
+    parts.push(element);
+    length += Buffer.byteLength(element) + 1;
+  }
+  return '[' + parts.join(',') + ']';
+};
+
+const parseWithThreads = (threads, data) => {
+  const previous = process.env.MDSF_PARSE_THREADS;
+  process.env.MDSF_PARSE_THREADS = threads;
+  try {
+    return mdsf.parse(data);
+  } finally {
+    if (previous === undefined) {
+      delete process.env.MDSF_PARSE_THREADS;
+    } else {
+      process.env.MDSF_PARSE_THREADS = previous;
+    }
+  }
+};
+
+// The parallel indexing is only done by the native parser, the sequential
+// one is used as the reference.
+test('must parse large documents the same way in parallel', test => {
+  if (error) {
+    test.pass('native addon is not built');
+    test.end();
+    return;
+  }
+  const document = createDocument(9 * 1024 * 1024);
+  const expected = parseWithThreads('1', document);
+  test.strictSame(expected[2], [1, 2.5, -3]);
+  test.strictSame(parseWithThreads('3', document), expected);
+  test.strictSame(parseWithThreads('7', Buffer.from(document)), expected);
+  // The number of threads is limited.
+  test.strictSame(parseWithThreads('100000', document), expected);
+  test.end();
+});
+
+test('must report errors in large documents in parallel', test => {
+  if (error) {
+    test.pass('native addon is not built');
+    test.end();
+    return;
+  }
+  const document = createDocument(9 * 1024 * 1024);
+  const unterminated = [
+    document.slice(0, -1) + ",'string]",
+    document.slice(0, -1) + ',/* comment]',
+    document.slice(0, -1) + ',[// comment',
+  ];
+  for (const data of unterminated) {
+    test.throws(() => parseWithThreads('4', data));
+  }
+  test.end();
+});
@@ -0,0 +1,125 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const jsParser = require('../../lib/serde-fallback');
+
+const [error] = require('../../lib/common').safeRequire(
+  '../build/Release/mdsf'
+);
+
+// Data whose JSON must be the same as JSON.stringify(parse(data)) produces.
+const sameAsStringify = [
+  "{a:1,/* comment */b:'x\\n\"',c:[true,false,null]}",
+  " // comment\n { 'quoted key': \"it's\", nested: [[{}, []], { a: {} }] } ",
+  "['\\x41\\u00e9\\u{1F600}\\uD83D\\uDE00', '\\t\\b\\f\\r\\v\\0\\u0001']",
+  "{ 'ключ': 'значення', emoji: '😀', 'a\\u2028b': '\\u007f' }",
+  '[0, -0, 1.5, -2e-7, 1e21, 123456789012345680000, 0x1F, 0o17, 0b101]',
+  '[1,,3,]',
+  '[undefined, null]',
+  '{a:undefined,b:1,c:undefined}',
+  "'top-level string'",
+  '42',
+];
+
+const runTests = (parserName, parser) => {
+  test(`must convert MDSF to JSON using ${parserName} parser`, test => {
+    sameAsStringify.forEach(str => {
+      const expected = JSON.stringify(parser.parse(str));
+      const actual = parser.toJSON(str);
+      test.ok(Buffer.isBuffer(actual), str);
+      test.equal(actual.toString(), expected);
+      test.equal(parser.toJSON(Buffer.from(str)).toString(), actual.toString());
+    });
+    test.end();
+  });
+
+  test(`must keep keys in order using ${parserName} parser`, test => {
+    test.equal(
+      parser.toJSON("{b:1,a:2,'1':3,'0':4,b:5}").toString(),
+      '{"b":1,"a":2,"1":3,"0":4,"b":5}'
+    );
+    test.end();
+  });
+
+  test(`must apply undefined policy using ${parserName} parser`, test => {
+    const data = '{a:undefined,b:[undefined,,1]}';
+    test.equal(
+      parser.toJSON(data, { undefined: 'omit' }).toString(),
+      '{"b":[null,null,1]}'
+    );
+    test.equal(
+      parser.toJSON(data, { undefined: 'null' }).toString(),
+      '{"a":null,"b":[null,null,1]}'
+    );
+    test.throws(() => parser.toJSON(data, { undefined: 'error' }), TypeError);
+    test.throws(() => parser.toJSON('[1,,2]', { undefined: 'error' }));
+    test.equal(
+      parser.toJSON('[1,2]', { undefined: 'error' }).toString(),
+      '[1,2]'
+    );
+    test.end();
+  });
+
+  test(`must reject top-level undefined using ${parserName} parser`, test => {
+    // JSON.stringify() returns undefined rather than JSON for it.
+    test.equal(JSON.stringify(parser.parse('undefined')), undefined);
+    test.throws(() => parser.toJSON('undefined'), TypeError);
+    test.throws(() => parser.toJSON(' /* x */ undefined '), TypeError);
+    test.throws(() => parser.toJSON('undefined', { undefined: 'error' }));
+    test.equal(
+      parser.toJSON('undefined', { undefined: 'null' }).toString(),
+      'null'
+    );
+    test.end();
+  });
+
+  test(`must support JSON dialect using ${parserName} parser`, test => {
+    const json = { dialect: 'json' };
+    test.equal(
+      parser.toJSON(' {"b": [1e2, "\\u00e9"], "a": {}} ', json).toString(),
+      '{"b":[100,"é"],"a":{}}'
+    );
+    test.throws(() => parser.toJSON('{a:1}', json), SyntaxError);
+    test.end();
+  });
+
+  test(`must reject invalid data using ${parserName} parser`, test => {
+    test.throws(() => parser.toJSON('{a:'), SyntaxError);
+    test.throws(() => parser.toJSON('[1] 2'), SyntaxError);
+    test.throws(() => parser.toJSON('[[[1]]]', { maxDepth: 2 }), RangeError);
+    test.throws(
+      () => parser.toJSON(Buffer.from([0x27, 0xff, 0x27])),
+      SyntaxError
+    );
+    test.end();
+  });
+
+  test(`must reject invalid options using ${parserName} parser`, test => {
+    test.throws(() => parser.toJSON('1', { undefined: 'skip' }), TypeError);
+    test.throws(() => parser.toJSON('1', { nonFinite: 0 }), TypeError);
+    test.throws(() => parser.toJSON('1', { maxDepth: 0 }), TypeError);
+    test.end();
+  });
+};
+
+runTests('native', mdsf);
+runTests('js', jsParser);
+
+test('must apply non-finite number policy', test => {
+  if (error) {
+    test.pass('native addon is not built');
+    test.end();
+    return;
+  }
+  const data = '[NaN,Infinity,-Infinity,1]';
+  test.equal(mdsf.toJSON(data).toString(), '[null,null,null,1]');
+  test.equal(
+    mdsf.toJSON(data, { nonFinite: 'string' }).toString(),
+    '["NaN","Infinity","-Infinity",1]'
+  );
+  test.throws(() => mdsf.toJSON(data, { nonFinite: 'error' }), TypeError);
+  test.equal(mdsf.toJSON('{1:2,0:3}').toString(), '{"1":2,"0":3}');
+  test.end();
+});
@@ -0,0 +1,75 @@
+'use strict';
+
+const test = require('tap').test;
+
+const childProcess = require('child_process');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const [error] = require('../../lib/common').safeRequire(
+  '../build/Release/mdsf'
+);
+
+// Spans are only compiled in when the addon is built for Node.js 14.6.0 or
+// later, see src/tracing.h.
+const [major, minor] = process.versions.node.split('.').map(Number);
+const isTracingCompiledIn = major > 14 || (major === 14 && minor >= 6);
+
+const script = `
+  const mdsf = require(${JSON.stringify(path.join(__dirname, '../..'))});
+  mdsf.parse('{a:1}');
+  mdsf.parseJSTPMessages('{a:1}\\0{b:2}\\0', []);
+`;
+
+test('must emit trace events using native parser', test => {
+  if (error) {
+    test.pass('native addon is not built');
+    test.end();
+    return;
+  }
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'mdsf-trace-'));
+  const file = path.join(dir, 'trace.log');
+  const result = childProcess.spawnSync(process.execPath, [
+    '--trace-event-categories',
+    'mdsf',
+    '--trace-event-file-pattern',
+    file,
+    '-e',
+    script,
+  ]);
+  test.equal(result.status, 0);
+
+  if (!fs.existsSync(file)) {
+    fs.rmdirSync(dir);
+    test.pass('trace events are not supported by this Node.js version');
+    test.end();
+    return;
+  }
+  const events = JSON.parse(fs.readFileSync(file, 'utf8')).traceEvents.filter(
+    event => event.cat === 'mdsf'
+  );
+  fs.unlinkSync(file);
+  fs.rmdirSync(dir);
+
+  if (!isTracingCompiledIn) {
+    test.equal(events.length, 0, 'tracing is compiled out');
+    test.end();
+    return;
+  }
+
+  const end = name =>
+    events.find(event => event.name === name && event.ph === 'E');
+  const args = name => {
+    const event = end(name);
+    test.ok(event, `${name} has ended`);
+    return event && event.args;
+  };
+  test.strictSame(args('mdsf.parse'), { inputSize: 5 });
+  test.strictSame(args('mdsf.parseJSTPMessages'), {
+    inputSize: 12,
+    messageCount: 2,
+  });
+  test.ok(end('mdsf.parse.materialize'));
+  test.end();
+});
@@ -0,0 +1,52 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const jsParser = require('../../lib/serde-fallback');
+
+const options = { typedArrays: true };
+
+const runTests = (parserName, parser) => {
+  test(`must return typed arrays using ${parserName} parser`, test => {
+    test.strictSame(
+      parser.parse('[1, 2, -3]', options),
+      Int32Array.of(1, 2, -3)
+    );
+    test.strictSame(
+      parser.parse('[2147483647, -2147483648]', options),
+      Int32Array.of(2147483647, -2147483648)
+    );
+    test.strictSame(parser.parse('[1, 2.5]', options), Float64Array.of(1, 2.5));
+    test.strictSame(
+      parser.parse('[2147483648]', options),
+      Float64Array.of(2147483648)
+    );
+    test.strictSame(parser.parse('[-0]', options), Float64Array.of(-0));
+    test.strictSame(parser.parse('{a:[[1], [1.5]]}', options), {
+      a: [Int32Array.of(1), Float64Array.of(1.5)],
+    });
+    test.end();
+  });
+
+  test(`must keep other arrays as is using ${parserName} parser`, test => {
+    test.strictSame(parser.parse('[]', options), []);
+    test.strictSame(parser.parse("[1, 'a', 2]", options), [1, 'a', 2]);
+    test.strictSame(parser.parse('[1, , 2]', options), [1, undefined, 2]);
+    test.strictSame(parser.parse('[1, [2]]', options), [1, Int32Array.of(2)]);
+    test.strictSame(parser.parse('[1, 2]'), [1, 2]);
+    test.end();
+  });
+
+  test(`must return typed arrays in messages using ${parserName}`, test => {
+    const stream = new parser.MessageStream(options);
+    const messages = [];
+    stream.parse('{a:[1,2', messages);
+    stream.parse(',3.5]}\0', messages);
+    test.strictSame(messages, [{ a: Float64Array.of(1, 2, 3.5) }]);
+    test.end();
+  });
+};
+
+runTests('native', mdsf);
+runTests('js', jsParser);
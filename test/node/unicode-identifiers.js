@@ -0,0 +1,103 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+
+const [error] = require('../../lib/common').safeRequire(
+  '../build/Release/mdsf'
+);
+
+// Code points around the boundaries of 256-code-point blocks of the
+// identifier tables, chosen so that their properties are the same in all
+// Unicode versions since 11.0. Blocks of CJK ideographs are all set and are
+// shared by several index entries and by both tables, as is the empty block.
+const idStart = [
+  0x0100, // first in a block
+  0x01ff, // last in a block
+  0x0400,
+  0x04ff,
+  0x0e01,
+  0x4e00, // after the block of U+4DFF
+  0x7fff, // shared full block
+  0x8000,
+  0x10000, // non-BMP
+  0x1d400,
+  0x20000,
+  0x200ff,
+  0x20100,
+  0x2f800,
+];
+
+const idPartOnly = [0x0300, 0x036f, 0xe0100, 0xe01ef];
+
+const notId = [
+  0x02ff,
+  0x0e00,
+  0x4dff,
+  0xe000, // shared empty block
+  0xf8ff,
+  0xffff,
+  0x100ff,
+  0x10100,
+  0x1d3ff,
+  0x1ffff,
+  0x2a6ff,
+  0xe00ff,
+  0xe01f0,
+  0x10ffff,
+];
+
+const hex = cp => `U+${cp.toString(16).toUpperCase()}`;
+
+const isAccepted = str => {
+  let result;
+  try {
+    result = mdsf.parse(str);
+  } catch (error) {
+    return false;
+  }
+  return mdsf.parse(Buffer.from(str))[Object.keys(result)[0]] === 1;
+};
+
+test('must accept identifier start characters', test => {
+  if (error) {
+    test.pass('native addon is not built');
+    test.end();
+    return;
+  }
+  idStart.forEach(cp => {
+    const char = String.fromCodePoint(cp);
+    test.ok(isAccepted(`{${char}:1}`), `${hex(cp)} at the start`);
+    test.ok(isAccepted(`{a${char}:1}`), `${hex(cp)} inside`);
+  });
+  test.end();
+});
+
+test('must accept identifier part characters inside only', test => {
+  if (error) {
+    test.pass('native addon is not built');
+    test.end();
+    return;
+  }
+  idPartOnly.forEach(cp => {
+    const char = String.fromCodePoint(cp);
+    test.notOk(isAccepted(`{${char}:1}`), `${hex(cp)} at the start`);
+    test.ok(isAccepted(`{a${char}:1}`), `${hex(cp)} inside`);
+  });
+  test.end();
+});
+
+test('must not accept other characters in identifiers', test => {
+  if (error) {
+    test.pass('native addon is not built');
+    test.end();
+    return;
+  }
+  notId.forEach(cp => {
+    const char = String.fromCodePoint(cp);
+    test.notOk(isAccepted(`{${char}:1}`), `${hex(cp)} at the start`);
+    test.notOk(isAccepted(`{a${char}:1}`), `${hex(cp)} inside`);
+  });
+  test.end();
+});
@@ -0,0 +1,86 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const jsParser = require('../../lib/serde-fallback');
+
+const strings = [
+  [
+    'plain ASCII string that is longer than sixteen bytes',
+    'plain ASCII string that is longer than sixteen bytes',
+  ],
+  ['мова, яка не є ASCII', 'мова, яка не є ASCII'],
+  ['mixed é and 中文 and 😀 emoji', 'mixed é and 中文 and 😀 emoji'],
+  [
+    'escapes \\n \\t \\u00e9 \\x41 \\u{1F600} in the middle',
+    'escapes \n \t \u00e9 \x41 \u{1F600} in the middle',
+  ],
+  [
+    'a'.repeat(100) + '\\n' + 'b'.repeat(100),
+    'a'.repeat(100) + '\n' + 'b'.repeat(100),
+  ],
+];
+
+const invalidSequences = [
+  [0x27, 0xff, 0x27],
+  [0x27, 0xc0, 0xaf, 0x27],
+  [0x27, 0xed, 0xa0, 0x80, 0x27],
+  [0x27, 0xf4, 0x90, 0x80, 0x80, 0x27],
+  [0x27, 0x61, 0x62, 0xe2, 0x82],
+];
+
+const runTests = (parserName, parser) => {
+  test(`must parse strings correctly using ${parserName} parser`, test => {
+    strings.forEach(([str, expected]) => {
+      test.strictSame(parser.parse(`'${str}'`), expected);
+      test.strictSame(parser.parse(Buffer.from(`'${str}'`)), expected);
+      test.strictSame(parser.parse(`{key:"${str}"}`), { key: expected });
+    });
+    test.end();
+  });
+
+  test(`must reject invalid UTF-8 using ${parserName} parser`, test => {
+    invalidSequences.forEach(bytes => {
+      test.throws(() => parser.parse(Buffer.from(bytes)), SyntaxError);
+    });
+    test.end();
+  });
+
+  test(`must decode split chunks using ${parserName} parser`, test => {
+    const stream = new parser.MessageStream();
+    const messages = [];
+    const data = Buffer.from("{a:'ключ 😀'}\0{'ключ':1}\0");
+    for (let i = 0; i < data.length; i++) {
+      stream.parse(data.slice(i, i + 1), messages);
+    }
+    test.strictSame(messages, [{ a: 'ключ 😀' }, { ключ: 1 }]);
+    test.end();
+  });
+
+  test(`must reject invalid chunks using ${parserName} parser`, test => {
+    const messages = [];
+    const stream = new parser.MessageStream();
+    const data = [0x7b, 0x61, 0x3a, 0x27, 0xff, 0xfe, 0x27, 0x7d, 0];
+    test.throws(
+      () => stream.parse(Buffer.from(data), messages),
+      new SyntaxError('Invalid UTF-8 sequence at position 4')
+    );
+
+    const split = new parser.MessageStream();
+    split.parse(Buffer.from("{a:1}\0{b:'"), messages);
+    split.parse(Buffer.from([0xe2, 0x82]), messages);
+    test.throws(
+      () => split.parse(Buffer.from([0x41]), messages),
+      new SyntaxError('Invalid UTF-8 sequence at position 10')
+    );
+    test.strictSame(messages, [{ a: 1 }]);
+
+    split.parse(Buffer.from('{c:1}\0'), messages);
+    test.strictSame(messages, [{ a: 1 }, { c: 1 }]);
+    test.end();
+  });
+};
+
+runTests('native', mdsf);
+runTests('js', jsParser);
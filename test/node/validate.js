@@ -0,0 +1,98 @@
+'use strict';
+
+const test = require('tap').test;
+
+const mdsf = require('../..');
+const jsParser = require('../../lib/serde-fallback');
+
+const validData = [
+  [
+    "{a:[1,,'x'],/* comment */b:{c:null},'ключ':'значення'}",
+    { depth: 2, values: 8, arrays: 1, objects: 2, keys: 4, numbers: 1 },
+  ],
+  ['42', { depth: 0, values: 1, arrays: 0, objects: 0, keys: 0, numbers: 1 }],
+  [
+    " // comment\n [[[]], {a:'b'}, undefined] ",
+    { depth: 3, values: 6, arrays: 3, objects: 1, keys: 1, strings: 1 },
+  ],
+];
+
+const invalidData = [
+  ['{a:', 'SyntaxError'],
+  ['[1] x', 'SyntaxError'],
+  ["{a:'b}", 'SyntaxError'],
+  ['[1,,', 'SyntaxError'],
+];
+
+const runTests = (parserName, parser) => {
+  test(`must validate well-formed data using ${parserName} parser`, test => {
+    validData.forEach(([str, expected]) => {
+      const result = parser.validate(str);
+      test.equal(result.valid, true, str);
+      test.equal(result.size, Buffer.byteLength(str));
+      Object.keys(expected).forEach(key => {
+        test.equal(result[key], expected[key], `${key} of ${str}`);
+      });
+      test.strictSame(parser.validate(Buffer.from(str)), result);
+    });
+    test.end();
+  });
+
+  test(`must report malformed data using ${parserName} parser`, test => {
+    invalidData.forEach(([str, type]) => {
+      const result = parser.validate(str);
+      test.equal(result.valid, false, str);
+      test.equal(result.type, type, str);
+      test.type(result.message, 'string');
+      test.type(result.offset, 'number');
+      test.ok(result.offset <= Buffer.byteLength(str));
+      test.strictSame(parser.validate(Buffer.from(str)), result);
+    });
+    test.equal(parser.validate('{a:').offset, 3);
+    test.equal(parser.validate("['ключ'] x").offset, 13);
+    test.end();
+  });
+
+  test(`must enforce limits using ${parserName} parser`, test => {
+    test.strictSame(parser.validate('[1,2,3]', { maxSize: 3 }), {
+      valid: false,
+      size: 7,
+      type: 'RangeError',
+      message: 'Maximum size exceeded',
+      offset: 3,
+    });
+    test.equal(parser.validate('[1,2,3]', { maxSize: 7 }).valid, true);
+
+    const nested = parser.validate('[[[1]]]', { maxDepth: 2 });
+    test.equal(nested.valid, false);
+    test.equal(nested.type, 'RangeError');
+    test.equal(parser.validate('[[[1]]]', { maxDepth: 3 }).depth, 3);
+
+    test.equal(parser.validate('{"a":[1]}', { dialect: 'json' }).valid, true);
+    test.equal(parser.validate('{a:[1]}', { dialect: 'json' }).valid, false);
+    test.end();
+  });
+
+  test(`must report invalid UTF-8 using ${parserName} parser`, test => {
+    test.strictSame(parser.validate(Buffer.from([0x27, 0x61, 0xff, 0x27])), {
+      valid: false,
+      size: 4,
+      type: 'SyntaxError',
+      message: 'Invalid UTF-8 sequence',
+      offset: 2,
+    });
+    test.end();
+  });
+
+  test(`must reject invalid limits using ${parserName} parser`, test => {
+    test.throws(() => parser.validate('1', { maxSize: -1 }), TypeError);
+    test.throws(() => parser.validate('1', { maxSize: 1.5 }), TypeError);
+    test.throws(() => parser.validate('1', { maxSize: '1' }), TypeError);
+    test.throws(() => parser.validate('1', { maxDepth: 0 }), TypeError);
+    test.throws(() => parser.validate('1', { dialect: 'json5' }), TypeError);
+    test.end();
+  });
+};
+
+runTests('native', mdsf);
+runTests('js', jsParser);
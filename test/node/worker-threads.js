@@ -0,0 +1,54 @@
+'use strict';
+
+const test = require('tap').test;
+
+const path = require('path');
+
+const [error] = require('../../lib/common').safeRequire(
+  '../build/Release/mdsf'
+);
+const [workerError, workerThreads] = require('../../lib/common').safeRequire(
+  'worker_threads'
+);
+
+const script = `
+  const { parentPort } = require('worker_threads');
+  const root = ${JSON.stringify(path.join(__dirname, '../..'))};
+  const [error] = require(root + '/lib/common').safeRequire(
+    root + '/build/Release/mdsf'
+  );
+  const mdsf = require(root);
+  const cache = new mdsf.MessageCache();
+  const messages = [];
+  mdsf.parseJSTPMessages('{a:1}\\0{a:1}\\0', messages, cache);
+  parentPort.postMessage({
+    error: error && error.message,
+    messages,
+    hits: cache.getStats().hits,
+  });
+`;
+
+const runWorker = () =>
+  new Promise((resolve, reject) => {
+    const worker = new workerThreads.Worker(script, { eval: true });
+    worker.on('message', resolve);
+    worker.on('error', reject);
+  });
+
+test('must load native addon in worker threads', test => {
+  if (error || workerError) {
+    test.pass('native addon is not built or worker threads are unsupported');
+    test.end();
+    return;
+  }
+  Promise.all([runWorker(), runWorker()]).then(results => {
+    for (const result of results) {
+      test.strictSame(result, {
+        error: null,
+        messages: [{ a: 1 }, { a: 1 }],
+        hits: 1,
+      });
+    }
+    test.end();
+  }, test.threw);
+});
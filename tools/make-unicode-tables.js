@@ -13,7 +13,8 @@ const UCD_LINK =
   UNICODE_VERSION +
   '/ucd/DerivedCoreProperties.txt';
 const tablesFilename = 'unicode_tables.h';
-const generateFullTables = !process.env['MDSF_USE_SHORT_UNICODE_TABLES'];
+const generateFullTables = !!process.env['MDSF_USE_FULL_UNICODE_TABLES'];
+const generateRangeTables = !!process.env['MDSF_USE_SHORT_UNICODE_TABLES'];
 const getHeaderGuard = filename =>
   `SRC_${filename.replace(/\W/g, '_').toUpperCase()}_`;
 const getOutputPath = filename => path.join(__dirname, '../src', filename);
@@ -84,6 +85,22 @@ typedef struct {
 
 `;
 
+const trieTablesHeader = `#include <cstdint>
+
+using std::uint8_t;
+using std::uint16_t;
+using std::uint32_t;
+
+`;
+
+// Each code point is looked up in a two-level trie: the high bits of the code
+// point select a block in the index table and the low bits select a bit in
+// that block. Blocks are shared between the ID_Start and ID_Continue tables,
+// so that each distinct block is stored only once.
+const trieBlockBits = 8;
+const trieBlockSize = 1 << trieBlockBits;
+const trieWordsPerBlock = trieBlockSize / 32;
+
 const idStartCategoryName = 'ID_Start';
 const idContinueCategoryName = 'ID_Continue';
 
@@ -137,6 +154,49 @@ function createFullTableArray(arrayName, array) {
   return str;
 }
 
+function createTrieTables(tables) {
+  const blocks = [];
+  const blockIndices = new Map();
+  const indexTables = tables.map(([arrayName, values]) => {
+    const index = [];
+    for (let start = 0; start <= highestUnicodeValue; start += trieBlockSize) {
+      const words = new Array(trieWordsPerBlock).fill(0);
+      for (let i = 0; i < trieBlockSize; i++) {
+        if (values[start + i]) {
+          words[i >>> 5] = (words[i >>> 5] | (1 << (i & 31))) >>> 0;
+        }
+      }
+      const key = words.join(',');
+      if (!blockIndices.has(key)) {
+        blockIndices.set(key, blocks.length);
+        blocks.push(words);
+      }
+      index.push(blockIndices.get(key));
+    }
+    return [arrayName, index];
+  });
+
+  const indexType = blocks.length <= 0x100 ? 'uint8_t' : 'uint16_t';
+
+  let str = `const unsigned ID_TRIE_BLOCK_BITS = ${trieBlockBits};\n\n`;
+  str += `const uint32_t ID_TRIE_BLOCKS[][${trieWordsPerBlock}] = {\n`;
+  blocks.forEach(words => {
+    const hexWords = words.map(word => `0x${word.toString(16)}`);
+    str += `  {${hexWords.join(', ')}},\n`;
+  });
+  str += '};\n\n';
+
+  indexTables.forEach(([arrayName, index]) => {
+    str += `const ${indexType} ${arrayName}[] = {`;
+    index.forEach((blockIndex, i) => {
+      str += i % 16 === 0 ? '\n  ' : ' ';
+      str += `${blockIndex},`;
+    });
+    str += '\n};\n\n';
+  });
+  return str;
+}
+
 function createArrayOfRanges(arrayName, array) {
   let str = `const unicode_range ${arrayName}[] = {\n  `;
   array.forEach((range, index) => {
@@ -162,7 +222,11 @@ function finish() {
 
   let tablesResult = getFileHeader(tablesFilename);
 
-  if (generateFullTables) {
+  if (generateRangeTables) {
+    tablesResult += rangeTablesHeader;
+    tablesResult += createArrayOfRanges('ID_START_RANGES', idStartRanges);
+    tablesResult += createArrayOfRanges('ID_CONTINUE_RANGES', idContinueRanges);
+  } else {
     idStartValues[0x24] = 1; // '$'
     idContinueValues[0x24] = 1;
 
@@ -172,12 +236,19 @@ function finish() {
     idContinueValues[0x200c] = 1; // ZWNJ
     idContinueValues[0x200d] = 1; // ZWJ
 
-    tablesResult += createFullTableArray('ID_START_FULL', idStartValues);
-    tablesResult += createFullTableArray('ID_CONTINUE_FULL', idContinueValues);
-  } else {
-    tablesResult += rangeTablesHeader;
-    tablesResult += createArrayOfRanges('ID_START_RANGES', idStartRanges);
-    tablesResult += createArrayOfRanges('ID_CONTINUE_RANGES', idContinueRanges);
+    if (generateFullTables) {
+      tablesResult += createFullTableArray('ID_START_FULL', idStartValues);
+      tablesResult += createFullTableArray(
+        'ID_CONTINUE_FULL',
+        idContinueValues
+      );
+    } else {
+      tablesResult += trieTablesHeader;
+      tablesResult += createTrieTables([
+        ['ID_START_TRIE_INDEX', idStartValues],
+        ['ID_CONTINUE_TRIE_INDEX', idContinueValues],
+      ]);
+    }
   }
 
   tablesResult += `#endif  // ${getHeaderGuard(tablesFilename)}\n`;